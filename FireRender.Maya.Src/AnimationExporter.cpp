@@ -15,17 +15,26 @@
 #include <maya/MPlugArray.h>
 #include <maya/MAnimControl.h>
 
+#include <algorithm>
+#include <cmath>
+
 const int COMPONENT_COUNT_ROTATION = 4;
 const int COMPONENT_COUNT_TRANSLATION = 3;
 const int COMPONENT_COUNT_SCALE = 3;
 
 const int INPUT_PLUG_COUNT = 3;
 
+const int ATTRIBUTE_COUNT = 3;
+const int TRANSLATION_INDEX = 0;
+const int ROTATION_INDEX = 1;
+const int SCALE_INDEX = 2;
+
 frw::RPRSContext g_exportContext;
 
 AnimationExporter::AnimationExporter(bool gltfExport) :
 	m_IsGLTFExport(gltfExport),
-	m_progressBars(nullptr)
+	m_progressBars(nullptr),
+	m_keyReductionTolerance(0.0f)
 {
 	if (m_IsGLTFExport)
 	{
@@ -94,6 +103,108 @@ MString AnimationExporter::GetGroupNameForDagPath(MDagPath dagPath, int pop)
 	}
 }
 
+void DecomposedTransformArrays::resize(size_t count)
+{
+	for (std::vector<float>* component : { &tx, &ty, &tz, &qx, &qy, &qz, &qw, &sx, &sy, &sz })
+	{
+		component->resize(count);
+	}
+}
+
+// Rows are orthogonalized the same way MTransformationMatrix separates shear from scale
+void DecomposeMatrices(const double* matrices, size_t count, DecomposedTransformArrays& out)
+{
+	const double epsilon = 1e-12;
+
+	out.resize(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const double* m = matrices + i * 16;
+
+		double x[3] = { m[0], m[1], m[2] };
+		double y[3] = { m[4], m[5], m[6] };
+		double z[3] = { m[8], m[9], m[10] };
+
+		double sx = std::sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+		double invSx = 1.0 / std::max(sx, epsilon);
+		x[0] *= invSx; x[1] *= invSx; x[2] *= invSx;
+
+		double xy = x[0] * y[0] + x[1] * y[1] + x[2] * y[2];
+		y[0] -= xy * x[0]; y[1] -= xy * x[1]; y[2] -= xy * x[2];
+
+		double sy = std::sqrt(y[0] * y[0] + y[1] * y[1] + y[2] * y[2]);
+		double invSy = 1.0 / std::max(sy, epsilon);
+		y[0] *= invSy; y[1] *= invSy; y[2] *= invSy;
+
+		double xz = x[0] * z[0] + x[1] * z[1] + x[2] * z[2];
+		double yz = y[0] * z[0] + y[1] * z[1] + y[2] * z[2];
+		z[0] -= xz * x[0] + yz * y[0]; z[1] -= xz * x[1] + yz * y[1]; z[2] -= xz * x[2] + yz * y[2];
+
+		double sz = std::sqrt(z[0] * z[0] + z[1] * z[1] + z[2] * z[2]);
+		double invSz = 1.0 / std::max(sz, epsilon);
+		z[0] *= invSz; z[1] *= invSz; z[2] *= invSz;
+
+		// mirrored transform: move the reflection into the scale
+		double det = x[0] * (y[1] * z[2] - y[2] * z[1]) - x[1] * (y[0] * z[2] - y[2] * z[0]) + x[2] * (y[0] * z[1] - y[1] * z[0]);
+		if (det < 0.0)
+		{
+			sx = -sx; sy = -sy; sz = -sz;
+			for (int k = 0; k < 3; ++k)
+			{
+				x[k] = -x[k]; y[k] = -y[k]; z[k] = -z[k];
+			}
+		}
+
+		// quaternion of the rotation matrix (row vectors)
+		double qx, qy, qz, qw;
+		double trace = x[0] + y[1] + z[2];
+		if (trace > 0.0)
+		{
+			double s = 0.5 / std::sqrt(trace + 1.0);
+			qw = 0.25 / s;
+			qx = (y[2] - z[1]) * s;
+			qy = (z[0] - x[2]) * s;
+			qz = (x[1] - y[0]) * s;
+		}
+		else if (x[0] > y[1] && x[0] > z[2])
+		{
+			double s = 2.0 * std::sqrt(1.0 + x[0] - y[1] - z[2]);
+			qw = (y[2] - z[1]) / s;
+			qx = 0.25 * s;
+			qy = (y[0] + x[1]) / s;
+			qz = (z[0] + x[2]) / s;
+		}
+		else if (y[1] > z[2])
+		{
+			double s = 2.0 * std::sqrt(1.0 + y[1] - x[0] - z[2]);
+			qw = (z[0] - x[2]) / s;
+			qx = (y[0] + x[1]) / s;
+			qy = 0.25 * s;
+			qz = (z[1] + y[2]) / s;
+		}
+		else
+		{
+			double s = 2.0 * std::sqrt(1.0 + z[2] - x[0] - y[1]);
+			qw = (x[1] - y[0]) / s;
+			qx = (z[0] + x[2]) / s;
+			qy = (z[1] + y[2]) / s;
+			qz = 0.25 * s;
+		}
+
+		out.tx[i] = (float)m[12];
+		out.ty[i] = (float)m[13];
+		out.tz[i] = (float)m[14];
+		out.qx[i] = (float)qx;
+		out.qy[i] = (float)qy;
+		out.qz[i] = (float)qz;
+		out.qw[i] = (float)qw;
+		out.sx[i] = (float)sx;
+		out.sy[i] = (float)sy;
+		out.sz[i] = (float)sz;
+	}
+}
+
 void FillArrayWithMMatrixData(std::array<float, 16>& arr, const MMatrix& matrix)
 {
 	for (int i = 0; i < 4; i++)
@@ -278,40 +389,22 @@ void AnimationExporter::SetTransformationForNode(MObject transform, const char*
 
 	MPlug matrixPlug = fnTransform.findPlug("matrix");
 
-	MMatrix newMatrix;
 	MObject val;
-
 	matrixPlug.getValue(val);
-	newMatrix = MFnMatrixData(val).matrix();
-	MTransformationMatrix transformMatrix(newMatrix);
+	MMatrix newMatrix = MFnMatrixData(val).matrix();
 
-	std::array<float, 10> arr;
+	DecomposedTransformArrays decomposed;
+	DecomposeMatrices(&newMatrix.matrix[0][0], 1, decomposed);
 
-	MVector vecTranslation = transformMatrix.getTranslation(MSpace::kTransform);
-
-	MQuaternion rotation = transformMatrix.rotation();
-
-	double scale[3];
-	transformMatrix.getScale(scale, MSpace::kTransform);
+	float coeff = GetSceneUnitsConversionCoefficient();
 
 	//cm to m
-	vecTranslation *= GetSceneUnitsConversionCoefficient();
-
-	int index = 0;
-	for (int i = 0; i < 3; i++)
+	std::array<float, 10> arr =
 	{
-		arr[index++] = (float)vecTranslation[i];
-	}
-
-	for (int i = 0; i < 4; i++)
-	{
-		arr[index++] = (float)rotation[i];
-	}
-
-	for (int i = 0; i < 3; i++)
-	{
-		arr[index++] = (float)scale[i];
-	}
+		decomposed.tx[0] * coeff, decomposed.ty[0] * coeff, decomposed.tz[0] * coeff,
+		decomposed.qx[0], decomposed.qy[0], decomposed.qz[0], decomposed.qw[0],
+		decomposed.sx[0], decomposed.sy[0], decomposed.sz[0]
+	};
 
 	m_pFunc_SetTransformGroup(groupName, arr.data());
 }
@@ -344,6 +437,8 @@ void AnimationExporter::AnimateGroups(AnimationDataHolderVector& dataHolder)
 		groupDagPathVector.push_back(dagPath);
 	}
 
+	BakedTransformVector bakedTransforms;
+
 	MDagPath dagPath;
 	for (size_t i = 0; i < groupDagPathVector.size(); ++i)
 	{
@@ -374,9 +469,21 @@ void AnimationExporter::AnimateGroups(AnimationDataHolderVector& dataHolder)
 			continue;
 		}
 
-		ApplyAnimationForTransform(dagPath, dataHolder);
+		BakedTransform bakedTransform;
+		bakedTransform.dagPath = dagPath;
 
-		ReportProgress((int)(100 * (i + 1) / groupDagPathVector.size()));
+		if (GatherTimeKeys(dagPath, bakedTransform.timeKeys))
+		{
+			bakedTransform.matrixPlug = MFnDependencyNode(transform).findPlug("matrix");
+			bakedTransforms.push_back(std::move(bakedTransform));
+		}
+	}
+
+	BakeTransforms(bakedTransforms);
+
+	for (const BakedTransform& bakedTransform : bakedTransforms)
+	{
+		ApplyAnimationForTransform(bakedTransform, dataHolder);
 	}
 }
 
@@ -407,18 +514,18 @@ int AnimationExporter::GetOutputComponentCount(int attrId)
 	}
 	else if (attrId == m_runtimeMoveTypeRotation)
 	{
-		return COMPONENT_COUNT_SCALE;
+		return COMPONENT_COUNT_ROTATION;
 	}
 	else if (attrId == m_runtimeMoveTypeScale)
 	{
-		return COMPONENT_COUNT_ROTATION;
+		return COMPONENT_COUNT_SCALE;
 	}
 
 	assert(false);
 	return 0;
 }
 
-void AnimationExporter::AddTimesFromCurve(const MFnAnimCurve& curve, TimeKeySet& outUniqueTimeKeySet, int attributeId)
+void AnimationExporter::AddTimesFromCurve(const MFnAnimCurve& curve, TimeKeyVector& outTimeKeys, int attributeIndex)
 {
 	int keyCount = curve.numKeys();
 
@@ -434,36 +541,28 @@ void AnimationExporter::AddTimesFromCurve(const MFnAnimCurve& curve, TimeKeySet&
 			continue;
 		}
 
-		AddOneTimePoint(time, curve, outUniqueTimeKeySet, attributeId, keyIndex);
+		AddOneTimePoint(time, curve, outTimeKeys, attributeIndex, keyIndex);
 	}
 
 	// Add auto point for the start and end animation point
-	AddOneTimePoint(startTime, curve, outUniqueTimeKeySet, attributeId, 0);
-	AddOneTimePoint(endTime, curve, outUniqueTimeKeySet, attributeId, keyCount - 1);
+	AddOneTimePoint(startTime, curve, outTimeKeys, attributeIndex, 0);
+	AddOneTimePoint(endTime, curve, outTimeKeys, attributeIndex, keyCount - 1);
 }
 
-void AnimationExporter::AddOneTimePoint(const MTime time, const MFnAnimCurve& curve, TimeKeySet& outUniqueTimeKeySet, int attributeId, int keyIndex)
+void AnimationExporter::AddOneTimePoint(const MTime time, const MFnAnimCurve& curve, TimeKeyVector& outTimeKeys, int attributeIndex, int keyIndex)
 {
-	TimeKeyStruct timeKey(time, attributeId);
-
-	TimeKeySet::iterator it = outUniqueTimeKeySet.find(timeKey);
-	if (it != outUniqueTimeKeySet.end())
-	{
-		it->AddNewAttribute(attributeId);
-	}
-	else
-	{
-		it = outUniqueTimeKeySet.insert(timeKey).first;
-	}
+	unsigned int attributeMask = 1u << attributeIndex;
 
 	// if we process rotation attribute we should as translation as well because in some complex rotations translation might be changed as well
-	if (attributeId == m_runtimeMoveTypeRotation)
+	if (attributeIndex == ROTATION_INDEX)
 	{
-		it->AddNewAttribute(m_runtimeMoveTypeTranslation);
+		attributeMask |= 1u << TRANSLATION_INDEX;
 	}
 
+	outTimeKeys.push_back({ time, attributeMask });
+
 	// keys autogeneration for rotation
-	if ((attributeId == m_runtimeMoveTypeRotation) && (keyIndex > 0))
+	if ((attributeIndex == ROTATION_INDEX) && (keyIndex > 0))
 	{
 		double maxValue = curve.value(keyIndex);
 		double minValue = curve.value(keyIndex - 1);
@@ -475,25 +574,13 @@ void AnimationExporter::AddOneTimePoint(const MTime time, const MFnAnimCurve& cu
 		while (currentValue < maxValue)
 		{
 			MTime additionalTimePoint = prevTime + (maxTime - prevTime) * (currentValue - minValue) / (maxValue - minValue);
-			outUniqueTimeKeySet.insert(TimeKeyStruct(additionalTimePoint, attributeId));
+			outTimeKeys.push_back({ additionalTimePoint, 1u << ROTATION_INDEX });
 
 			currentValue += step;
 		}
 	}
 }
 
-inline float AnimationExporter::GetValueForTime(const MPlug& plug, const MFnAnimCurve& curve, const MTime& time)
-{
-	if (!curve.object().isNull())
-	{
-		return (float)curve.evaluate(time);
-	}
-	else
-	{
-		return plug.asFloat();
-	}
-}
-
 void AnimationExporter::AddAnimationToGLTFRPR(AnimationDataHolderStruct& gltfDataHolderStruct, int attrId)
 {
 	size_t keyCount = gltfDataHolderStruct.m_timePoints.size();
@@ -541,18 +628,14 @@ void AnimationExporter::AddAnimationToRPRS(AnimationDataHolderStruct& dataHolder
 }
 
 
-void AnimationExporter::ApplyAnimationForTransform(const MDagPath& dagPath, AnimationDataHolderVector& dataHolder)
+bool AnimationExporter::GatherTimeKeys(const MDagPath& dagPath, TimeKeyVector& outTimeKeys)
 {
 	// do not change order
-	const int attrCount = 3;
-	int attrIds[attrCount] = { m_runtimeMoveTypeTranslation,
+	const int attrIds[ATTRIBUTE_COUNT] = { m_runtimeMoveTypeTranslation,
 								m_runtimeMoveTypeRotation,
 								m_runtimeMoveTypeScale };
 
-	MString groupName = GetGroupNameForDagPath(dagPath);
-
 	MFnDependencyNode depNodeTransform(dagPath.transform());
-	MFnTransform fnTransform(dagPath.transform());
 
 	const int inputPlugCount = INPUT_PLUG_COUNT; // it is always x, y, z as inputs
 
@@ -560,15 +643,11 @@ void AnimationExporter::ApplyAnimationForTransform(const MDagPath& dagPath, Anim
 
 	MFnAnimCurve tempCurve;
 
-	TimeKeySet uniqueTimeKeys;
-
-	// Gather Unique key points
+	// Gather key points of all curves
 	MString componentNames[inputPlugCount] = { "X", "Y", "Z" };
-	for (int attributeId : attrIds)
+	for (int attributeIndex = 0; attributeIndex < ATTRIBUTE_COUNT; ++attributeIndex)
 	{
-		MString attributeName = GetAttributeNameById(attributeId);
-
-		MPlugArray plugArray;
+		MString attributeName = GetAttributeNameById(attrIds[attributeIndex]);
 
 		for (int i = 0; i < inputPlugCount; ++i)
 		{
@@ -580,91 +659,169 @@ void AnimationExporter::ApplyAnimationForTransform(const MDagPath& dagPath, Anim
 				continue;
 			}
 
-			plugArray.append(plug);
 			MObjectArray curveObj;
 
 			if (MAnimUtil::findAnimation(plug, curveObj, &status))
 			{
 				tempCurve.setObject(curveObj[0]);
-				AddTimesFromCurve(tempCurve, uniqueTimeKeys, attributeId);
+				AddTimesFromCurve(tempCurve, outTimeKeys, attributeIndex);
 			}
 		}
 	}
 
-	MPlug matrixPlug = depNodeTransform.findPlug("matrix", &status);
+	// Merge keys with the same time
+	std::sort(outTimeKeys.begin(), outTimeKeys.end());
 
-	size_t keyCount = uniqueTimeKeys.size();
+	size_t uniqueCount = 0;
+	for (size_t i = 0; i < outTimeKeys.size(); ++i)
+	{
+		if (uniqueCount > 0 && outTimeKeys[uniqueCount - 1].time == outTimeKeys[i].time)
+		{
+			outTimeKeys[uniqueCount - 1].attributeMask |= outTimeKeys[i].attributeMask;
+		}
+		else
+		{
+			outTimeKeys[uniqueCount++] = outTimeKeys[i];
+		}
+	}
+	outTimeKeys.resize(uniqueCount);
 
-	// this is just for progress reporting
-	size_t dataChunkIndex = 0;
+	return !outTimeKeys.empty();
+}
 
-	// Export necessary attributes
-	for (int attributeId : attrIds)
+void AnimationExporter::BakeTransforms(BakedTransformVector& transforms)
+{
+	struct SampleRequest
 	{
-		dataHolder.emplace(dataHolder.end());
-		AnimationDataHolderStruct& dataHolderStruct = dataHolder.back();
+		MTime time;
+		unsigned int transformIndex;
+		unsigned int keyIndex;
+	};
 
-		for (TimeKeySet::iterator it = uniqueTimeKeys.begin(); it != uniqueTimeKeys.end(); it++)
+	std::vector<SampleRequest> requests;
+
+	for (size_t transformIndex = 0; transformIndex < transforms.size(); ++transformIndex)
+	{
+		BakedTransform& transform = transforms[transformIndex];
+		transform.matrices.resize(transform.timeKeys.size() * 16);
+
+		for (size_t keyIndex = 0; keyIndex < transform.timeKeys.size(); ++keyIndex)
 		{
-			dataChunkIndex++;
+			requests.push_back({ transform.timeKeys[keyIndex].time, (unsigned int)transformIndex, (unsigned int)keyIndex });
+		}
+	}
 
-			if (!it->DoesAttributeIdPresent(attributeId))
+	// Evaluate all transforms for one time in a row so DG evaluation at that time is shared
+	std::stable_sort(requests.begin(), requests.end(), [](const SampleRequest& a, const SampleRequest& b) { return a.time < b.time; });
+
+	size_t requestIndex = 0;
+	while (requestIndex < requests.size())
+	{
+		MTime time = requests[requestIndex].time;
+		MDGContext dgContext(time);
+
+		for (; requestIndex < requests.size() && requests[requestIndex].time == time; ++requestIndex)
+		{
+			const SampleRequest& request = requests[requestIndex];
+			BakedTransform& transform = transforms[request.transformIndex];
+
+			MObject val;
+			transform.matrixPlug.getValue(val, dgContext);
+			MMatrix matrix = MFnMatrixData(val).matrix();
+
+			std::copy(&matrix.matrix[0][0], &matrix.matrix[0][0] + 16, transform.matrices.begin() + request.keyIndex * 16);
+
+			if ((requestIndex + 1) % 100 == 0)
 			{
-				continue;
+				ReportDataChunk(requestIndex + 1, requests.size());
+				ReportProgress((int)(100 * (requestIndex + 1) / requests.size()));
 			}
+		}
 
-			MTime time = it->GetTime();
-			MDGContext dgContext(time);
+		if (m_progressBars != nullptr && m_progressBars->isCancelled())
+		{
+			throw ExportCancelledException();
+		}
+	}
+}
 
-			MMatrix newMatrix;
-			MObject val;
+void AnimationExporter::ApplyAnimationForTransform(const BakedTransform& transform, AnimationDataHolderVector& dataHolder)
+{
+	// do not change order
+	const int attrIds[ATTRIBUTE_COUNT] = { m_runtimeMoveTypeTranslation,
+								m_runtimeMoveTypeRotation,
+								m_runtimeMoveTypeScale };
 
-			matrixPlug.getValue(val, dgContext);
-			newMatrix = MFnMatrixData(val).matrix();
+	MString groupName = GetGroupNameForDagPath(transform.dagPath);
 
-			MTransformationMatrix transformMatrix(newMatrix);
+	size_t keyCount = transform.timeKeys.size();
 
-			dataHolderStruct.m_timePoints.push_back((float)it->GetTime().as(MTime::Unit::kSeconds));
+	DecomposedTransformArrays decomposed;
+	DecomposeMatrices(transform.matrices.data(), keyCount, decomposed);
 
-			if (attributeId == m_runtimeMoveTypeTranslation)
-			{
-				MVector vec1 = transformMatrix.getTranslation(MSpace::kTransform);
-				//cm to m
-				dataHolderStruct.m_values.push_back((float)vec1.x * GetSceneUnitsConversionCoefficient());
-				dataHolderStruct.m_values.push_back((float)vec1.y * GetSceneUnitsConversionCoefficient());
-				dataHolderStruct.m_values.push_back((float)vec1.z * GetSceneUnitsConversionCoefficient());
-			}
-			else if (attributeId == m_runtimeMoveTypeRotation)
+	// keep quaternions in one hemisphere so interpolation takes the short way
+	for (size_t i = 1; i < keyCount; ++i)
+	{
+		float dot = decomposed.qx[i] * decomposed.qx[i - 1] + decomposed.qy[i] * decomposed.qy[i - 1] +
+			decomposed.qz[i] * decomposed.qz[i - 1] + decomposed.qw[i] * decomposed.qw[i - 1];
+
+		if (dot < 0.0f)
+		{
+			decomposed.qx[i] = -decomposed.qx[i];
+			decomposed.qy[i] = -decomposed.qy[i];
+			decomposed.qz[i] = -decomposed.qz[i];
+			decomposed.qw[i] = -decomposed.qw[i];
+		}
+	}
+
+	float coeff = GetSceneUnitsConversionCoefficient();
+
+	// Export necessary attributes
+	for (int attributeIndex = 0; attributeIndex < ATTRIBUTE_COUNT; ++attributeIndex)
+	{
+		int attributeId = attrIds[attributeIndex];
+
+		dataHolder.emplace(dataHolder.end());
+		AnimationDataHolderStruct& dataHolderStruct = dataHolder.back();
+
+		for (size_t i = 0; i < keyCount; ++i)
+		{
+			if ((transform.timeKeys[i].attributeMask & (1u << attributeIndex)) == 0)
 			{
-				MQuaternion rotation = transformMatrix.rotation();
-				dataHolderStruct.m_values.push_back((float)rotation.x);
-				dataHolderStruct.m_values.push_back((float)rotation.y);
-				dataHolderStruct.m_values.push_back((float)rotation.z);
-				dataHolderStruct.m_values.push_back((float)rotation.w);
+				continue;
 			}
-			else if (attributeId == m_runtimeMoveTypeScale)
-			{
-				double scale[3];
-				transformMatrix.getScale(scale, MSpace::kTransform);
 
-				dataHolderStruct.m_values.push_back((float)scale[0]);
-				dataHolderStruct.m_values.push_back((float)scale[1]);
-				dataHolderStruct.m_values.push_back((float)scale[2]);
-			}
+			dataHolderStruct.m_timePoints.push_back((float)transform.timeKeys[i].time.as(MTime::Unit::kSeconds));
 
-			if (m_progressBars != nullptr && m_progressBars->isCancelled())
+			if (attributeIndex == TRANSLATION_INDEX)
 			{
-				throw ExportCancelledException();
+				//cm to m
+				dataHolderStruct.m_values.push_back(decomposed.tx[i] * coeff);
+				dataHolderStruct.m_values.push_back(decomposed.ty[i] * coeff);
+				dataHolderStruct.m_values.push_back(decomposed.tz[i] * coeff);
 			}
-
-			if (dataChunkIndex % 100 == 0)
+			else if (attributeIndex == ROTATION_INDEX)
 			{
-				ReportDataChunk(dataChunkIndex, attrCount * uniqueTimeKeys.size());
+				dataHolderStruct.m_values.push_back(decomposed.qx[i]);
+				dataHolderStruct.m_values.push_back(decomposed.qy[i]);
+				dataHolderStruct.m_values.push_back(decomposed.qz[i]);
+				dataHolderStruct.m_values.push_back(decomposed.qw[i]);
+			}
+			else if (attributeIndex == SCALE_INDEX)
+			{
+				dataHolderStruct.m_values.push_back(decomposed.sx[i]);
+				dataHolderStruct.m_values.push_back(decomposed.sy[i]);
+				dataHolderStruct.m_values.push_back(decomposed.sz[i]);
 			}
 		}
 
 		dataHolderStruct.groupName = groupName;
 
+		if (m_keyReductionTolerance > 0.0f)
+		{
+			ReduceKeys(dataHolderStruct, GetOutputComponentCount(attributeId));
+		}
+
 		if (dataHolderStruct.m_timePoints.size() > 0)
 		{
 			(this->*m_pFunc_AddAnimationTrackToRPR)(dataHolderStruct, attributeId);
@@ -672,6 +829,60 @@ void AnimationExporter::ApplyAnimationForTransform(const MDagPath& dagPath, Anim
 	}
 }
 
+void AnimationExporter::ReduceKeys(AnimationDataHolderStruct& dataHolderStruct, int componentCount)
+{
+	std::vector<float>& times = dataHolderStruct.m_timePoints;
+	std::vector<float>& values = dataHolderStruct.m_values;
+
+	size_t keyCount = times.size();
+	if (keyCount < 3)
+		return;
+
+	// checks that keys between first and last can be restored by linear interpolation
+	auto canSkipKeys = [&](size_t first, size_t last)
+	{
+		float duration = times[last] - times[first];
+
+		for (size_t key = first + 1; key < last; ++key)
+		{
+			float t = (duration > 0.0f) ? (times[key] - times[first]) / duration : 0.0f;
+
+			for (int c = 0; c < componentCount; ++c)
+			{
+				float a = values[first * componentCount + c];
+				float b = values[last * componentCount + c];
+
+				if (std::abs(a + (b - a) * t - values[key * componentCount + c]) > m_keyReductionTolerance)
+					return false;
+			}
+		}
+
+		return true;
+	};
+
+	std::vector<size_t> keptKeys;
+	keptKeys.push_back(0);
+
+	for (size_t key = 1; key + 1 < keyCount; ++key)
+	{
+		if (!canSkipKeys(keptKeys.back(), key + 1))
+		{
+			keptKeys.push_back(key);
+		}
+	}
+
+	keptKeys.push_back(keyCount - 1);
+
+	for (size_t i = 0; i < keptKeys.size(); ++i)
+	{
+		times[i] = times[keptKeys[i]];
+		std::copy_n(values.begin() + keptKeys[i] * componentCount, componentCount, values.begin() + i * componentCount);
+	}
+
+	times.resize(keptKeys.size());
+	values.resize(keptKeys.size() * componentCount);
+}
+
 void AnimationExporter::ReportDataChunk(size_t dataChunkIndex, size_t count)
 {
 	std::ostringstream stream;
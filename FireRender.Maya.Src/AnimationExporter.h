@@ -1,6 +1,7 @@
 #pragma once
 
 #include <maya/MFnAnimCurve.h>
+#include <maya/MTime.h>
 #include "RenderProgressBars.h"
 #include "Context/FireRenderContext.h"
 
@@ -28,48 +29,35 @@ class ExportCancelledException
 
 };
 
-class TimeKeyStruct
+// Time point of a transform animation.
+// Mask bits are attribute indices (translation, rotation, scale) because RPRGLTF_ANIMATION_MOVEMENTTYPE_TRANSLATION,
+// RPRGLTF_ANIMATION_MOVEMENTTYPE_ROTATION, RPRGLTF_ANIMATION_MOVEMENTTYPE_SCALE cannot be combined in a flag mask
+struct TimeKeyStruct
 {
-public:
-	TimeKeyStruct(MTime time, int attributeId) : m_Time(time)
-	{
-		m_AttributeId.insert(attributeId);
-	}
-
-	bool operator == (const TimeKeyStruct& rhs) const
-	{
-		return m_Time == rhs.m_Time;
-	}
+	MTime time;
+	unsigned int attributeMask;
 
 	bool operator < (const TimeKeyStruct& rhs) const
 	{
-		return m_Time < rhs.m_Time;
-	}
-
-
-	// Make modifier as const because of use of mutable m_AttributeId member. It is needed because we need to modify it in a "std::set" container
-	void AddNewAttribute(int attributeId) const
-	{
-		m_AttributeId.insert(attributeId);
-	}
-
-	bool DoesAttributeIdPresent(int attributeId) const
-	{
-		return m_AttributeId.find(attributeId) != m_AttributeId.end();
+		return time < rhs.time;
 	}
+};
 
-	MTime GetTime() const { return m_Time; }
-	const std::set<int>& GetAttributeSetRef() const { return m_AttributeId; }
+// Sorted by time, one entry per unique time
+typedef std::vector<TimeKeyStruct> TimeKeyVector;
 
-private:
-	MTime m_Time;
+// Decomposed local transforms, one element per sampled time
+struct DecomposedTransformArrays
+{
+	std::vector<float> tx, ty, tz;
+	std::vector<float> qx, qy, qz, qw;
+	std::vector<float> sx, sy, sz;
 
-	// Use set of attribute Ids because  RPRGLTF_ANIMATION_MOVEMENTTYPE_TRANSLATION, 
-	// RPRGLTF_ANIMATION_MOVEMENTTYPE_ROTATION, RPRGLTF_ANIMATION_MOVEMENTTYPE_SCALE cannot be combined in a flag mask				
-	mutable std::set<int> m_AttributeId;
+	void resize(size_t count);
 };
 
-typedef std::set<TimeKeyStruct> TimeKeySet;
+// Decomposes Maya local matrices (16 values each) into translation, rotation and scale
+void DecomposeMatrices(const double* matrices, size_t count, DecomposedTransformArrays& out);
 
 class AnimationExporter
 {
@@ -83,6 +71,9 @@ public:
 
 	void Export(FireRenderContext& context, MDagPathArray* renderableCamera, frw::RPRSContext exportContext);
 
+	// Keys which can be restored by linear interpolation within the tolerance are dropped; 0 disables reduction
+	void SetKeyReductionTolerance(float tolerance) { m_keyReductionTolerance = tolerance; }
+
 private:
 	struct AnimationDataHolderStruct
 	{
@@ -92,6 +83,17 @@ private:
 	};
 
 	typedef std::vector<AnimationDataHolderStruct> AnimationDataHolderVector;
+
+	// Animated transform which is sampled by BakeTransforms
+	struct BakedTransform
+	{
+		MDagPath dagPath;
+		MPlug matrixPlug;
+		TimeKeyVector timeKeys;
+		std::vector<double> matrices; // 16 values per time key
+	};
+
+	typedef std::vector<BakedTransform> BakedTransformVector;
 	typedef std::vector<frw::Camera> CameraVector;
 
 	struct DataHolderStruct
@@ -111,18 +113,19 @@ private:
 	void AssignCameras(DataHolderStruct& dataHolder, FireRenderContext& context);
 	void AssignMeshesAndLights(FireRenderContext& context);
 
-	// addAdditionalKeys param means that we need to add additional keys for Rotation, 
-	void AddTimesFromCurve(const MFnAnimCurve& curve, TimeKeySet& outUniqueTimeKeySet, int attributeId);
+	void AddTimesFromCurve(const MFnAnimCurve& curve, TimeKeyVector& outTimeKeys, int attributeIndex);
 
-	void AddOneTimePoint(const MTime time, const MFnAnimCurve& curve, TimeKeySet& outUniqueTimeKeySet, int attributeId, int keyIndex);
+	void AddOneTimePoint(const MTime time, const MFnAnimCurve& curve, TimeKeyVector& outTimeKeys, int attributeIndex, int keyIndex);
 
 	int GetOutputComponentCount(int attrId);
-	inline float GetValueForTime(const MPlug& plug, const MFnAnimCurve& curve, const MTime& time);
 
 	void AddAnimationToGLTFRPR(AnimationDataHolderStruct& gltfDataHolderStruct, int attrId);
 	void AddAnimationToRPRS(AnimationDataHolderStruct& gltfDataHolderStruct, int attrId);
 
-	void ApplyAnimationForTransform(const MDagPath& dagPath, AnimationDataHolderVector& gltfDataHolder);
+	bool GatherTimeKeys(const MDagPath& dagPath, TimeKeyVector& outTimeKeys);
+	void BakeTransforms(BakedTransformVector& transforms);
+	void ApplyAnimationForTransform(const BakedTransform& transform, AnimationDataHolderVector& dataHolder);
+	void ReduceKeys(AnimationDataHolderStruct& dataHolderStruct, int componentCount);
 	void ReportGLTFExportError(MString strPath);
 
 	bool IsNeedToSetANameForTransform(const MDagPath& dagPath);
@@ -140,6 +143,7 @@ private:
 
 	RenderProgressBars* m_progressBars;
 	bool m_IsGLTFExport;
+	float m_keyReductionTolerance;
 
 	DataHolderStruct m_dataHolder;
 
@@ -0,0 +1,327 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#include "BakedTextureCache.h"
+#include "FireRenderUtils.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+
+#include <imageio.h>
+
+namespace fs = std::filesystem;
+
+using namespace FireMaya;
+
+namespace
+{
+	// bakes are 8 bit, so PNG keeps them lossless
+	const char* BakeFileFormat = "png";
+	const char* BakeFileExtension = ".png";
+}
+
+std::atomic<uint64_t> BakedTextureCache::s_maxSize(1024ull * 1024 * 1024);
+
+void BakedTextureCache::SetMaxSize(uint64_t bytes)
+{
+	s_maxSize = bytes;
+}
+
+BakedTextureCache& BakedTextureCache::GetInstance()
+{
+	static BakedTextureCache instance("", 3);
+	return instance;
+}
+
+BakedTextureCache& BakedTextureCache::GetSwatchInstance()
+{
+	static BakedTextureCache instance("Swatches", 4);
+	return instance;
+}
+
+BakedTextureCache::BakedTextureCache(const std::string& subfolder, unsigned int channels)
+	: m_channels(channels)
+{
+	m_folder = getBakedTextureCachePath().asUTF8();
+
+	if (!m_folder.empty())
+	{
+		if (!subfolder.empty())
+		{
+			m_folder = (fs::path(m_folder) / subfolder).string();
+		}
+
+		std::error_code errorCode;
+		fs::create_directories(m_folder, errorCode);
+
+		if (errorCode)
+		{
+			LogPrint("Baked texture cache disabled: can't create folder %s", m_folder.c_str());
+			m_folder.clear();
+		}
+	}
+}
+
+BakedTextureCache::~BakedTextureCache()
+{
+	Flush();
+}
+
+std::string BakedTextureCache::GetFilePrefix(const MString& nodeId, const MString& plugName, int width, int height) const
+{
+	std::string plug = plugName.asChar();
+	for (char& c : plug)
+	{
+		if (!isalnum((unsigned char)c))
+			c = '_';
+	}
+
+	return std::string(nodeId.asChar()) + "_" + plug + "_" + std::to_string(width) + "x" + std::to_string(height) + "_";
+}
+
+std::string BakedTextureCache::GetFilePath(const std::string& prefix, uint64_t networkHash) const
+{
+	char hash[17] = {};
+	snprintf(hash, sizeof(hash), "%016llx", (unsigned long long) networkHash);
+
+	return (fs::path(m_folder) / (prefix + hash + BakeFileExtension)).string();
+}
+
+bool BakedTextureCache::ReadImage(const std::string& path, int width, int height, std::vector<unsigned char>& outPixels) const
+{
+	std::unique_ptr<OIIO::ImageInput> input = std::unique_ptr<OIIO::ImageInput>(OIIO::ImageInput::create(path));
+	if (!input)
+		return false;
+
+	OIIO::ImageSpec spec;
+	if (!input->open(path, spec))
+		return false;
+
+	bool success = false;
+
+	if (spec.width == width && spec.height == height && spec.nchannels == (int) m_channels)
+	{
+		outPixels.resize(width * height * m_channels);
+		success = input->read_image(OIIO::TypeDesc::UINT8, outPixels.data());
+	}
+
+	input->close();
+
+	return success;
+}
+
+bool BakedTextureCache::WriteImage(const std::string& path, int width, int height, unsigned int channels, const std::vector<unsigned char>& pixels)
+{
+	// file is written under temporary name, so that readers never see partially written image
+	std::string tempPath = path + ".tmp";
+
+	// format is given explicitly since the temporary name has no image extension
+	std::unique_ptr<OIIO::ImageOutput> output = std::unique_ptr<OIIO::ImageOutput>(OIIO::ImageOutput::create(BakeFileFormat));
+	if (!output)
+		return false;
+
+	OIIO::ImageSpec spec(width, height, channels, OIIO::TypeDesc::UINT8);
+
+	if (!output->open(tempPath, spec))
+		return false;
+
+	bool success = output->write_image(OIIO::TypeDesc::UINT8, pixels.data());
+	output->close();
+
+	std::error_code errorCode;
+	if (!success)
+	{
+		fs::remove(fs::u8path(tempPath), errorCode);
+		return false;
+	}
+
+	fs::rename(fs::u8path(tempPath), fs::u8path(path), errorCode);
+	if (errorCode)
+	{
+		fs::remove(fs::u8path(tempPath), errorCode);
+		return false;
+	}
+
+	return true;
+}
+
+void BakedTextureCache::RemoveOutdatedFiles(const std::string& folder, const std::string& prefix, const std::string& path)
+{
+	struct CachedFile
+	{
+		fs::path path;
+		fs::file_time_type writeTime;
+		uint64_t size;
+	};
+
+	std::vector<CachedFile> files;
+	uint64_t totalSize = 0;
+
+	std::error_code errorCode;
+	for (const auto& entry : fs::directory_iterator(folder, errorCode))
+	{
+		if (!entry.is_regular_file(errorCode) || entry.path().extension() != BakeFileExtension)
+			continue;
+
+		// only the latest bake of the plug is kept
+		if (entry.path().filename().string().compare(0, prefix.length(), prefix) == 0 && entry.path().string() != path)
+		{
+			fs::remove(entry.path(), errorCode);
+			continue;
+		}
+
+		CachedFile file = { entry.path(), entry.last_write_time(errorCode), entry.file_size(errorCode) };
+		totalSize += file.size;
+		files.push_back(file);
+	}
+
+	uint64_t maxSize = s_maxSize;
+	if (maxSize == 0 || totalSize <= maxSize)
+		return;
+
+	std::sort(files.begin(), files.end(), [](const CachedFile& a, const CachedFile& b) { return a.writeTime < b.writeTime; });
+
+	for (const CachedFile& file : files)
+	{
+		if (totalSize <= maxSize)
+			break;
+
+		if (file.path.string() == path)
+			continue;
+
+		if (fs::remove(file.path, errorCode))
+		{
+			totalSize -= file.size;
+		}
+	}
+}
+
+void BakedTextureCache::WaitPendingWrite(const std::string& path)
+{
+	std::shared_future<void> pendingWrite;
+
+	{
+		std::lock_guard<std::mutex> lock(m_pendingWritesMutex);
+
+		auto it = m_pendingWrites.find(path);
+		if (it == m_pendingWrites.end())
+			return;
+
+		pendingWrite = it->second;
+	}
+
+	pendingWrite.wait();
+}
+
+bool BakedTextureCache::Load(const MString& nodeId, const MString& plugName, int width, int height, uint64_t networkHash, bool allowStale,
+	std::vector<unsigned char>& outPixels, bool& outIsStale)
+{
+	outIsStale = false;
+
+	if (m_folder.empty())
+		return false;
+
+	std::string prefix = GetFilePrefix(nodeId, plugName, width, height);
+	std::string path = GetFilePath(prefix, networkHash);
+
+	// file might be still written
+	WaitPendingWrite(path);
+
+	std::error_code errorCode;
+	if (fs::exists(fs::u8path(path), errorCode))
+	{
+		return ReadImage(path, width, height, outPixels);
+	}
+
+	if (!allowStale)
+		return false;
+
+	// inputs were changed since last bake; take the most recent one
+	std::string stalePath;
+	fs::file_time_type staleTime;
+	for (const auto& entry : fs::directory_iterator(m_folder, errorCode))
+	{
+		std::string fileName = entry.path().filename().string();
+		if (fileName.compare(0, prefix.length(), prefix) != 0 || entry.path().extension() != BakeFileExtension)
+			continue;
+
+		fs::file_time_type writeTime = entry.last_write_time(errorCode);
+		if (stalePath.empty() || writeTime > staleTime)
+		{
+			stalePath = entry.path().string();
+			staleTime = writeTime;
+		}
+	}
+
+	if (stalePath.empty() || !ReadImage(stalePath, width, height, outPixels))
+		return false;
+
+	outIsStale = true;
+
+	return true;
+}
+
+void BakedTextureCache::Store(const MString& nodeId, const MString& plugName, int width, int height, uint64_t networkHash,
+	std::vector<unsigned char> pixels)
+{
+	if (m_folder.empty() || pixels.size() != (size_t) width * height * m_channels)
+		return;
+
+	std::string prefix = GetFilePrefix(nodeId, plugName, width, height);
+	std::string path = GetFilePath(prefix, networkHash);
+
+	// the same file must not be written twice at the same time
+	WaitPendingWrite(path);
+
+	std::string folder = m_folder;
+	unsigned int channels = m_channels;
+
+	std::lock_guard<std::mutex> lock(m_pendingWritesMutex);
+
+	// forget finished writes
+	for (auto it = m_pendingWrites.begin(); it != m_pendingWrites.end();)
+	{
+		if (it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			it = m_pendingWrites.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	m_pendingWrites[path] = std::async(std::launch::async, [folder, prefix, path, width, height, channels, pixels = std::move(pixels)]()
+	{
+		if (!WriteImage(path, width, height, channels, pixels))
+		{
+			LogPrint("Failed to write baked texture %s", path.c_str());
+			return;
+		}
+
+		RemoveOutdatedFiles(folder, prefix, path);
+	}).share();
+}
+
+void BakedTextureCache::Flush()
+{
+	std::lock_guard<std::mutex> lock(m_pendingWritesMutex);
+
+	for (auto& pendingWrite : m_pendingWrites)
+	{
+		pendingWrite.second.wait();
+	}
+
+	m_pendingWrites.clear();
+}
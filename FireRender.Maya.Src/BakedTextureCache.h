@@ -0,0 +1,75 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#pragma once
+
+#include <maya/MString.h>
+
+#include <atomic>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace FireMaya
+{
+	// Persistent cache of procedural textures baked with MTextureManager (and of rendered material swatches).
+	// Baked images are stored as lossless compressed PNG files named <node uuid>_<plug>_<width>x<height>_<network hash>.png
+	// Files are written with OpenImageIO instead of Maya API so that the writes can be done from any thread.
+	class BakedTextureCache
+	{
+	public:
+		// 8 bit RGB images of baked procedural textures
+		static BakedTextureCache& GetInstance();
+		// 8 bit RGBA images of material swatches
+		static BakedTextureCache& GetSwatchInstance();
+
+		// Loads 8 bit image baked for given network hash.
+		// If there is no such image and allowStale is set, the most recent bake of the same plug and resolution is loaded and outIsStale is set.
+		bool Load(const MString& nodeId, const MString& plugName, int width, int height, uint64_t networkHash, bool allowStale,
+			std::vector<unsigned char>& outPixels, bool& outIsStale);
+
+		// Writes 8 bit image in a background thread and removes older bakes of the same plug and resolution
+		void Store(const MString& nodeId, const MString& plugName, int width, int height, uint64_t networkHash,
+			std::vector<unsigned char> pixels);
+
+		// Waits for pending writes
+		void Flush();
+
+		// Least recently written bakes are removed once the folder of a cache exceeds this size, 0 disables the limit
+		static void SetMaxSize(uint64_t bytes);
+
+	private:
+		BakedTextureCache(const std::string& subfolder, unsigned int channels);
+		~BakedTextureCache();
+
+		std::string GetFilePrefix(const MString& nodeId, const MString& plugName, int width, int height) const;
+		std::string GetFilePath(const std::string& prefix, uint64_t networkHash) const;
+
+		bool ReadImage(const std::string& path, int width, int height, std::vector<unsigned char>& outPixels) const;
+		static bool WriteImage(const std::string& path, int width, int height, unsigned int channels, const std::vector<unsigned char>& pixels);
+		static void RemoveOutdatedFiles(const std::string& folder, const std::string& prefix, const std::string& path);
+
+		void WaitPendingWrite(const std::string& path);
+
+	private:
+		std::string m_folder;
+		unsigned int m_channels;
+
+		// pending writes by file path
+		std::mutex m_pendingWritesMutex;
+		std::map<std::string, std::shared_future<void>> m_pendingWrites;
+
+		static std::atomic<uint64_t> s_maxSize;
+	};
+}
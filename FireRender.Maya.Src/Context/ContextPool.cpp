@@ -0,0 +1,103 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#include "ContextPool.h"
+
+#include "Logger.h"
+
+std::mutex ContextPool::m_Mutex;
+std::map<ContextPool::Key, std::vector<frw::Context>> ContextPool::m_Contexts;
+size_t ContextPool::m_Capacity = 0;
+
+frw::Context ContextPool::Acquire(const Key& key)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	auto it = m_Contexts.find(key);
+	if (it == m_Contexts.end() || it->second.empty())
+	{
+		return frw::Context();
+	}
+
+	frw::Context context = it->second.back();
+	it->second.pop_back();
+
+	return context;
+}
+
+bool ContextPool::Release(const Key& key, frw::Context context)
+{
+	if (!context)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	std::vector<frw::Context>& contexts = m_Contexts[key];
+	if (contexts.size() >= m_Capacity)
+	{
+		return false;
+	}
+
+	// detach everything that belonged to the previous owner, the objects themselves are destroyed with its scope
+	rprContextSetScene(context.Handle(), nullptr);
+	rprContextSetParameterByKeyPtr(context.Handle(), RPR_CONTEXT_RENDER_UPDATE_CALLBACK_FUNC, nullptr);
+	rprContextSetParameterByKeyPtr(context.Handle(), RPR_CONTEXT_RENDER_UPDATE_CALLBACK_DATA, nullptr);
+
+	contexts.push_back(context);
+
+	return true;
+}
+
+void ContextPool::SetCapacity(size_t capacity)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	m_Capacity = capacity;
+
+	for (auto& it : m_Contexts)
+	{
+		if (it.second.size() > m_Capacity)
+		{
+			it.second.resize(m_Capacity);
+		}
+	}
+}
+
+size_t ContextPool::GetCapacity()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	return m_Capacity;
+}
+
+void ContextPool::Clear()
+{
+	std::map<Key, std::vector<frw::Context>> contexts;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		contexts.swap(m_Contexts);
+	}
+
+	size_t count = 0;
+	for (const auto& it : contexts)
+	{
+		count += it.second.size();
+	}
+
+	if (count > 0)
+	{
+		LogPrint("Context pool: destroying %d idle context(s)", (int)count);
+	}
+}
@@ -0,0 +1,65 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#pragma once
+
+#include "frWrap.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Keeps initialized RPR contexts alive between renders so that switching the
+// viewport, IPR, production render or swatches back on does not pay for
+// plugin registration, device initialization and shader cache loading again.
+// Contexts are stored per plugin / creation flags / cpu thread limit / render type / shader cache combination
+// and only the scene data built on top of them is destroyed on cleanScene.
+// Pooling is off unless enabled with RPR_MAYA_CONTEXT_POOL_SIZE, since idle contexts keep their device memory.
+class ContextPool
+{
+public:
+	struct Key
+	{
+		rpr_int pluginId;
+		rpr_creation_flags createFlags;
+		int cpuThreadLimit;
+		// parameters differ between render types, so a context is only reused for the same render type
+		int renderType;
+		std::string shaderCachePath;
+
+		bool operator<(const Key& other) const
+		{
+			return std::tie(pluginId, createFlags, cpuThreadLimit, renderType, shaderCachePath) <
+				std::tie(other.pluginId, other.createFlags, other.cpuThreadLimit, other.renderType, other.shaderCachePath);
+		}
+	};
+
+	// Returns a pooled context for the given key or an invalid context if none is available
+	static frw::Context Acquire(const Key& key);
+
+	// Returns the context into the pool; false if the pool for this key is full
+	static bool Release(const Key& key, frw::Context context);
+
+	// Maximum number of idle contexts kept per key, 0 disables pooling
+	static void SetCapacity(size_t capacity);
+	static size_t GetCapacity();
+
+	// Destroys all idle contexts. Should be called from the RPR thread
+	static void Clear();
+
+private:
+	static std::mutex m_Mutex;
+	static std::map<Key, std::vector<frw::Context>> m_Contexts;
+	static size_t m_Capacity;
+};
@@ -21,6 +21,7 @@ limitations under the License.
 #include <maya/MFnMeshData.h>
 #include <maya/MFnMesh.h>
 #include <maya/MFnLight.h>
+#include <maya/MFnCamera.h>
 #include <maya/MSelectionList.h>
 #include <maya/MImage.h>
 #include <maya/MItDag.h>
@@ -42,6 +43,8 @@ limitations under the License.
 
 #include "FireRenderThread.h"
 #include "FireRenderMaterialSwatchRender.h"
+#include "ContextPool.h"
+#include "RenderStats.h"
 #include "CompositeWrapper.h"
 
 #include <deque>
@@ -90,6 +93,8 @@ FireRenderContext::FireRenderContext() :
 	m_viewportMotionBlur(false),
 	m_motionBlurCameraExposure(0.0f),
 	m_motionSamples(0),
+	m_hairLOD(false),
+	m_hairLODQuality(1.0f),
 	m_cameraAttributeChanged(false),
 	m_samplesPerUpdate(1),
 	m_secondsSpentOnLastRender(0.0),
@@ -105,6 +110,7 @@ FireRenderContext::FireRenderContext() :
 	m_renderLayersChanged(false),
 	m_cameraDirty(true),
 	m_denoiserChanged(false),
+	m_lightCullingChanged(false),
 	m_denoiserFilter(nullptr),
 	m_upscalerFilter(nullptr),
 	m_shadowColor{ 0.0f, 0.0f, 0.0f },
@@ -409,6 +415,7 @@ bool FireRenderContext::buildScene(bool isViewport, bool glViewport, bool freshe
 		setupContextPostSceneCreation(m_globals);
 
 		setMotionBlurParameters(m_globals);
+		setHairLODParameters(m_globals);
 
 		// Update render selected objects only flag
 		int isRenderSelectedOnly = 0;
@@ -804,6 +811,104 @@ void FireRenderContext::setupDenoiserFB()
 	}
 }
 
+void FireRenderContext::CullLights()
+{
+	MAIN_THREAD_ONLY;
+
+	MPoint eyePoint;
+	MVector viewDirection(0.0, 0.0, -1.0);
+	bool hasCamera = false;
+
+	const MDagPath& cameraPath = m_camera.DagPath();
+	if (cameraPath.isValid())
+	{
+		MFnCamera fnCamera(cameraPath);
+		eyePoint = fnCamera.eyePoint(MSpace::kWorld);
+		viewDirection = fnCamera.viewDirection(MSpace::kWorld);
+		hasCamera = true;
+	}
+
+	struct LightContribution
+	{
+		FireRenderLight* light;
+		float contribution;
+	};
+
+	std::vector<LightContribution> lights;
+	float maxContribution = 0.0f;
+
+	for (auto& it : m_sceneObjects)
+	{
+		auto light = dynamic_cast<FireRenderLight*>(it.second.get());
+		if (!light)
+			continue;
+
+		// power of custom emitters is not estimated, they are never culled
+		if (dynamic_cast<FireRenderCustomEmitter*>(light))
+			continue;
+
+		float contribution = light->GetCullingPower();
+
+		const MDagPath& dagPath = light->DagPath();
+		if (hasCamera && !light->IsInfinite() && dagPath.isValid())
+		{
+			MVector toLight = MPoint(dagPath.inclusiveMatrix()[3]) - eyePoint;
+
+			// lights behind the camera still contribute through indirect lighting, but less
+			if (toLight * viewDirection < 0.0)
+			{
+				contribution *= 0.25f;
+			}
+
+			contribution /= (float) std::max(toLight * toLight, 1.0);
+		}
+
+		lights.push_back({ light, contribution });
+		maxContribution = std::max(maxContribution, contribution);
+	}
+
+	float threshold = m_globals.lightCullingThreshold * maxContribution;
+	int disabledCount = 0;
+	int restoredCount = 0;
+
+	for (const LightContribution& entry : lights)
+	{
+		bool cull = !entry.light->IsAlwaysKept() && !entry.light->IsInfinite() && (entry.contribution < threshold);
+
+		// only lights which actually leave or return to the scene are counted
+		if (entry.light->SetCulled(cull))
+		{
+			++(cull ? disabledCount : restoredCount);
+		}
+	}
+
+	if (disabledCount > 0 || restoredCount > 0)
+	{
+		LogPrint("Light culling: %d of %d lights disabled, %d restored", disabledCount, int(lights.size()), restoredCount);
+	}
+}
+
+void FireRenderContext::RestoreCulledLights()
+{
+	MAIN_THREAD_ONLY;
+
+	int restoredCount = 0;
+
+	for (auto& it : m_sceneObjects)
+	{
+		auto light = dynamic_cast<FireRenderLight*>(it.second.get());
+		if (light && light->SetCulled(false))
+		{
+			++restoredCount;
+		}
+	}
+
+	if (restoredCount > 0)
+	{
+		LogPrint("Light culling: %d lights restored", restoredCount);
+	}
+}
+
 void FireRenderContext::UpdateDefaultLights()
 {
 	MAIN_THREAD_ONLY;
@@ -927,6 +1032,7 @@ void FireRenderContext::cleanScene()
 		}
 
 		m_sceneObjects.clear();
+		m_geometryCache.Clear();
 
 		m_camera.clear();
 		m_defaultLight.Reset();
@@ -959,11 +1065,28 @@ void FireRenderContext::cleanScene()
 			gamma_correction.Reset();
 		}
 
-		for (auto& fb : m.framebufferAOV)
-			fb.Reset();
+		// Return rpr context into the pool instead of destroying it. Contexts with contour integrator are not reused
+		// because integrator can't be switched back without recreating the context
+		bool returnToPool = m_contextPoolable && !m_globals.contourIsEnabled;
+		m_contextPoolable = false;
 
-		for (auto& fb : m.framebufferAOV_resolved)
-			fb.Reset();
+		for (int i = 0; i < RPR_AOV_MAX; ++i)
+		{
+			if (returnToPool && m.framebufferAOV[i])
+			{
+				rprContextSetAOV(context(), i, nullptr);
+			}
+
+			m.framebufferAOV[i].Reset();
+			m.framebufferAOV_resolved[i].Reset();
+		}
+
+		m_noiseFrameBuffer.Reset();
+
+		if (returnToPool && ContextPool::Release(m_contextPoolKey, scope.Context()))
+		{
+			DebugPrint("FireRenderContext::cleanScene() - context returned to pool");
+		}
 
 		scope.Reset();
 	});
@@ -975,11 +1098,11 @@ void FireRenderContext::cleanSceneAsync(std::shared_ptr<FireRenderContext> refTo
 		{ refToKeepAlive->cleanScene(); }, refToKeepAlive);
 }
 
-void FireRenderContext::initSwatchScene()
+void FireRenderContext::initSwatchScene(RenderType deviceSettings)
 {
 	DebugPrint("FireRenderContext::buildSwatchScene(...)");
 
-	auto createFlags = FireMaya::Options::GetContextDeviceFlags();
+	auto createFlags = FireMaya::Options::GetContextDeviceFlags(deviceSettings);
 
 	rpr_int res;
 	if (!createContextEtc(createFlags, true, false, &res))
@@ -1017,17 +1140,20 @@ void FireRenderContext::initSwatchScene()
 	SetupPreviewMode();
 }
 
-void FireRenderContext::UpdateCompletionCriteriaForSwatch()
+void FireRenderContext::UpdateCompletionCriteriaForSwatch(int iterations)
 {
 	CompletionCriteriaParams completionParams;
 
-	bool enableSwatches = false;
+	if (iterations < 0)
+	{
+		bool enableSwatches = false;
 
-	int iterations = FireRenderGlobalsData::getThumbnailIterCount(&enableSwatches);
+		iterations = FireRenderGlobalsData::getThumbnailIterCount(&enableSwatches);
 
-	if (!enableSwatches)
-	{
-		iterations = 0;
+		if (!enableSwatches)
+		{
+			iterations = 0;
+		}
 	}
 
 	completionParams.completionCriteriaMaxIterations = iterations;
@@ -1078,9 +1204,10 @@ void FireRenderContext::render(bool lock)
 		}
 
 		m_restartRender = false;
-		m_renderStartTime = GetCurrentChronoTime();
-		m_currentIteration = 0;
-		m_currentFrame = 0;
+		m_renderStartTime = GetCurrentChronoTime() - std::chrono::seconds(m_resumeSeconds);
+		m_currentIteration = m_resumeIterations;
+		m_currentFrame = m_resumeFrameCount;
+		resetNoiseLevel();
 
 		if (m_IterationsPowerOf2Mode)
 		{
@@ -1112,10 +1239,22 @@ void FireRenderContext::render(bool lock)
 
 	TriggerProgressCallback(progressData);
 
-	if (m_useRegion)
-		context.RenderTile(m_region.left, m_region.right+1, m_height - m_region.top - 1, m_height - m_region.bottom);
-	else
-		context.Render();
+	{
+		// kernels are compiled during the first pass unless they are in the shader cache
+		RenderStats::Scope statsScope(m_currentIteration == m_resumeIterations ? "shader" : "render",
+			m_currentIteration == m_resumeIterations ? "First render pass" : "Render pass");
+
+		if (m_useRegion)
+			context.RenderTile(m_region.left, m_region.right+1, m_height - m_region.top - 1, m_height - m_region.bottom);
+		else
+			context.Render();
+	}
+
+	if (RenderStats::IsRecording())
+	{
+		RenderStats::AddCount("Iterations", iterationStep);
+		RenderStats::UpdateHighWater("GPU memory MB", (long long)(context.GetMemoryUsage() >> 20));
+	}
 
 	if (m_IterationsPowerOf2Mode && !m_globals.contourIsEnabled)
 	{
@@ -1126,7 +1265,7 @@ void FireRenderContext::render(bool lock)
 		}
 	}
 
-	if (m_currentIteration == 0)
+	if (m_currentIteration == m_resumeIterations)
 	{
 		m_lastRenderStartTime = std::chrono::system_clock::now();
 
@@ -1136,6 +1275,11 @@ void FireRenderContext::render(bool lock)
 	m_currentIteration += iterationStep;
 	m_currentFrame++;
 
+	if (m_completionCriteriaParams.hasNoiseThreshold())
+	{
+		checkNoiseLevel();
+	}
+
 	m_cameraAttributeChanged = false;
 }
 
@@ -1215,6 +1359,8 @@ std::vector<float> FireRenderContext::getRenderImageData()
 	RPR_THREAD_ONLY;
 	DebugPrint("FireRenderContext::getRenderImageData()");
 
+	RenderStats::Scope statsScope("readback", "Read color");
+
 	rpr_framebuffer fb = frameBufferAOV_Resolved(RPR_AOV_COLOR);
 
 	size_t dataSize = 0;
@@ -1336,15 +1482,43 @@ bool FireRenderContext::createContextEtc(rpr_creation_flags creation_flags, bool
 		else
 			m_glInteropActive = false;
 
-		rpr_context handle;
-		bool contextCreated = createContext(creation_flags, handle, pOutRes);
-		if (!contextCreated)
+		TimePoint acquireStartTime = GetCurrentChronoTime();
+
+		m_contextPoolKey = { GetContextPoolPluginID(), creation_flags, getThreadCountToOverride(), int(GetRenderType()), getShaderCachePath().asUTF8() };
+		m_contextPoolable = (m_contextPoolKey.pluginId != INCORRECT_PLUGIN_ID) && (ContextPool::GetCapacity() > 0);
+
+		frw::Context pooledContext;
+		if (m_contextPoolable)
+		{
+			pooledContext = ContextPool::Acquire(m_contextPoolKey);
+		}
+
+		if (pooledContext)
 		{
-			MGlobal::displayError("Unable to create Radeon ProRender context.");
-			return false;
+			if (pOutRes != nullptr)
+			{
+				*pOutRes = RPR_SUCCESS;
+			}
+
+			FireRenderThread::UseTheThread((creation_flags & RPR_CREATION_FLAGS_ENABLE_CPU) == RPR_CREATION_FLAGS_ENABLE_CPU);
+			scope.Init(pooledContext, destroyMaterialSystemOnDelete, createScene);
 		}
+		else
+		{
+			rpr_context handle;
+			bool contextCreated = createContext(creation_flags, handle, pOutRes);
+			if (!contextCreated)
+			{
+				m_contextPoolable = false;
+				MGlobal::displayError("Unable to create Radeon ProRender context.");
+				return false;
+			}
 
-		scope.Init(handle, destroyMaterialSystemOnDelete, createScene);
+			scope.Init(handle, destroyMaterialSystemOnDelete, createScene);
+		}
+
+		LogPrint("Context acquire latency: %ld ms (%s)", TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), acquireStartTime),
+			pooledContext ? "reused from pool" : "created");
 
 #ifdef _DEBUG
 		static int dumpDebug;
@@ -1703,6 +1877,8 @@ void FireRenderContext::readFrameBuffer(ReadFrameBufferRequestParams& params)
 {
 	RPR_THREAD_ONLY;
 
+	RenderStats::Scope statsScope("readback", "Read framebuffer");
+
 	RV_PIXEL* data = readFrameBufferSimple(params);
 
 	if (data == nullptr)
@@ -2077,6 +2253,7 @@ void FireRenderContext::updateFromGlobals(bool applyLock)
 
 	updateLimitsFromGlobalData(m_globals);
 	updateMotionBlurParameters(m_globals);
+	updateHairLODParameters(m_globals);
 
 	m_camera.setType(m_globals.cameraType);
 
@@ -2143,6 +2320,23 @@ void FireRenderContext::globalsChangedCallback(MNodeMessage::AttributeMessage ms
 			{
 				restartRender = true;
 			}
+			else if (FireRenderGlobalsData::IsHairLOD(plug.name()))
+			{
+				restartRender = true;
+			}
+			else if (FireRenderGlobalsData::IsLightCulling(plug.name()))
+			{
+				frContext->m_lightCullingChanged = true;
+				restartRender = true;
+			}
+			else if (FireRenderGlobalsData::IsDeduplicateGeometry(plug.name()))
+			{
+				restartRender = true;
+			}
+			else if (FireRenderGlobalsData::IsDeduplicateShaders(plug.name()))
+			{
+				restartRender = true;
+			}
 
 			RenderType renderType = frContext->GetRenderType();
 			RenderQuality quality = GetRenderQualityForRenderType(renderType);
@@ -2235,6 +2429,31 @@ void FireRenderContext::setMotionBlurParameters(const FireRenderGlobalsData& glo
 	m_motionSamples = globalData.motionSamples;
 }
 
+void FireRenderContext::updateHairLODParameters(const FireRenderGlobalsData& globalData)
+{
+	bool lodChanged = (m_hairLOD != globalData.hairLOD) ||
+		(globalData.hairLOD && (m_hairLODQuality != globalData.hairLODQuality));
+
+	if (lodChanged)
+	{
+		for (const auto& it : m_sceneObjects)
+		{
+			if (auto frHair = dynamic_cast<FireRenderHair*>(it.second.get()))
+			{
+				frHair->setDirty();
+			}
+		}
+	}
+
+	setHairLODParameters(globalData);
+}
+
+void FireRenderContext::setHairLODParameters(const FireRenderGlobalsData& globalData)
+{
+	m_hairLOD = globalData.hairLOD;
+	m_hairLODQuality = globalData.hairLODQuality;
+}
+
 bool FireRenderContext::isInteractive() const
 {
 	return (m_RenderType == RenderType::IPR) || (m_RenderType == RenderType::ViewportRender);
@@ -2572,6 +2791,16 @@ void FireRenderContext::TriggerProgressCallback(const ContextWorkProgressData& s
 	}
 }
 
+// Records the sync time of an object under its Maya node type
+static void AddObjectSyncStats(const FireRenderObject& object, const char* suffix, RenderStats::Clock::time_point start)
+{
+	std::string typeName = object.Object().isNull() ? "unknown" : MFnDependencyNode(object.Object()).typeName().asUTF8();
+	typeName += suffix;
+
+	RenderStats::AddEvent("sync", typeName, start, RenderStats::Clock::now());
+	RenderStats::AddCount("Synced " + typeName);
+}
+
 bool FireRenderContext::Freshen(bool lock, std::function<bool()> cancelled)
 {
 	MAIN_THREAD_ONLY;
@@ -2633,6 +2862,9 @@ bool FireRenderContext::Freshen(bool lock, std::function<bool()> cancelled)
 	syncProgressData.totalCount = dirtyObjectsSize;
 	TimePoint syncStartTime = GetCurrentChronoTime();
 
+	RenderStats::Scope syncStatsScope("sync", "Scene sync");
+	const bool recordStats = RenderStats::IsRecording();
+
 	UpdateTimeAndTriggerProgressCallback(syncProgressData, ProgressType::SyncStarted);
 
 	std::deque<std::shared_ptr<FireRenderObject> > meshesToInitialize; // meshes which would be pre-processed
@@ -2692,8 +2924,15 @@ bool FireRenderContext::Freshen(bool lock, std::function<bool()> cancelled)
 			DebugPrint("Freshing object");
 
 			UpdateTimeAndTriggerProgressCallback(syncProgressData, ProgressType::ObjectPreSync);
+
+			RenderStats::Clock::time_point objectStartTime = recordStats ? RenderStats::Clock::now() : RenderStats::Clock::time_point();
 			ptr->Freshen(shouldCalculateHash);
 
+			if (recordStats)
+			{
+				AddObjectSyncStats(*ptr, "", objectStartTime);
+			}
+
 			syncProgressData.currentIndex++;
 			UpdateTimeAndTriggerProgressCallback(syncProgressData, ProgressType::ObjectSyncComplete);
 
@@ -2704,41 +2943,28 @@ bool FireRenderContext::Freshen(bool lock, std::function<bool()> cancelled)
 		}
 	}
 
-	const bool isDeformationMotionBlurEnabled = motionBlur() && IsDeformationMotionBlurEnabled() && !isInteractive();
-	const unsigned int motionSamplesCount = isDeformationMotionBlurEnabled ? motionSamples() : 1;
-
 	// read data from meshes
-	MTime initialTime = MAnimControl::currentTime();
-	MTime currentTime = initialTime;
-	unsigned int currentSampeIdx = 0;
-
-	do
+	// deformation motion samples are read by meshes themselves at sub-frame times, without changing scene time
+	for (auto it = meshesToInitialize.begin(); it != meshesToInitialize.end(); ++it)
 	{
-		// iterate through meshes
-		for (auto it = meshesToInitialize.begin(); it != meshesToInitialize.end(); ++it)
+		if (!it->get())
 		{
-			if (!it->get())
-			{
-				continue;
-			}
-
-			const bool success = it->get()->PreProcessMesh(currentSampeIdx);
-			if (success && (currentSampeIdx == 0))
-			{
-				meshesToFreshen.emplace_back() = *it;
-			}
+			continue;
 		}
 
-		if (++currentSampeIdx >= motionSamplesCount)
-			break;
+		RenderStats::Clock::time_point objectStartTime = recordStats ? RenderStats::Clock::now() : RenderStats::Clock::time_point();
+		const bool success = it->get()->PreProcessMesh(0);
 
-		// positioning on next point of time (starting from currentTime)
-		currentTime += (float)currentSampeIdx / (motionSamplesCount - 1);
-		MGlobal::viewFrame(currentTime);
-		
-	} while (currentTime != MAnimControl::maxTime());
+		if (recordStats)
+		{
+			AddObjectSyncStats(**it, " read", objectStartTime);
+		}
 
-	MGlobal::viewFrame(initialTime);
+		if (success)
+		{
+			meshesToFreshen.emplace_back() = *it;
+		}
+	}
 
 	// process read data (would be done in multiple threads in the future)
 	for (auto it = meshesToFreshen.begin(); it != meshesToFreshen.end(); ++it)
@@ -2747,14 +2973,46 @@ bool FireRenderContext::Freshen(bool lock, std::function<bool()> cancelled)
 		if (pMesh == nullptr)
 			continue;
 
+		RenderStats::Clock::time_point objectStartTime = recordStats ? RenderStats::Clock::now() : RenderStats::Clock::time_point();
 		pMesh->Freshen(shouldCalculateHash);
+
+		if (recordStats)
+		{
+			AddObjectSyncStats(*pMesh, "", objectStartTime);
+		}
 	}
 
 	syncProgressData.elapsed = TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), syncStartTime);
 	UpdateTimeAndTriggerProgressCallback(syncProgressData, ProgressType::SyncComplete);
 
+	size_t deduplicatedMeshCount = 0;
+	size_t deduplicatedBytes = 0;
+	m_geometryCache.PopStatistics(deduplicatedMeshCount, deduplicatedBytes);
+	if (deduplicatedMeshCount > 0)
+	{
+		LogPrint("Geometry deduplication: %d meshes instanced, %.2f MB saved", int(deduplicatedMeshCount), deduplicatedBytes / (1024.0 * 1024.0));
+	}
+
+	size_t mergedShaderCount = scope.PopMergedShaderCount();
+	if (mergedShaderCount > 0)
+	{
+		LogPrint("Shader deduplication: %d materials merged", int(mergedShaderCount));
+	}
+
 	if (changed)
 	{
+		// lights are culled again on threshold change, and all of them return when culling is turned off
+		if (m_globals.lightCulling)
+		{
+			CullLights();
+		}
+		else if (m_lightCullingChanged)
+		{
+			RestoreCulledLights();
+		}
+
+		m_lightCullingChanged = false;
+
 		UpdateDefaultLights();
 		setCameraAttributeChanged(true);
 	}
@@ -2880,15 +3138,28 @@ std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::high_res
 
 void FireRenderContext::setStartedRendering()
 {
-	m_renderStartTime = GetCurrentChronoTime();
-	m_currentIteration = 0;
+	m_renderStartTime = GetCurrentChronoTime() - std::chrono::seconds(m_resumeSeconds);
+	m_currentIteration = m_resumeIterations;
+	resetNoiseLevel();
+}
+
+void FireRenderContext::setResumeState(int iterations, rpr_uint frameCount, int secondsSpent)
+{
+	m_resumeIterations = iterations;
+	m_resumeFrameCount = frameCount;
+	m_resumeSeconds = secondsSpent;
 }
 
 bool FireRenderContext::keepRenderRunning()
 {
+	if (m_noiseConverged)
+	{
+		return false;
+	}
+
 	// Check if adaptive sampling finished it's work.
 	// At zero iterarion there's no render info for active pixel count.
-	if (m_currentIteration != 0 && GetScope().Context().IsAdaptiveSamplingFinalized())
+	if (m_currentIteration > m_resumeIterations && GetScope().Context().IsAdaptiveSamplingFinalized())
 	{
 		return false;
 	}
@@ -2911,6 +3182,103 @@ bool FireRenderContext::keepRenderRunning()
 	return secondsSpentRendering < m_completionCriteriaParams.getTotalSecondsCount();
 }
 
+void FireRenderContext::resetNoiseLevel()
+{
+	m_noiseEstimator.Reset(m_width, m_height, m_globals.adaptiveTileSize);
+	m_noiseConverged = false;
+	m_noiseFrameBuffer.Reset();
+
+	if (m_completionCriteriaParams.hasNoiseThreshold() && !isNoiseLevelCheckSupported())
+	{
+		LogPrint("Noise threshold is ignored: adaptive sampling is enabled");
+	}
+}
+
+bool FireRenderContext::isNoiseLevelCheckSupported() const
+{
+	// Adaptive sampling stops sampling converged pixels, so the per pixel sample count is not the iteration count
+	// which the half buffer estimate relies on. Adaptive sampling has its own noise threshold
+	return !(m_globals.adaptiveThreshold > 0.0f && isAOVEnabled(RPR_AOV_VARIANCE));
+}
+
+std::vector<float> FireRenderContext::getNoiseEstimateImageData()
+{
+	RPR_THREAD_ONLY;
+
+	RenderStats::Scope statsScope("readback", "Read noise estimate");
+
+	if (!m_noiseFrameBuffer.IsValid())
+	{
+		m_noiseFrameBuffer = frw::FrameBuffer(GetContext(), m_width, m_height, { 4, RPR_COMPONENT_TYPE_FLOAT32 });
+	}
+
+	// normalize only: the tonemapped, gamma corrected color is not linear in the sample count
+	m.framebufferAOV[RPR_AOV_COLOR].Resolve(m_noiseFrameBuffer, true);
+
+	size_t dataSize = 0;
+	auto frstatus = rprFrameBufferGetInfo(m_noiseFrameBuffer.Handle(), RPR_FRAMEBUFFER_DATA, 0, NULL, &dataSize);
+	checkStatus(frstatus);
+
+	std::vector<float> data(m_width * m_height * 4);
+	frstatus = rprFrameBufferGetInfo(m_noiseFrameBuffer.Handle(), RPR_FRAMEBUFFER_DATA, dataSize, data.data(), NULL);
+	checkStatus(frstatus);
+
+	return data;
+}
+
+void FireRenderContext::checkNoiseLevel()
+{
+	RPR_THREAD_ONLY;
+
+	// samples restored from a checkpoint are not in the framebuffer
+	int samples = m_currentIteration - m_resumeIterations;
+
+	if (!m_noiseEstimator.HasSize(m_width, m_height))
+	{
+		resetNoiseLevel();
+	}
+
+	if (m_noiseConverged || !isNoiseLevelCheckSupported() || !m_noiseEstimator.NeedsSample(samples))
+	{
+		return;
+	}
+
+	const float threshold = m_completionCriteriaParams.completionCriteriaNoiseThreshold;
+
+	if (!m_noiseEstimator.Update(getNoiseEstimateImageData(), samples, threshold) ||
+		m_currentIteration < m_completionCriteriaParams.completionCriteriaMinIterations)
+	{
+		return;
+	}
+
+	m_noiseConverged = true;
+
+	// Estimate how long the render would have continued with iteration and time limits only
+	long elapsedMs = TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), m_renderStartTime);
+	long savedMs = -1;
+
+	if (!m_completionCriteriaParams.isUnlimitedIterations())
+	{
+		int remainingIterations = m_completionCriteriaParams.completionCriteriaMaxIterations - m_currentIteration;
+		savedMs = std::max(0L, long(double(elapsedMs) / m_currentIteration * remainingIterations));
+	}
+
+	if (!m_completionCriteriaParams.isUnlimitedTime())
+	{
+		long remainingMs = std::max(0L, m_completionCriteriaParams.getTotalSecondsCount() * 1000L - elapsedMs);
+		savedMs = savedMs < 0 ? remainingMs : std::min(savedMs, remainingMs);
+	}
+
+	LogPrint("Noise threshold %.4f reached at %d iterations in %.1f s: max tile noise %.4f, average %.4f over %d tiles",
+		threshold, m_currentIteration, elapsedMs / 1000.0,
+		m_noiseEstimator.GetMaxTileNoise(), m_noiseEstimator.GetAverageTileNoise(), m_noiseEstimator.GetTileCount());
+
+	if (savedMs >= 0)
+	{
+		LogPrint("Noise threshold: estimated %.1f s saved against iteration and time limits", savedMs / 1000.0);
+	}
+}
+
 bool FireRenderContext::isFirstIterationAndShadersNOTCached() 
 {
     if (isMetalOn())
@@ -3360,12 +3728,10 @@ bool FireRenderContext::ShouldResizeTexture(unsigned int& max_width, unsigned in
 frw::Shader FireRenderContext::GetShader(MObject ob, MObject shadingEngine, const FireRenderMeshCommon* pMesh, bool forceUpdate)
 { 
 	scope.SetContextInfo(this);
+	scope.SetShaderDeduplication(m_globals.deduplicateShaders);
 
-	MFnDependencyNode node(ob);
-
-	frw::Shader shader = scope.GetShader(ob, pMesh, forceUpdate);
-
-	shader.SetName(node.name().asChar());
+	// shader is named by the scope when it is created, a deduplicated shader keeps the name of the first material
+	frw::Shader shader = scope.GetShader(ob, pMesh, forceUpdate, shadingEngine);
 
 	if (!shadingEngine.isNull())
 	{
@@ -3475,6 +3841,8 @@ std::vector<float> FireRenderContext::DenoiseIntoRAM()
 	if (!shouldDenoise)
 		return std::vector<float>();
 
+	RenderStats::Scope statsScope("denoise", "Denoise");
+
 	bool useRAMBuffer = ShouldForceRAMDenoiser();
 
 	// setup params
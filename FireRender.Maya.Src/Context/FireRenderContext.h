@@ -37,6 +37,9 @@ limitations under the License.
 
 #include "FireRenderUtils.h"
 #include "FireRenderContextIFace.h"
+#include "ContextPool.h"
+#include "NoiseEstimator.h"
+#include "Translators/MeshTranslator.h"
 #include <InstancerMASH.h>
 
 // Forward declarations.
@@ -182,6 +185,10 @@ public:
 	void updateMotionBlurParameters(const FireRenderGlobalsData& globalData);
 	void setMotionBlurParameters(const FireRenderGlobalsData& globalData);
 
+	// Setup the hair level of detail
+	void updateHairLODParameters(const FireRenderGlobalsData& globalData);
+	void setHairLODParameters(const FireRenderGlobalsData& globalData);
+
 	/** Return true if the render is interactive (Viewport or IPR). */
 	bool isInteractive() const;
 
@@ -190,10 +197,11 @@ public:
 
 	// Build the scene for the swatch renderer
 	// The scene is composed by a poly-sphere and a single light
-	// \param shaderObj Shader used to render the sphere
-	void initSwatchScene();
+	// \param deviceSettings Render type whose device selection is used to create the context
+	void initSwatchScene(RenderType deviceSettings = RenderType::ProductionRender);
 
-	void UpdateCompletionCriteriaForSwatch();
+	// iterations < 0 means count from render settings
+	void UpdateCompletionCriteriaForSwatch(int iterations = -1);
 
 	// It resets frame buffer and reinitialize it if particular aov is enabled
 	void resetAOV(int index, rpr_GLuint* glTexture);
@@ -511,6 +519,10 @@ public:
 
 	unsigned int motionSamples() const;
 
+	// Check if hair strands should be decimated depending on their screen size
+	bool hairLOD() const { return m_hairLOD; }
+	float hairLODQuality() const { return m_hairLODQuality; }
+
 	// State flag of the renderer
 	StateEnum GetState() const { return m_state; }
 	void SetState(StateEnum newState);
@@ -525,6 +537,12 @@ public:
 
 	void UpdateDefaultLights();
 
+	// Detaches lights whose estimated contribution to the camera view is negligible
+	void CullLights();
+
+	// Attaches back all lights detached by culling
+	void RestoreCulledLights();
+
 	void setRenderMode(RenderMode renderMode);
 
 	virtual void SetupPreviewMode() {}
@@ -541,6 +559,12 @@ public:
 
 	bool IsTileRender(void) const { return (m_globals.tileRenderingEnabled && !isInteractive()); }
 
+	// Returns cache of translated geometry if identical meshes should be instanced, nullptr otherwise
+	FireMaya::MeshTranslator::GeometryCache* GetGeometryCache(void) { return m_globals.deduplicateGeometry ? &m_geometryCache : nullptr; }
+
+	// Called when a mesh drops shapes taken from the geometry cache
+	void ReleaseCachedGeometry(uint64_t hash) { if (hash != 0) m_geometryCache.Release(hash); }
+
 	frw::PostEffect white_balance;
 	frw::PostEffect simple_tonemap;
 	frw::PostEffect tonemap;
@@ -661,6 +685,9 @@ protected:
 
 protected:
 	virtual rpr_int CreateContextInternal(rpr_creation_flags createFlags, rpr_context* pContext) = 0;
+
+	// Plugin id used to key pooled contexts; contexts of classes returning INCORRECT_PLUGIN_ID are never pooled
+	virtual rpr_int GetContextPoolPluginID() const { return INCORRECT_PLUGIN_ID; }
 	virtual void updateTonemapping(const FireRenderGlobalsData&, bool disableWhiteBalance = false) {}
 
 	int getThreadCountToOverride() const;
@@ -721,6 +748,9 @@ private:
 	// Render camera
 	FireRenderCamera m_camera;
 
+	/** translated shapes of unique meshes (used for geometry deduplication), declared before scene objects which release it on destruction **/
+	FireMaya::MeshTranslator::GeometryCache m_geometryCache;
+
 	// map containing all the objects converted
 	FireRenderObjectMap m_sceneObjects;
 
@@ -769,6 +799,10 @@ private:
 	// used for Deformation motion blur only for now
 	unsigned int m_motionSamples;
 
+	// Hair level of detail flag and user quality factor
+	bool m_hairLOD;
+	float m_hairLODQuality;
+
 	/** True if the render should be interactive. */
 	bool m_interactive;
 
@@ -799,6 +833,9 @@ private:
 	/** Signals if denoiser options have changed */
 	bool m_denoiserChanged;
 
+	/** Signals if light culling options have changed */
+	bool m_lightCullingChanged;
+
 	/** True if render layers have changed since the last refresh. */
 	bool m_renderLayersChanged;
 
@@ -807,6 +844,12 @@ private:
 	/** Future object for async cleaning*/
 	std::future<void> m_cleanSceneFuture;
 
+	/** Key of the context pool the rpr context is returned to on cleanScene */
+	ContextPool::Key m_contextPoolKey = { INCORRECT_PLUGIN_ID, 0, 0, 0, std::string() };
+
+	/** True if the rpr context may be returned to the context pool */
+	bool m_contextPoolable = false;
+
 	/** Returns valid context pointer only if we are in the mood to process callbacks */
 	static FireRenderContext* GetCallbackContext(void *clientData)
 	{
@@ -909,6 +952,17 @@ public:
 
 	int	m_currentIteration;
 	rpr_uint m_currentFrame;
+
+	// restored from a render checkpoint
+	int m_resumeIterations = 0;
+	rpr_uint m_resumeFrameCount = 0;
+	int m_resumeSeconds = 0;
+
+	// noise based completion criteria
+	NoiseEstimator m_noiseEstimator;
+	bool m_noiseConverged = false;
+	// color resolved without tonemapping and post effects, the estimator needs linear radiance
+	frw::FrameBuffer m_noiseFrameBuffer;
 	int	m_progress;
 	std::chrono::time_point<std::chrono::system_clock> m_lastRenderStartTime;
 
@@ -923,6 +977,12 @@ public:
 	/* data for athena dumping */
 	double m_secondsSpentOnLastRender;
 	unsigned int m_polycountLastRender;
+
+	// Polygon count of the shapes attached to the scene, maintained by meshes during translation
+	void AddScenePolygonCount(long long delta) { m_scenePolygonCount += delta; }
+	size_t GetScenePolygonCount() const { long long count = m_scenePolygonCount.load(); return count > 0 ? (size_t)count : 0; }
+	std::atomic<long long> m_scenePolygonCount{ 0 };
+
 	enum RenderResultState
 	{
 		COMPLETED = 0,
@@ -936,8 +996,21 @@ public:
 
 	bool isUnlimited();
 	void setStartedRendering();
+
+	// Continue a render restored from a checkpoint: iteration count, sampling sequence and time limit
+	// start from the checkpoint values. Reset with zeros before the next frame
+	void setResumeState(int iterations, rpr_uint frameCount, int secondsSpent);
+	rpr_uint getCurrentFrameCount() const { return m_currentFrame; }
 	bool keepRenderRunning();
 	bool isFirstIterationAndShadersNOTCached();
+
+	// Compares the image against the estimator snapshot at doubling sample counts
+	// and marks the render finished once every tile is below the noise threshold.
+	// Not used with adaptive sampling, which makes per pixel sample counts differ
+	void checkNoiseLevel();
+	bool isNoiseLevelCheckSupported() const;
+	std::vector<float> getNoiseEstimateImageData();
+	void resetNoiseLevel();
 	void updateProgress();
 	int	getProgress();
 	void setProgress(int percents);
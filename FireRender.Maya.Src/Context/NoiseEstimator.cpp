@@ -0,0 +1,150 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#include "NoiseEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// first comparison needs enough samples in both halves for a meaningful difference
+	const int MinSnapshotSamples = 4;
+
+	const int DefaultTileSize = 16;
+
+	float Luminance(const float* pixel)
+	{
+		return 0.2126f * pixel[0] + 0.7152f * pixel[1] + 0.0722f * pixel[2];
+	}
+}
+
+NoiseEstimator::NoiseEstimator() :
+	m_width(0),
+	m_height(0),
+	m_tileSize(DefaultTileSize),
+	m_tileCountX(0),
+	m_tileCountY(0),
+	m_snapshotSamples(0),
+	m_maxTileNoise(0.0f),
+	m_averageTileNoise(0.0f),
+	m_convergedTileCount(0)
+{
+}
+
+void NoiseEstimator::Reset(unsigned int width, unsigned int height, int tileSize)
+{
+	m_width = width;
+	m_height = height;
+	m_tileSize = tileSize > 0 ? tileSize : DefaultTileSize;
+	m_tileCountX = (width + m_tileSize - 1) / m_tileSize;
+	m_tileCountY = (height + m_tileSize - 1) / m_tileSize;
+
+	m_snapshot.clear();
+	m_snapshotSamples = 0;
+
+	m_maxTileNoise = 0.0f;
+	m_averageTileNoise = 0.0f;
+	m_convergedTileCount = 0;
+}
+
+bool NoiseEstimator::NeedsSample(int samples) const
+{
+	if (m_snapshotSamples == 0)
+	{
+		return samples >= MinSnapshotSamples;
+	}
+
+	return samples >= 2 * m_snapshotSamples;
+}
+
+bool NoiseEstimator::Update(const std::vector<float>& data, int samples, float threshold)
+{
+	const size_t pixelCount = size_t(m_width) * m_height;
+
+	if (data.size() != pixelCount * 4 || samples <= m_snapshotSamples)
+	{
+		return false;
+	}
+
+	if (m_snapshotSamples == 0)
+	{
+		m_snapshot.assign(data.begin(), data.begin() + pixelCount * 4);
+		m_snapshotSamples = samples;
+
+		return false;
+	}
+
+	// Weights to extract the second half from the accumulated image, and to scale
+	// the difference of the halves to the standard error of the full image
+	const float n = float(m_snapshotSamples);
+	const float m = float(samples);
+	const float secondHalfScale = m / (m - n);
+	const float firstHalfScale = n / (m - n);
+	const float errorScale = std::sqrt(n * (m - n)) / m;
+
+	m_maxTileNoise = 0.0f;
+	m_convergedTileCount = 0;
+	double noiseSum = 0.0;
+
+	for (int ty = 0; ty < m_tileCountY; ++ty)
+	{
+		for (int tx = 0; tx < m_tileCountX; ++tx)
+		{
+			const unsigned int x0 = tx * m_tileSize;
+			const unsigned int y0 = ty * m_tileSize;
+			const unsigned int x1 = std::min(x0 + m_tileSize, m_width);
+			const unsigned int y1 = std::min(y0 + m_tileSize, m_height);
+
+			double error = 0.0;
+			double luminance = 0.0;
+
+			for (unsigned int y = y0; y < y1; ++y)
+			{
+				for (unsigned int x = x0; x < x1; ++x)
+				{
+					const size_t index = (size_t(y) * m_width + x) * 4;
+					const float* current = &data[index];
+					const float* first = &m_snapshot[index];
+
+					for (int c = 0; c < 3; ++c)
+					{
+						float second = secondHalfScale * current[c] - firstHalfScale * first[c];
+						error += std::fabs(second - first[c]);
+					}
+
+					luminance += std::max(Luminance(current), 0.0f);
+				}
+			}
+
+			const double tilePixels = double(x1 - x0) * (y1 - y0);
+
+			// relative error; sqrt keeps dark tiles from dominating the estimate
+			float noise = float(errorScale * (error / 3.0) / (tilePixels * std::sqrt(luminance / tilePixels + 1e-4)));
+
+			m_maxTileNoise = std::max(m_maxTileNoise, noise);
+			noiseSum += noise;
+
+			if (noise <= threshold)
+			{
+				m_convergedTileCount++;
+			}
+		}
+	}
+
+	m_averageTileNoise = GetTileCount() > 0 ? float(noiseSum / GetTileCount()) : 0.0f;
+
+	m_snapshot.assign(data.begin(), data.begin() + pixelCount * 4);
+	m_snapshotSamples = samples;
+
+	return m_convergedTileCount == GetTileCount();
+}
@@ -0,0 +1,56 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#pragma once
+
+#include <vector>
+
+// Estimates the remaining per-tile noise of a progressive render.
+// The color buffer is captured at doubling sample counts; at sample count m with
+// a snapshot A taken at n samples the image accumulated between n and m is
+// B = (m * I - n * A) / (m - n), an independent estimate of the same pixels.
+// The difference between the two halves gives the error of the current image
+// without rendering to a second pair of framebuffers.
+class NoiseEstimator
+{
+public:
+	NoiseEstimator();
+
+	void Reset(unsigned int width, unsigned int height, int tileSize);
+	bool HasSize(unsigned int width, unsigned int height) const { return m_width == width && m_height == height; }
+
+	// True if the caller should pass the current image to Update at this sample count
+	bool NeedsSample(int samples) const;
+
+	// data is a resolved RGBA image of width * height pixels.
+	// Returns true once every tile is below the threshold
+	bool Update(const std::vector<float>& data, int samples, float threshold);
+
+	float GetMaxTileNoise() const { return m_maxTileNoise; }
+	float GetAverageTileNoise() const { return m_averageTileNoise; }
+	int GetTileCount() const { return m_tileCountX * m_tileCountY; }
+	int GetConvergedTileCount() const { return m_convergedTileCount; }
+
+private:
+	unsigned int m_width;
+	unsigned int m_height;
+	int m_tileSize;
+	int m_tileCountX;
+	int m_tileCountY;
+
+	std::vector<float> m_snapshot;
+	int m_snapshotSamples;
+
+	float m_maxTileNoise;
+	float m_averageTileNoise;
+	int m_convergedTileCount;
+};
@@ -107,6 +107,11 @@ rpr_int TahoeContext::CreateContextInternal(rpr_creation_flags createFlags, rpr_
 	return res;
 }
 
+rpr_int TahoeContext::GetContextPoolPluginID() const
+{
+	return GetPluginID(m_PluginVersion);
+}
+
 void TahoeContext::setupContextContourMode(const FireRenderGlobalsData& fireRenderGlobalsData, int createFlags, bool disableWhiteBalance /*= false*/)
 {
 	frw::Context context = GetContext();
@@ -229,6 +234,11 @@ void TahoeContext::setupContextPostSceneCreation(const FireRenderGlobalsData& fi
 			frstatus = rprContextSetParameterByKey1f(frcontext, RPR_CONTEXT_DEEP_GPU_ALLOCATION_LEVEL, 4);
 			frstatus = rprContextSetParameterByKey1f(frcontext, RPR_CONTEXT_DEEP_COLOR_ENABLED, 1);
 		}
+		else
+		{
+			// pooled context might have been used for deep exr before
+			frstatus = rprContextSetParameterByKey1f(frcontext, RPR_CONTEXT_DEEP_COLOR_ENABLED, 0);
+		}
 	}
 	else if (isInteractive())
 	{
@@ -53,6 +53,7 @@ public:
 
 protected:
 	rpr_int CreateContextInternal(rpr_creation_flags createFlags, rpr_context* pContext) override;
+	rpr_int GetContextPoolPluginID() const override;
 
 	void updateTonemapping(const FireRenderGlobalsData&, bool disableWhiteBalance) override;
 
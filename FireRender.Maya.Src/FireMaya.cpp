@@ -11,23 +11,31 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ********************************************************************/
 #include "FireMaya.h"
+#include "BakedTextureCache.h"
 #include "common.h"
 #include "FireRenderThread.h"
 #include "VRay.h"
 #include "Context/FireRenderContext.h"
+#include "RenderStats.h"
 #include "MayaStandardNodesSupport/NodeConverterUtil.h"
 
+#include <maya/MAnimControl.h>
 #include <maya/MImage.h>
 #include <maya/MPlugArray.h>
 #include <maya/MTextureManager.h>
 #include <maya/MFileIO.h>
+#include <maya/MFileObject.h>
 #include <maya/MSceneMessage.h>
 #include <maya/MFnTypedAttribute.h>
 #include <maya/MUuid.h>
 #include <maya/MItDependencyGraph.h>
 #include <maya/MImageFileInfo.h>
+#include <maya/MObjectHandle.h>
 #include <FireRenderLayeredTextureUtils.h>
 #include <exception>
+#include <algorithm>
+#include <set>
+#include <filesystem>
 
 #ifdef MAYA2017
 #include "maya/MColorManagementUtilities.h"
@@ -874,7 +882,7 @@ frw::Image FireMaya::Scope::GetTiledImage(MString texturePath,
 
 	// store image in image cache
 	if (retImage)
-		m->imageCache[key] = retImage;
+		StoreImage(key, retImage);
 
 	return retImage;
 }
@@ -897,6 +905,8 @@ frw::Image FireMaya::Scope::GetImage(MString texturePath, MString colorSpace, co
 		MAIN_THREAD_ONLY; // MTextureManager will not work in other threads
 		DebugPrint("Loading Image: %s in colorSpace: %s", texturePath.asUTF8(), colorSpace.asUTF8());
 
+		RenderStats::Scope statsScope("texture", "Load image");
+
 		std::string processedTexturePath = ProcessEnvVarsInFilePath<std::string, char>(texturePath.asChar());
 
 		frw::Image image;
@@ -910,7 +920,8 @@ frw::Image FireMaya::Scope::GetImage(MString texturePath, MString colorSpace, co
 
 		if (image)
 		{
-			m->imageCache[key] = image;
+			StoreImage(key, image);
+			RenderStats::AddCount("Textures loaded");
 
 			// recent RPR API is friendly with UTF-8.
 			// RPRS and GLTF lib use RPR Object Name (set with rprObjectSetName) to get image file path for quick export. They support this path as UTF-8.
@@ -1302,7 +1313,7 @@ frw::Image FireMaya::Scope::GetAdjustedImage(MString texturePath,
 			}
 
 		if (image)
-			m->imageCache[key] = image;
+			StoreImage(key, image);
 
 		return image;
 		});
@@ -1315,6 +1326,43 @@ frw::Value FireMaya::Scope::ParseValue(MObject node, const MString &outPlugName)
 		return nullptr;
 	}
 
+	// outside of shader parsing values are not cached
+	if (m->m_currentlyParsedShaderId.empty())
+	{
+		return ConvertValue(node, outPlugName);
+	}
+
+	// values are cached per shader, so when a node of the network is dirtied
+	// only that node and values downstream of it are converted again
+	std::string nodeId = getNodeUUid(node);
+	NodeId valueId = m->m_currentlyParsedShaderId + "|" + nodeId + "|" + outPlugName.asChar();
+
+	const NodeId& consumerId = m->m_valueParseStack.empty() ? m->m_currentlyParsedShaderId : m->m_valueParseStack.back();
+	m->valueDependents[valueId].insert(consumerId);
+
+	frw::Value value = GetCachedValue(valueId);
+	if (value)
+	{
+		return value;
+	}
+
+	RegisterCallback(node);
+
+	m->m_valueParseStack.push_back(valueId);
+	value = ConvertValue(node, outPlugName);
+	m->m_valueParseStack.pop_back();
+
+	if (value)
+	{
+		SetCachedValue(valueId, value);
+		m->nodeValues[nodeId].insert(valueId);
+	}
+
+	return value;
+}
+
+frw::Value FireMaya::Scope::ConvertValue(MObject node, const MString &outPlugName) const
+{
 	MFnDependencyNode shaderNode(node);
 
 	// handle native fire render value nodes
@@ -1407,12 +1455,110 @@ bool FireMaya::Scope::FindFileNodeRecursive(MObject objectNode, int& width, int&
 	return false;
 }
 
+namespace
+{
+	// Bakes plug of the shader node into 8 bit RGB image using MTextureManager
+	bool BakeShaderNodePlug(const MFnDependencyNode& shaderNode, const MString& plugName, int width, int height, std::vector<unsigned char>& outPixels)
+	{
+		MAIN_THREAD_ONLY; // MTextureManager will not work in other threads
+
+		auto renderer = MHWRender::MRenderer::theRenderer();
+		auto textureManager = renderer ? renderer->getTextureManager() : nullptr;
+		if (!textureManager)
+			return false;
+
+		// Get first output connection to cover such cases as outputColor, outputValue etc.
+		MPlug outColorPlug = shaderNode.findPlug(plugName);
+
+		auto texture = textureManager->acquireTexture("", outColorPlug, width, height, false);
+		if (!texture)
+			return false;
+
+		bool result = false;
+
+#if MAYA_API_VERSION >= 20180000
+		size_t slicePitch = 0;
+#else
+		int slicePitch = 0;
+#endif
+		int rowPitch = 0;
+		if (auto pixelData = static_cast<const unsigned char*>(texture->rawData(rowPitch, slicePitch)))
+		{
+			outPixels.assign(width * height * 3, 128);
+
+			for (int v = 0; v < height; v++)
+			{
+				auto src = pixelData + v * rowPitch;
+				auto dst = outPixels.data() + (height - v - 1) * width * 3;
+				for (int u = 0; u < width; u++)
+				{
+					*(dst++) = *(src++);
+					*(dst++) = *(src++);
+					*(dst++) = *(src++);
+					src++;
+				}
+			}
+
+			result = true;
+#ifndef MAYA2015
+			texture->freeRawData((void*)pixelData);
+#else
+			free((void*)pixelData);
+#endif
+		}
+
+		textureManager->releaseTexture(texture);
+
+		return result;
+	}
+}
+
+void FireMaya::Scope::RebakeShaderNodeDeferred(MObject node, MString plugName, int width, int height)
+{
+	static std::set<std::string> pendingRebakes;
+
+	MFnDependencyNode shaderNode(node);
+	std::string rebakeId = std::string(shaderNode.uuid().asString().asChar()) + plugName.asChar() + std::to_string(width) + "x" + std::to_string(height);
+	if (!pendingRebakes.insert(rebakeId).second)
+		return;
+
+	MObjectHandle nodeHandle(node);
+
+	FireRenderThread::KeepRunningOnMainThread([nodeHandle, plugName, width, height, rebakeId]() -> bool
+	{
+		pendingRebakes.erase(rebakeId);
+
+		if (!nodeHandle.isValid())
+			return false;
+
+		MObject node = nodeHandle.object();
+		MFnDependencyNode shaderNode(node);
+
+		uint64_t networkHash = GetShadingNetworkHash(node);
+
+		std::vector<unsigned char> pixels;
+		if (BakeShaderNodePlug(shaderNode, plugName, width, height, pixels))
+		{
+			BakedTextureCache::GetInstance().Store(shaderNode.uuid().asString(), plugName, width, height, networkHash, pixels);
+
+			// shaders using the node are re-parsed and pick up the fresh bake
+			MGlobal::executeCommandOnIdle("dgdirty " + shaderNode.name());
+		}
+
+		return false;
+	});
+}
+
 frw::Value FireMaya::Scope::createImageFromShaderNode(MObject node, MString plugName, int width, int height) const
 {
 	unsigned int max_width = 1;
 	unsigned int max_height = 1;
 	bool shouldResize = GetIContextInfo() && GetIContextInfo()->ShouldResizeTexture(max_width, max_height);
 
+	// interactive renders may use outdated bake while the new one is being made
+	bool allowStaleBake = GetIContextInfo() &&
+		(GetIContextInfo()->GetRenderType() == RenderType::IPR || GetIContextInfo()->GetRenderType() == RenderType::ViewportRender);
+
 	return FireRenderThread::RunOnMainThread<frw::Value>([&]()
 	{
 		if (shouldResize)
@@ -1442,72 +1588,51 @@ frw::Value FireMaya::Scope::createImageFromShaderNode(MObject node, MString plug
 			}
 		}
 
-		// not in cache => create new image
-		if (auto renderer = MHWRender::MRenderer::theRenderer())
-		{
-			if (auto textureManager = renderer->getTextureManager())
-			{
-				// Get first output connection to cover such cases as outputColor, outputValue etc.
-			
-				MPlug outColorPlug = shaderNode.findPlug(plugName);
+		// not in cache => load baked image from disk or bake new one
+		uint64_t networkHash = GetShadingNetworkHash(node);
 
-				if (auto texture = textureManager->acquireTexture("", outColorPlug, width, height, false))
-				{
-					std::vector<unsigned char> buffer(width * height * 3, 128);
+		BakedTextureCache& bakedTextureCache = BakedTextureCache::GetInstance();
+		std::vector<unsigned char> buffer;
+		bool isStale = false;
 
-#if MAYA_API_VERSION >= 20180000
-					size_t slicePitch = 0;
-#else
-					int slicePitch = 0;
-#endif
-					int rowPitch = 0;
-					if (auto pixelData = static_cast<const unsigned char*>(texture->rawData(rowPitch, slicePitch)))
-					{
-						for (int v = 0; v < height; v++)
-						{
-							auto src = pixelData + v * rowPitch;
-							auto dst = buffer.data() + (height - v - 1) * width * 3;
-							for (int u = 0; u < width; u++)
-							{
-								*(dst++) = *(src++);
-								*(dst++) = *(src++);
-								*(dst++) = *(src++);
-								src++;
-							}
-						}
-
-						rpr_image_desc img_desc = {};
-						img_desc.image_width = width;
-						img_desc.image_height = height;
-						img_desc.image_row_pitch = width * 3;
+		if (bakedTextureCache.Load(uid_str, plugName, width, height, networkHash, allowStaleBake, buffer, isStale))
+		{
+			if (isStale)
+			{
+				RebakeShaderNodeDeferred(node, plugName, width, height);
+			}
+		}
+		else if (BakeShaderNodePlug(shaderNode, plugName, width, height, buffer))
+		{
+			bakedTextureCache.Store(uid_str, plugName, width, height, networkHash, buffer);
+		}
+		else
+		{
+			DebugPrint("WARNING: Can't create image from ShaderNode");
+			return ret;
+		}
 
-						frw::Image image(m->context, { 3, RPR_COMPONENT_TYPE_UINT8 }, img_desc, buffer.data());
+		rpr_image_desc img_desc = {};
+		img_desc.image_width = width;
+		img_desc.image_height = height;
+		img_desc.image_row_pitch = width * 3;
 
-						frw::ImageNode imageNode(m->materialSystem);
-						imageNode.SetMap(image);
-						//we are not setting UV input because it is already baked into image.
+		frw::Image image(m->context, { 3, RPR_COMPONENT_TYPE_UINT8 }, img_desc, buffer.data());
 
-						ret = imageNode;
+		frw::ImageNode imageNode(m->materialSystem);
+		imageNode.SetMap(image);
+		//we are not setting UV input because it is already baked into image.
 
-						SetCachedImage(uid, image);
-#ifndef MAYA2015
-						texture->freeRawData((void*)pixelData);
-#else
-						free((void*)pixelData);
-#endif
-					}
+		ret = imageNode;
 
-					textureManager->releaseTexture(texture);
-				}
-			}
+		if (!isStale)
+		{
+			SetCachedImage(uid, image);
 		}
 
-		if (!ret)
-			DebugPrint("WARNING: Can't create image from ShaderNode");
-
 		return ret;
-		});
-	}
+	});
+}
 
 frw::Value FireMaya::Scope::CosinePowerToRoughness(const frw::Value &power)
 {
@@ -1790,13 +1915,15 @@ frw::Shader FireMaya::Scope::ParseVolumeShader(MObject node)
 }
 
 
-void FireMaya::Scope::RegisterCallback(MObject node, std::string* pOverridenUUID /*= nullptr*/)
+void FireMaya::Scope::RegisterCallback(MObject node, std::string* pOverridenUUID /*= nullptr*/) const
 {
+	void* clientData = const_cast<Scope*>(this);
+
 	if (pOverridenUUID != nullptr)
 	{
 		if (m->m_nodeDirtyCallbacks.find(*pOverridenUUID) == m->m_nodeDirtyCallbacks.end())
 		{
-			m->m_nodeDirtyCallbacks[*pOverridenUUID] = MNodeMessage::addNodeDirtyCallback(node, NodeDirtyCallback, this);
+			m->m_nodeDirtyCallbacks[*pOverridenUUID] = MNodeMessage::addNodeDirtyCallback(node, NodeDirtyCallback, clientData);
 		}
 
 		return;
@@ -1805,7 +1932,7 @@ void FireMaya::Scope::RegisterCallback(MObject node, std::string* pOverridenUUID
 	std::string uuid = getNodeUUid(node);
 	if (m->m_nodeDirtyCallbacks.find(uuid) == m->m_nodeDirtyCallbacks.end())
 	{
-		m->m_nodeDirtyCallbacks[uuid] = MNodeMessage::addNodeDirtyCallback(node, NodeDirtyCallback, this);
+		m->m_nodeDirtyCallbacks[uuid] = MNodeMessage::addNodeDirtyCallback(node, NodeDirtyCallback, clientData);
 	}
 }
 
@@ -1826,6 +1953,20 @@ void FireMaya::Scope::NodeDirtyCallback(MObject& ob)
 		if (auto shader = GetCachedVolumeShader(shaderId)) {
 			shader.SetDirty(true);
 		}
+
+		// drop values converted from this node together with everything built from them
+		auto it = m->nodeValues.find(getNodeUUid(ob));
+		if (it != m->nodeValues.end())
+		{
+			std::set<NodeId> valueIds;
+			valueIds.swap(it->second);
+			m->nodeValues.erase(it);
+
+			for (const NodeId& valueId : valueIds)
+			{
+				InvalidateCachedValue(valueId);
+			}
+		}
 	}
 	catch (const std::exception & ex)
 	{
@@ -1900,7 +2041,7 @@ frw::Value FireMaya::Scope::GetCachedValue(const NodeId& id) const
 	return nullptr;
 }
 
-void FireMaya::Scope::SetCachedValue(const NodeId& id, frw::Value v)
+void FireMaya::Scope::SetCachedValue(const NodeId& id, frw::Value v) const
 {
 	if (!v)
 		m->valueMap.erase(id);
@@ -1908,6 +2049,43 @@ void FireMaya::Scope::SetCachedValue(const NodeId& id, frw::Value v)
 		m->valueMap[id] = v;
 }
 
+void FireMaya::Scope::InvalidateCachedValue(const NodeId& id)
+{
+	m->valueMap.erase(id);
+
+	auto it = m->valueDependents.find(id);
+	if (it == m->valueDependents.end())
+		return;
+
+	std::set<NodeId> dependents;
+	dependents.swap(it->second);
+	m->valueDependents.erase(it);
+
+	for (const NodeId& dependentId : dependents)
+	{
+		if (auto shader = GetCachedShader(dependentId))
+		{
+			shader.SetDirty(true);
+		}
+		else
+		{
+			InvalidateCachedValue(dependentId);
+		}
+	}
+}
+
+void FireMaya::Scope::InvalidateCachedShaderValues(const NodeId& shaderId)
+{
+	NodeId prefix = shaderId + "|";
+
+	auto begin = m->valueMap.lower_bound(prefix);
+	auto end = begin;
+	while (end != m->valueMap.end() && end->first.compare(0, prefix.length(), prefix) == 0)
+		++end;
+
+	m->valueMap.erase(begin, end);
+}
+
 frw::Image FireMaya::Scope::GetCachedImage(const MString& key) const
 {
 	auto it = m->imageCache.find(std::string(key.asChar()));
@@ -1920,10 +2098,36 @@ frw::Image FireMaya::Scope::GetCachedImage(const MString& key) const
 
 void FireMaya::Scope::SetCachedImage(const MString& key, frw::Image img) const
 {
+	StoreImage(key.asChar(), img);
+}
+
+void FireMaya::Scope::StoreImage(const std::string& key, frw::Image img) const
+{
+	// keep the total size of cached images up to date, so render statistics don't need to query every image
+	auto sizeIt = m->imageSizes.find(key);
+	if (sizeIt != m->imageSizes.end())
+	{
+		m->cachedImageBytes -= sizeIt->second;
+		m->imageSizes.erase(sizeIt);
+	}
+
 	if (!img)
-		m->imageCache.erase(std::string(key.asChar()));
-	else
-		m->imageCache[std::string(key.asChar())] = img;
+	{
+		m->imageCache.erase(key);
+		return;
+	}
+
+	size_t dataSize = 0;
+	rprImageGetInfo(img.Handle(), RPR_IMAGE_DATA_SIZEBYTE, sizeof(dataSize), &dataSize, nullptr);
+
+	m->imageCache[key] = img;
+	m->imageSizes[key] = (long long)dataSize;
+	m->cachedImageBytes += (long long)dataSize;
+}
+
+std::tuple<size_t, long long> FireMaya::Scope::GetCachedImagesCountAndSize() const
+{
+	return std::make_tuple(m->imageCache.size(), m->cachedImageBytes);
 }
 
 FireMaya::Scope::Scope()
@@ -1937,7 +2141,7 @@ FireMaya::Scope::~Scope()
 }
 
 
-frw::Shader FireMaya::Scope::GetShader(MObject node, const FireRenderMeshCommon* pMesh, bool forceUpdate)
+frw::Shader FireMaya::Scope::GetShader(MObject node, const FireRenderMeshCommon* pMesh, bool forceUpdate, MObject shadingEngine)
 {
 	if (node.isNull())
 	{
@@ -1963,15 +2167,59 @@ frw::Shader FireMaya::Scope::GetShader(MObject node, const FireRenderMeshCommon*
 		RegisterCallback(node, &shaderId);
 	}
 
+	// reuse shader of an identical shading network if there is one
+	uint64_t fingerprint = 0;
+	std::string network;
+	if (m->deduplicateShaders)
+	{
+		fingerprint = GetShaderFingerprint(node, shadingEngine, network);
+
+		// fingerprint only selects the candidate, networks have to be equal as well
+		auto it = m->fingerprintShaderMap.find(fingerprint);
+		if (!forceUpdate && it != m->fingerprintShaderMap.end() && it->second.network == network &&
+			it->second.shader.IsValid() && !it->second.shader.IsDirty())
+		{
+			frw::Shader& mergedShader = it->second.shader;
+			if (!(shader == mergedShader))
+			{
+				DebugPrint("Shader %s merged with identical shading network", shaderId.c_str());
+				m->mergedShaderCount++;
+			}
+
+			SetCachedShader(shaderId, mergedShader);
+			return mergedShader;
+		}
+	}
+
 	DebugPrint("Parsing shader: %s (forceUpdate=%d, shader.IsDirty()=%d)", shaderId.c_str(), forceUpdate, shader.IsDirty());
 	m->m_pCurrentlyParsedMesh = pMesh;
 
-	// create now
+	// forced update may depend on mesh data, so nothing is reused
+	if (forceUpdate)
+	{
+		InvalidateCachedShaderValues(shaderId);
+	}
+
+	// create now (shaders may be nested, e.g. in blend material)
+	NodeId parentShaderId = m->m_currentlyParsedShaderId;
+	std::vector<NodeId> parentValueParseStack;
+	parentValueParseStack.swap(m->m_valueParseStack);
+	m->m_currentlyParsedShaderId = shaderId;
+
 	shader = ParseShader(node);
+
+	m->m_currentlyParsedShaderId = parentShaderId;
+	m->m_valueParseStack.swap(parentValueParseStack);
 	if (shader.IsValid())
 	{
+		shader.SetName(shdrName.c_str());
 		SetCachedShader(shaderId, shader);
 		shader.SetDirty(false);
+
+		if (m->deduplicateShaders)
+		{
+			m->fingerprintShaderMap[fingerprint] = { std::move(network), shader };
+		}
 	}
 
 	m->m_pCurrentlyParsedMesh = nullptr;
@@ -2008,6 +2256,177 @@ frw::Shader FireMaya::Scope::GetShadowCatcherShader()
 	return nullptr;
 }
 
+size_t FireMaya::Scope::PopMergedShaderCount()
+{
+	size_t count = m->mergedShaderCount;
+	m->mergedShaderCount = 0;
+
+	return count;
+}
+
+namespace
+{
+	const uint64_t FnvOffsetBasis = 14695981039346656037ULL;
+	const uint64_t FnvPrime = 1099511628211ULL;
+
+	void HashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= FnvPrime;
+		}
+	}
+
+	// modification time and size of the file, so that editing a texture on disk changes the description
+	void DescribeFileStamp(std::string& description, const MString& path)
+	{
+		if (path.length() == 0)
+			return;
+
+		MFileObject fileObject;
+		fileObject.setRawFullName(path);
+
+		std::error_code errorCode;
+		std::filesystem::path filePath = std::filesystem::u8path(fileObject.resolvedFullName().asUTF8());
+
+		std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(filePath, errorCode);
+		if (errorCode)
+			return;
+
+		uint64_t fileSize = std::filesystem::file_size(filePath, errorCode);
+		if (errorCode)
+			return;
+
+		description += "file " + std::to_string(writeTime.time_since_epoch().count()) + " " + std::to_string(fileSize) + "\n";
+	}
+}
+
+std::string FireMaya::Scope::DescribeShadingNode(MObject ob, std::map<std::string, std::string>& visited)
+{
+	std::string nodeId = getNodeUUid(ob);
+
+	auto it = visited.find(nodeId);
+	if (it != visited.end())
+	{
+		return it->second;
+	}
+
+	// placeholder breaks cycles in the network
+	visited[nodeId] = "cycle\n";
+
+	MFnDependencyNode fnNode(ob);
+
+	std::string description = std::string(fnNode.typeName().asChar()) + "\n";
+
+	// animation curves, expressions and time nodes change the network output from frame to frame without changing any attribute
+	if (ob.hasFn(MFn::kAnimCurve) || ob.hasFn(MFn::kExpression) || ob.hasFn(MFn::kTime))
+	{
+		double time = MAnimControl::currentTime().as(MTime::kSeconds);
+
+		char timeStr[32] = {};
+		snprintf(timeStr, sizeof(timeStr), "%a", time);
+		description += std::string("time ") + timeStr + "\n";
+	}
+
+	// values of input attributes which differ from default (texture paths are included here as well)
+	for (unsigned int i = 0; i < fnNode.attributeCount(); i++)
+	{
+		MObject attribute = fnNode.attribute(i);
+		MFnAttribute fnAttribute(attribute);
+
+		if (!fnAttribute.parent().isNull() || !fnAttribute.isStorable() || !fnAttribute.isWritable())
+			continue;
+
+		MPlug plug = fnNode.findPlug(attribute, false);
+
+		if (fnAttribute.isUsedAsFilename() && !plug.isNull())
+		{
+			DescribeFileStamp(description, plug.asString());
+		}
+
+		MStringArray setAttrCmds;
+		if (plug.isNull() || plug.getSetAttrCmds(setAttrCmds, MPlug::kChanged) != MStatus::kSuccess)
+			continue;
+
+		for (unsigned int j = 0; j < setAttrCmds.length(); j++)
+		{
+			description += setAttrCmds[j].asChar();
+			description += "\n";
+		}
+	}
+
+	// upstream connections, sorted so the order in which Maya reports them does not matter
+	MPlugArray connections;
+	fnNode.getConnections(connections);
+
+	std::vector<std::string> inputs;
+	for (unsigned int i = 0; i < connections.length(); i++)
+	{
+		MPlugArray sources;
+		connections[i].connectedTo(sources, true, false);
+
+		for (unsigned int j = 0; j < sources.length(); j++)
+		{
+			std::string input = std::string("input ") + connections[i].partialName(false, true, false, false, true, true).asChar() +
+				" " + sources[j].partialName(false, true, false, false, true, true).asChar() + "\n{\n";
+
+			input += DescribeShadingNode(sources[j].node(), visited);
+			input += "}\n";
+
+			inputs.push_back(std::move(input));
+		}
+	}
+
+	std::sort(inputs.begin(), inputs.end());
+	for (const std::string& input : inputs)
+	{
+		description += input;
+	}
+
+	visited[nodeId] = description;
+
+	return description;
+}
+
+uint64_t FireMaya::Scope::GetShadingNetworkHash(MObject ob)
+{
+	std::string description = GetShadingNetworkDescription(ob);
+
+	uint64_t hash = FnvOffsetBasis;
+	HashBytes(hash, description.data(), description.size());
+
+	return hash;
+}
+
+std::string FireMaya::Scope::GetShadingNetworkDescription(MObject ob)
+{
+	std::map<std::string, std::string> visited;
+	return DescribeShadingNode(ob, visited);
+}
+
+uint64_t FireMaya::Scope::GetShaderFingerprint(MObject ob, MObject shadingEngine, std::string& outNetwork) const
+{
+	std::map<std::string, std::string> visited;
+	outNetwork = DescribeShadingNode(ob, visited);
+
+	// material id is set on the shader itself so materials with different ids can't be shared
+	if (!shadingEngine.isNull())
+	{
+		MPlug materialIdPlug = MFnDependencyNode(shadingEngine).findPlug("rmi", false);
+		if (!materialIdPlug.isNull())
+		{
+			outNetwork += "materialId " + std::to_string(materialIdPlug.asInt()) + "\n";
+		}
+	}
+
+	uint64_t hash = FnvOffsetBasis;
+	HashBytes(hash, outNetwork.data(), outNetwork.size());
+
+	return hash;
+}
+
 frw::Shader FireMaya::Scope::GetReflectionCatcherShader()
 {
 	for (auto shader : m->shaderMap)
@@ -2162,7 +2581,10 @@ frw::Shader FireMaya::Scope::GetVolumeShader(MPlug plug)
 }
 
 FireMaya::Scope::Data::Data()
-	: m_pCurrentlyParsedMesh(nullptr)
+	: deduplicateShaders(false)
+	, mergedShaderCount(0)
+	, cachedImageBytes(0)
+	, m_pCurrentlyParsedMesh(nullptr)
 {
 }
 
@@ -2185,6 +2607,7 @@ FireMaya::Scope::Data::~Data()
 	context.Reset();
 
 	// delete shaders
+	fingerprintShaderMap.clear();
 	shaderMap.clear();
 
 	// everything else destroyed automatically
@@ -2196,12 +2619,17 @@ void FireMaya::Scope::Reset()
 }
 
 void FireMaya::Scope::Init(rpr_context handle, bool destroyMaterialSystemOnDelete, bool createScene)
+{
+	Init(frw::Context(handle), destroyMaterialSystemOnDelete, createScene);
+}
+
+void FireMaya::Scope::Init(frw::Context context, bool destroyMaterialSystemOnDelete, bool createScene)
 {
 	RPR_THREAD_ONLY;
 
 	m = std::make_shared<Data>();
 
-	m->context = frw::Context(handle);
+	m->context = context;
 	m->materialSystem = frw::MaterialSystem(m->context, nullptr, destroyMaterialSystemOnDelete);
 
 	if (createScene)
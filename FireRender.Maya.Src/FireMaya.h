@@ -23,6 +23,11 @@ limitations under the License.
 #include <maya/MNodeMessage.h>
 #include "Context/FireRenderContextIFace.h"
 
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+
 class FireRenderMeshCommon;
 
 namespace FireMaya
@@ -206,11 +211,29 @@ namespace FireMaya
 			std::map<NodeId, frw::Shader> volumeShaderMap;
 			std::map<NodeId, frw::Shader> shaderMap;
 			std::map<NodeId, frw::Value> valueMap;
+			// values (or shaders) built from given value, they are invalidated together with it
+			std::map<NodeId, std::set<NodeId>> valueDependents;
+			// cached values by maya node uuid
+			std::map<std::string, std::set<NodeId>> nodeValues;
 			std::map<NodeId, MCallbackId> m_nodeDirtyCallbacks;
 			std::map<NodeId, MCallbackId> m_AttributeChangedCallbacks;
 			std::map<std::string, frw::Image> imageCache;
+			std::map<std::string, long long> imageSizes;
+			long long cachedImageBytes;
+
+			// shaders shared by structurally identical shading networks
+			struct FingerprintShader
+			{
+				std::string network;
+				frw::Shader shader;
+			};
+			std::map<uint64_t, FingerprintShader> fingerprintShaderMap;
+			bool deduplicateShaders;
+			size_t mergedShaderCount;
 
 			FireRenderMeshCommon const* m_pCurrentlyParsedMesh; // is not supposed to keep any data outside of during mesh parsing 
+			NodeId m_currentlyParsedShaderId; // values are cached only while parsing a shader
+			std::vector<NodeId> m_valueParseStack;
 
 			Data();
 			~Data();
@@ -219,7 +242,7 @@ namespace FireMaya
 
 		DataPtr m;
 
-		void RegisterCallback(MObject node, std::string* pOverridenUUID = nullptr);
+		void RegisterCallback(MObject node, std::string* pOverridenUUID = nullptr) const;
 
 		IFireRenderContextInfo* m_pContextInfo; // Scope can not exist without a context, thus using raw pointer here is safe
 
@@ -246,15 +269,28 @@ namespace FireMaya
 		void SetCachedVolumeShader( const NodeId& str, frw::Shader shader );
 
 		frw::Value GetCachedValue(const NodeId& str) const;
-		void SetCachedValue(const NodeId& str, frw::Value shader);
+		void SetCachedValue(const NodeId& str, frw::Value shader) const;
+		void InvalidateCachedValue(const NodeId& str);
+		void InvalidateCachedShaderValues(const NodeId& shaderId);
 
 		frw::Image GetCachedImage(const MString& key) const;
 		void SetCachedImage(const MString& key, frw::Image img) const;
+		void StoreImage(const std::string& key, frw::Image img) const;
 
 		frw::Shader ParseVolumeShader( MObject ob );
 		frw::Shader ParseShader(MObject ob);
 
 		frw::Value ParseValue(MObject ob, const MString &outPlugName) const;
+		frw::Value ConvertValue(MObject ob, const MString &outPlugName) const;
+
+		// Structural fingerprint of the shading network (node types, attribute values, texture paths and connections),
+		// outNetwork is the whole description the fingerprint is computed from
+		uint64_t GetShaderFingerprint(MObject ob, MObject shadingEngine, std::string& outNetwork) const;
+		// Canonical text description of the network upstream of the node, equal only for structurally identical networks
+		static std::string DescribeShadingNode(MObject ob, std::map<std::string, std::string>& visited);
+
+		// Bakes the plug again when the main thread is idle and stores it in the disk cache
+		static void RebakeShaderNodeDeferred(MObject node, MString plugName, int width, int height);
 
 		bool FindFileNodeRecursive(MObject objectNode, int& width, int& height) const;
 
@@ -280,16 +316,27 @@ namespace FireMaya
 		~Scope();
 
 		// by object
-		frw::Shader GetShader(MObject ob, const FireRenderMeshCommon* pMesh = nullptr, bool forceUpdate = false);
+		frw::Shader GetShader(MObject ob, const FireRenderMeshCommon* pMesh = nullptr, bool forceUpdate = false, MObject shadingEngine = MObject());
 		frw::Shader GetShader(MPlug ob);
 		frw::Shader GetShadowCatcherShader();
 		frw::Shader GetReflectionCatcherShader();
 
+		void SetShaderDeduplication(bool enable) { m->deduplicateShaders = enable; }
+		// Hash of node types, attribute values and connections of the network upstream of the node (and of current time if it is animated)
+		static uint64_t GetShadingNetworkHash(MObject ob);
+		// Description the network hash is computed from, equal descriptions mean structurally identical networks
+		static std::string GetShadingNetworkDescription(MObject ob);
+		// Returns count of materials merged into an already existing shader since last call
+		size_t PopMergedShaderCount();
+
 		frw::Shader GetVolumeShader( MObject ob, bool forceUpdate = false );
 		frw::Shader GetVolumeShader( MPlug ob );
 
 		frw::Image GetImage(MString path, MString colorSpace, const MString& ownerNodeName) const;
 
+		// Count and data size of the images loaded for the scene
+		std::tuple<size_t, long long> GetCachedImagesCountAndSize() const;
+
 		frw::Image GetTiledImage(MString texturePath, 
 			int viewWidth, int viewHeight,
 			int maxTileWidth, int maxTileHeight,
@@ -330,6 +377,7 @@ namespace FireMaya
 
 		void Reset();
 		void Init(rpr_context handle, bool destroyMaterialSystemOnDelete = true, bool createScene = true);
+		void Init(frw::Context context, bool destroyMaterialSystemOnDelete = true, bool createScene = true);
 		void CreateScene(void);
 
 		void SetContextInfo (IFireRenderContextInfo* pCtxInfo);
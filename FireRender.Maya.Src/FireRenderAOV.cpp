@@ -230,7 +230,7 @@ bool FireRenderAOV::IsValid(const FireRenderContext& context) const
 }
 
 // -----------------------------------------------------------------------------
-void FireRenderAOV::readFrameBuffer(FireRenderContext& context)
+void FireRenderAOV::readFrameBuffer(FireRenderContext& context, bool addRenderStamp)
 {
 	// Check that the AOV is active and in a valid state.
 	if (!active || !pixels || m_region.isZeroArea() || !context.IsAOVSupported(id))
@@ -265,6 +265,18 @@ void FireRenderAOV::readFrameBuffer(FireRenderContext& context)
 
 	PostProcess();
 
+	if (addRenderStamp)
+	{
+		applyRenderStamp(context);
+	}
+}
+
+// -----------------------------------------------------------------------------
+void FireRenderAOV::applyRenderStamp(FireRenderContext& context)
+{
+	if (!active || !pixels || id == RPR_AOV_DEEP_COLOR)
+		return;
+
 	// Render stamp, but only when region matches the whole frame buffer
 	if (m_region.getHeight() == m_frameHeight && m_region.getWidth() == m_frameWidth && renderStamp.numChars() > 0 && !context.IsTileRender())
 	{
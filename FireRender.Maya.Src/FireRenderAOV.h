@@ -151,8 +151,11 @@ public:
 	/** Free pixels for active AOVs. */
 	void freePixels();
 
-	/** Read the frame buffer pixels for this AOV. */
-	void readFrameBuffer(FireRenderContext& context);
+	/** Read the frame buffer pixels for this AOV, optionally without the render stamp. */
+	void readFrameBuffer(FireRenderContext& context, bool addRenderStamp = true);
+
+	/** Draw the render stamp over the AOV pixels. */
+	void applyRenderStamp(FireRenderContext& context);
 
 	/** Send the AOV pixels to the Maya render view. */
 	void sendToRenderView();
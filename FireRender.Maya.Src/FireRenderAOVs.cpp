@@ -17,6 +17,7 @@ limitations under the License.
 #include "Context/FireRenderContext.h"
 #include "FireRenderImageUtil.h"
 #include "FireMaya.h"
+#include "RenderStats.h"
 
 #include <maya/MStatus.h>
 #include <maya/MFnEnumAttribute.h>
@@ -364,15 +365,24 @@ void FireRenderAOVs::setRenderStamp(const MString& renderStamp)
 }
 
 // -----------------------------------------------------------------------------
-void FireRenderAOVs::readFrameBuffers(FireRenderContext& context)
+void FireRenderAOVs::readFrameBuffers(FireRenderContext& context, bool addRenderStamp)
 {
 	for (auto& aov : m_aovs)
-		aov.second->readFrameBuffer(context);
+		aov.second->readFrameBuffer(context, addRenderStamp);
+}
+
+// -----------------------------------------------------------------------------
+void FireRenderAOVs::applyRenderStamp(FireRenderContext& context)
+{
+	for (auto& aov : m_aovs)
+		aov.second->applyRenderStamp(context);
 }
 
 // -----------------------------------------------------------------------------
 void FireRenderAOVs::writeToFile(FireRenderContext& context, const MString& filePath, unsigned int imageFormat, FireRenderAOV::FileWrittenCallback fileWrittenCallback)
 {
+	RenderStats::Scope statsScope("output", "Write image files");
+
 	// Check if only the color AOV is active.
 	const bool colorOnly = getActiveAOVCount() == 1;
 
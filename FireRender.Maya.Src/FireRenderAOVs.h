@@ -75,8 +75,11 @@ public:
 	/** Free pixels for active AOVs. */
 	void freePixels();
 
-	/** Read the frame buffer pixels for all active AOVs. */
-	void readFrameBuffers(FireRenderContext& context);
+	/** Read the frame buffer pixels for all active AOVs, optionally without the render stamp. */
+	void readFrameBuffers(FireRenderContext& context, bool addRenderStamp = true);
+
+	/** Draw the render stamp over the pixels of all active AOVs. */
+	void applyRenderStamp(FireRenderContext& context);
 
 	/** Write the active AOVs to file. */
 	void writeToFile(FireRenderContext& context, const MString& filePath, unsigned int imageFormat, FireRenderAOV::FileWrittenCallback fileWrittenCallback = nullptr);
@@ -36,6 +36,7 @@ limitations under the License.
 
 #include <iomanip>
 #include <regex>
+#include <filesystem>
 
 #include <maya/MIOStream.h>
 #include <maya/MFileObject.h>
@@ -45,6 +46,8 @@ limitations under the License.
 #include "RenderRegion.h"
 #include "FireRenderThread.h"
 #include "RenderStampUtils.h"
+#include "RenderCheckpoint.h"
+#include "RenderStats.h"
 
 #include "Context/ContextCreator.h"
 
@@ -95,6 +98,9 @@ MSyntax FireRenderCmd::newSyntax()
 	CHECK_MSTATUS(syntax.addFlag(kWaitForIt, kWaitForItLong, MSyntax::kNoArg));
 	CHECK_MSTATUS(syntax.addFlag(kWaitForItTwoStep, kWaitForItTwoStepLong, MSyntax::kNoArg));
 	CHECK_MSTATUS(syntax.addFlag(kExportsGLTF, kExportsGLTFLong, MSyntax::kBoolean));
+	CHECK_MSTATUS(syntax.addFlag(kCheckpointFlag, kCheckpointFlagLong, MSyntax::kLong));
+	CHECK_MSTATUS(syntax.addFlag(kResumeFlag, kResumeFlagLong, MSyntax::kNoArg));
+	CHECK_MSTATUS(syntax.addFlag(kRenderStatsFlag, kRenderStatsFlagLong, MSyntax::kString));
 
 	return syntax;
 }
@@ -112,6 +118,9 @@ MStatus FireRenderCmd::doIt(const MArgList & args)
 	else if (argData.isFlagSet(kExportsGLTF))
 		return exportsGLTF(argData);
 
+	else if (argData.isFlagSet(kRenderStatsFlag))
+		return updateRenderStatsOutput(argData);
+
 	else if (argData.isFlagSet(kOpenFolder))
 	{
 		MString path;
@@ -371,6 +380,41 @@ MStatus FireRenderCmd::renderIpr(const MArgDatabase& args)
 	return MStatus::kSuccess;
 }
 
+// -----------------------------------------------------------------------------
+namespace
+{
+	// Identifies the scene file, render settings, camera and frame a render checkpoint belongs to,
+	// so that a checkpoint of an edited scene is not merged into the resumed render.
+	uint64_t GetCheckpointSceneKey(const MDagPath& camera, int frame)
+	{
+		HashValue hash;
+		hash << frame;
+
+		MString sceneFile = MFileIO::currentFile();
+		hash.Append(sceneFile.asUTF8(), (int) strlen(sceneFile.asUTF8()));
+
+		std::error_code errorCode;
+		std::filesystem::path scenePath = std::filesystem::u8path(sceneFile.asUTF8());
+		std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(scenePath, errorCode);
+		if (!errorCode)
+		{
+			hash << writeTime.time_since_epoch().count();
+		}
+
+		MString cameraName = camera.fullPathName();
+		hash.Append(cameraName.asUTF8(), (int) strlen(cameraName.asUTF8()));
+
+		MObject globalsNode;
+		GetRadeonProRenderGlobals(globalsNode);
+		if (!globalsNode.isNull())
+		{
+			hash << FireMaya::Scope::GetShadingNetworkHash(globalsNode);
+		}
+
+		return size_t(hash);
+	}
+}
+
 // -----------------------------------------------------------------------------
 MStatus FireRenderCmd::renderBatch(const MArgDatabase& args)
 {
@@ -449,6 +493,14 @@ MStatus FireRenderCmd::renderBatch(const MArgDatabase& args)
 		std::string versionStr = "RPR version : ";
 		versionStr += (version == RPR1) ? "RPR1\n" : "RPR2\n";
 
+		// Checkpoint accumulated AOVs periodically so a preempted
+		// render can be continued with the resume flag.
+		int checkpointInterval = 0;
+		if (args.isFlagSet(kCheckpointFlag))
+			args.getFlagArgument(kCheckpointFlag, 0, checkpointInterval);
+
+		bool resume = args.isFlagSet(kResumeFlag);
+
 		// Get the list of cameras to render frames for.
 		MDagPathArray renderableCameras = GetSceneCameras(true);
 
@@ -468,6 +520,29 @@ MStatus FireRenderCmd::renderBatch(const MArgDatabase& args)
 			if (settings.namingScheme < 2)
 				frameEnd = frameStart;
 
+			// Generate images of animated skies ahead, so updating
+			// the sky on each frame only swaps the environment image.
+			if (frameEnd > frameStart)
+			{
+				std::vector<MTime> frameTimes;
+				for (int frame = frameStart; frame <= frameEnd; frame += frameBy)
+				{
+					if (settings.skipExistingFrames && outputFileExists(getOutputFilePath(settings, frame, cameraName, false)))
+						continue;
+
+					// same time units as the frame loop below
+					MTime time;
+					time.setValue(static_cast<double>(frame));
+					frameTimes.push_back(time);
+				}
+
+				for (auto& sceneObject : context.GetSceneObjects())
+				{
+					if (auto sky = dynamic_cast<FireRenderSky*>(sceneObject.second.get()))
+						sky->PrecomputeFrames(frameTimes);
+				}
+			}
+
 			// Process each frame.
 			for (int frame = frameStart; frame <= frameEnd; frame += frameBy)
 			{
@@ -487,6 +562,20 @@ MStatus FireRenderCmd::renderBatch(const MArgDatabase& args)
 				if (settings.skipExistingFrames && outputFileExists(filePath))
 					continue;
 
+				// Continue from the checkpoint of a preempted render if requested.
+				RenderCheckpoint checkpoint(std::string(filePath.asUTF8()) + ".rprcheckpoint", GetCheckpointSceneKey(camera, frame));
+				if (resume && checkpoint.Load(aovs, settings.width, settings.height))
+				{
+					LogPrint("Resuming frame %d from checkpoint at iteration %d", frame, checkpoint.GetIterations());
+					context.setResumeState(checkpoint.GetIterations(), checkpoint.GetFrameCount(), checkpoint.GetSecondsSpent());
+				}
+				else
+				{
+					context.setResumeState(0, 0, 0);
+				}
+
+				RenderStats::BeginFrame(frame, std::filesystem::u8path(filePath.asUTF8()).stem().u8string());
+
 				// Refresh the context so it matches the
 				// current animation state and start the render.
 				context.Freshen();
@@ -495,6 +584,7 @@ MStatus FireRenderCmd::renderBatch(const MArgDatabase& args)
 				// Track the last progress percent so a progress
 				// message is displayed only if the progress changes.
 				int lastProgress = 0;
+				TimePoint lastCheckpointTime = GetCurrentChronoTime();
 
 				// Render a frame until completion criteria are met.
 				while (context.keepRenderRunning())
@@ -510,10 +600,27 @@ MStatus FireRenderCmd::renderBatch(const MArgDatabase& args)
 						sendBatchProgressMessage(progress, frame, newLayerName);
 						lastProgress = progress;
 					}
+
+					if ((checkpointInterval > 0) &&
+						(TimeDiffChrono<std::chrono::seconds>(GetCurrentChronoTime(), lastCheckpointTime) >= checkpointInterval))
+					{
+						// checkpoints keep unstamped pixels, the stamp is drawn once on the final image
+						aovs.readFrameBuffers(context, false);
+						checkpoint.Merge(aovs, context.m_currentIteration);
+
+						int secondsSpent = TimeDiffChrono<std::chrono::seconds>(GetCurrentChronoTime(), context.m_renderStartTime);
+						if (checkpoint.SaveAsync(aovs, settings.width, settings.height, context.m_currentIteration, context.getCurrentFrameCount(), secondsSpent))
+						{
+							lastCheckpointTime = GetCurrentChronoTime();
+						}
+					}
 				}
 
 				// Resolve the frame buffer and read pixels into AOVs.
-				aovs.readFrameBuffers(context);
+				aovs.readFrameBuffers(context, false);
+				checkpoint.Merge(aovs, context.m_currentIteration);
+				aovs.applyRenderStamp(context);
+				context.setResumeState(0, 0, 0);
 
 				// Run denoiser
 				if (context.IsDenoiserEnabled())
@@ -527,6 +634,12 @@ MStatus FireRenderCmd::renderBatch(const MArgDatabase& args)
 				// Save the frame to file.
 				aovs.writeToFile(context, filePath, settings.imageFormat);
 
+				// The frame is complete, so its checkpoint is not needed anymore.
+				if (checkpointInterval > 0 || resume)
+					checkpoint.Remove();
+
+				RenderStats::EndFrame();
+
 				// Execute the post frame command if there is one.
 				MGlobal::executeCommand(settings.postRenderMel);
 			}
@@ -539,6 +652,9 @@ MStatus FireRenderCmd::renderBatch(const MArgDatabase& args)
 	}
 	catch (...)
 	{
+		// Keep stats of the failed frame.
+		RenderStats::EndFrame();
+
 		// Perform clean up operations.
 		context.cleanScene();
 
@@ -574,6 +690,17 @@ MStatus FireRenderCmd::updateDebugOutput(const MArgDatabase& argData)
 	return status;
 }
 
+// -----------------------------------------------------------------------------
+MStatus FireRenderCmd::updateRenderStatsOutput(const MArgDatabase& argData)
+{
+	MString folder;
+	MStatus status = argData.getFlagArgument(kRenderStatsFlag, 0, folder);
+	if (status == MS::kSuccess)
+		RenderStats::SetOutputFolder(folder.asUTF8());
+
+	return status;
+}
+
 // Implemented in pluginMain.cpp
 void RprExportsGLTF(bool enable);
 
@@ -103,6 +103,9 @@ private:
 	/** Update the whether debug output is enabled or disabled. */
 	MStatus updateDebugOutput(const MArgDatabase& argData);
 
+	/** Set the folder render statistics are written to; an empty path disables them. */
+	MStatus updateRenderStatsOutput(const MArgDatabase& argData);
+
 	/** Enables or disables gltf export */
 	MStatus exportsGLTF(const MArgDatabase& argData);
 
@@ -181,4 +184,10 @@ private:
 #define kWaitForItTwoStepLong "-waitForItTwo"
 #define kExportsGLTF "-eg"
 #define kExportsGLTFLong "-exportsGLTF"
+#define kCheckpointFlag "-cp"
+#define kCheckpointFlagLong "-checkpoint"
+#define kResumeFlag "-rs"
+#define kResumeFlagLong "-resume"
+#define kRenderStatsFlag "-sts"
+#define kRenderStatsFlagLong "-renderStats"
 
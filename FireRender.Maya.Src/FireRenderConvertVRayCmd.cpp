@@ -12,6 +12,8 @@ limitations under the License.
 ********************************************************************/
 #include <functional>
 #include <algorithm>
+#include <future>
+#include <thread>
 
 #include "maya/MGlobal.h"
 #include "maya/MDagPath.h"
@@ -509,19 +511,6 @@ doDelete;
 	return true;
 }
 
-bool FireRenderConvertVRayCmd::ConvertVRayObjectInDagPath(MDagPath originalVRayObjectDagPath)
-{
-	auto node = originalVRayObjectDagPath.node();
-
-	if (node.isNull())
-		return false;
-
-	if (VRay::isVRayObject(node))
-		return ConvertVRayObject(node);
-	else
-		return ConvertVRayShadersOn(originalVRayObjectDagPath);
-}
-
 bool FireRenderConvertVRayCmd::ConvertVRayObject(MObject originalVRayObject)
 {
 	MFnDagNode node(originalVRayObject);
@@ -597,132 +586,241 @@ bool materialHasConnections(const MFnDependencyNode & shaderNode)
 	return false;
 }
 
-bool FireRenderConvertVRayCmd::ConvertVRayShadersOn(MDagPath path)
+bool FireRenderConvertVRayCmd::SnapshotVRayShadersOn(MDagPath path, MeshSnapshot & snapshot)
 {
 	MStatus status;
 
-	int converted = 0;
-	bool ret = false;
-
 	auto obj = path.node();
 
-	if (obj.hasFn(MFn::kDagNode))
-	{
-		MFnDagNode fnDagNode(obj);
+	if (!obj.hasFn(MFn::kDagNode))
+		return false;
 
-		MFnMesh fnMesh(obj, &status);
+	MFnDagNode fnDagNode(obj);
+	MFnMesh fnMesh(obj, &status);
 
-		MIntArray faceMaterialIndices;
-		auto materialCount = GetFaceMaterials(fnMesh, faceMaterialIndices);
+	MIntArray faceMaterialIndices;
+	snapshot.materialCount = GetFaceMaterials(fnMesh, faceMaterialIndices);
+	snapshot.faceMaterialIndices.reserve(faceMaterialIndices.length());
+	for (unsigned int i = 0; i < faceMaterialIndices.length(); i++)
+		snapshot.faceMaterialIndices.push_back(faceMaterialIndices[i]);
 
-		MStringArray shadingGroups;
-		auto oldMaterials = findAllMaterialsAndShadingGroups(obj, shadingGroups);
+	snapshot.materials = findAllMaterialsAndShadingGroups(obj, snapshot.shadingGroups);
 
-		if (oldMaterials.empty())
-			return false;
+	if (snapshot.materials.empty())
+		return false;
 
-		bool materialAssignedToAnObject = materialCount == 1;
-		bool materialConverted = false;
+	snapshot.fullPathName = fnDagNode.fullPathName();
+	snapshot.partialPathName = fnDagNode.partialPathName();
 
-		for (int materialIndex = 0; materialIndex < oldMaterials.size(); materialIndex++)
-		{
-			auto oldMaterial = oldMaterials[materialIndex];
-			MFnDependencyNode shaderNode(oldMaterial);
+	// network hash is computed once per material, shared materials are usually assigned to many meshes
+	for (auto material : snapshot.materials)
+	{
+		MFnDependencyNode shaderNode(material);
+		uint64_t networkHash = 0;
 
-			if (VRay::isTexture(shaderNode))
+		if (VRay::isTexture(shaderNode))
+		{
+			auto it = m_networkHashes.find(shaderNode.name());
+			if (it != m_networkHashes.end())
+			{
+				networkHash = it->second;
+			}
+			else
 			{
-				MObject newShader;
+				networkHash = Scope::GetShadingNetworkHash(material);
+				m_networkHashes[shaderNode.name()] = networkHash;
+			}
+		}
 
-				MString newName;
+		snapshot.networkHashes.push_back(networkHash);
+	}
 
-				auto oldName = shaderNode.name();
-				auto it = m_conversionObjectMap.find(oldName);
-				if (it != m_conversionObjectMap.end())
-				{
-					newName = it->second;
-				}
-				else
-				{
-					newShader = ConvertVRayShader(shaderNode, oldName);
+	return true;
+}
 
-					if (!newShader.isNull())
-					{
-						newName = MFnDependencyNode(newShader).name();
+FireRenderConvertVRayCmd::FaceRanges FireRenderConvertVRayCmd::GetFaceRanges(const MeshSnapshot & snapshot)
+{
+	FaceRanges ret(snapshot.materials.size());
 
-						m_conversionObjectMap[oldName] = newName;
-					}
-				}
+	const auto & indices = snapshot.faceMaterialIndices;
+	int count = static_cast<int>(indices.size());
+	int start = 0;
 
-				if (newName.length())
-				{
-					if (materialAssignedToAnObject)
-						AssignMaterialToAnObject(fnDagNode, newName);
-					else
-						AssignMaterialToFaces(fnDagNode, faceMaterialIndices, materialIndex, newName);
+	for (int i = 1; i <= count; i++)
+	{
+		if (i < count && indices[i] == indices[start])
+			continue;
 
-					m_convertedVRayMaterials.append(oldMaterial);
-					materialConverted = true;
-				}
+		int materialIndex = indices[start];
+		if (materialIndex >= 0 && materialIndex < static_cast<int>(ret.size()))
+			ret[materialIndex].push_back(make_pair(start, i - 1));
 
-				if (converted++)
-					ret &= !newShader.isNull();
-				else
-					ret = !newShader.isNull();
-			}
-		}
+		start = i;
+	}
+
+	return ret;
+}
+
+std::vector<FireRenderConvertVRayCmd::FaceRanges> FireRenderConvertVRayCmd::BuildFaceRanges(const std::vector<MeshSnapshot> & snapshots)
+{
+	// snapshots hold plain data only, so the plan is built without touching Maya
+	std::vector<FaceRanges> ret(snapshots.size());
+
+	size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+	size_t chunkSize = (snapshots.size() + threadCount - 1) / threadCount;
 
-		if (materialConverted)
+	std::vector<std::future<void>> tasks;
+	for (size_t first = 0; first < snapshots.size(); first += chunkSize)
+	{
+		size_t last = std::min(first + chunkSize, snapshots.size());
+
+		tasks.push_back(std::async(std::launch::async, [&snapshots, &ret, first, last]()
 		{
-			for (auto name : shadingGroups)
-				m_convertedVRayShadingGroups.append(name);
-		}
+			for (size_t i = first; i < last; i++)
+				ret[i] = GetFaceRanges(snapshots[i]);
+		}));
 	}
 
+	for (auto & task : tasks)
+		task.get();
+
 	return ret;
 }
 
-void FireRenderConvertVRayCmd::AssignMaterialToAnObject(MFnDagNode &fnDagNode, MString material)
+MString FireRenderConvertVRayCmd::ConvertOrReuseVRayShader(MObject oldMaterial, uint64_t networkHash)
 {
-	ExecuteCommand("select -r "_ms + fnDagNode.fullPathName());
-	ExecuteCommand("hyperShade -assign "_ms + material);
+	MFnDependencyNode shaderNode(oldMaterial);
+	auto oldName = shaderNode.name();
+
+	auto it = m_conversionObjectMap.find(oldName);
+	if (it != m_conversionObjectMap.end())
+		return it->second;
+
+	MString newName;
+
+	// identical source materials are converted only once
+	std::string network = Scope::GetShadingNetworkDescription(oldMaterial);
+
+	auto networkIt = m_conversionNetworkMap.find(networkHash);
+	if (networkIt != m_conversionNetworkMap.end() && networkIt->second.network == network)
+	{
+		newName = networkIt->second.name;
+	}
+	else
+	{
+		auto newShader = ConvertVRayShader(shaderNode, oldName);
+
+		if (newShader.isNull())
+			return MString();
+
+		newName = MFnDependencyNode(newShader).name();
+
+		// on a hash collision the first converted network keeps the entry
+		if (networkIt == m_conversionNetworkMap.end())
+		{
+			m_conversionNetworkMap[networkHash] = { std::move(network), newName };
+		}
+	}
+
+	m_conversionObjectMap[oldName] = newName;
+	m_convertedVRayMaterials.append(oldMaterial);
+
+	return newName;
 }
 
-void FireRenderConvertVRayCmd::AssignMaterialToFaces(MFnDagNode &fnDagNode, const MIntArray & faceMaterialIndices, int materialIndex, MString newMaterial)
+bool FireRenderConvertVRayCmd::ConvertVRayShadersOn(const MeshSnapshot & snapshot, const FaceRanges & faceRanges)
 {
-	auto path = fnDagNode.partialPathName();
+	int converted = 0;
+	bool ret = false;
 
-	vector<pair<int, int>> pairs;
-	int start = -1, end = -1;
-	for (int i = 0; i < static_cast<int>(faceMaterialIndices.length()); i++)
+	bool materialAssignedToAnObject = snapshot.materialCount == 1;
+	bool materialConverted = false;
+
+	for (size_t materialIndex = 0; materialIndex < snapshot.materials.size(); materialIndex++)
 	{
-		if (faceMaterialIndices[i] == materialIndex)
+		MFnDependencyNode shaderNode(snapshot.materials[materialIndex]);
+
+		if (!VRay::isTexture(shaderNode))
+			continue;
+
+		MString newName = ConvertOrReuseVRayShader(snapshot.materials[materialIndex], snapshot.networkHashes[materialIndex]);
+
+		if (newName.length())
 		{
-			if (start == -1)
+			auto & members = m_pendingAssignments[newName];
+
+			if (materialAssignedToAnObject)
 			{
-				start = end = i;
+				members.push_back(snapshot.fullPathName);
 			}
 			else
 			{
-				if (end == (i - 1))
-				{
-					end = i;
-				}
-				else
-				{
-					pairs.push_back(make_pair(start, end));
-					start = end = -1;
-				}
+				for (auto range : faceRanges[materialIndex])
+					members.push_back(snapshot.partialPathName + ".f[" + range.first + ":" + range.second + "]");
 			}
+
+			materialConverted = true;
 		}
+
+		if (converted++)
+			ret &= newName.length() > 0;
+		else
+			ret = newName.length() > 0;
+	}
+
+	if (materialConverted)
+	{
+		for (auto name : snapshot.shadingGroups)
+			m_convertedVRayShadingGroups.append(name);
 	}
-	if (start != -1)
-		pairs.push_back(make_pair(start, end));
 
-	for (auto pair : pairs)
+	return ret;
+}
+
+MString FireRenderConvertVRayCmd::GetShadingGroup(MString material)
+{
+	auto shadingGroups = ExecuteCommandStringArrayResult("listConnections -s false -d true -type shadingEngine "_ms + material + ".outColor");
+	if (shadingGroups.length() > 0)
+		return shadingGroups[0];
+
+	MString shadingGroup = ExecuteCommandStringResult("sets -renderable true -noSurfaceShader true -empty -name "_ms + material + "SG");
+	ExecuteCommand("connectAttr -f "_ms + material + ".outColor " + shadingGroup + ".surfaceShader");
+
+	return shadingGroup;
+}
+
+void FireRenderConvertVRayCmd::ApplyMaterialAssignments()
+{
+	// keeps a single command line within a reasonable length
+	const size_t MaxMembersPerCommand = 512;
+
+	for (const auto & assignment : m_pendingAssignments)
 	{
-		ExecuteCommand("select -r "_ms + path + +".f[" + pair.first + ":" + pair.second + "]"_ms);
-		ExecuteCommand("hyperShade -assign "_ms + newMaterial);
+		const auto & members = assignment.second;
+
+		try
+		{
+			MString shadingGroup = GetShadingGroup(assignment.first);
+
+			for (size_t first = 0; first < members.size(); first += MaxMembersPerCommand)
+			{
+				MString command = "sets -e -forceElement "_ms + shadingGroup;
+
+				size_t last = std::min(first + MaxMembersPerCommand, members.size());
+				for (size_t i = first; i < last; i++)
+					command += " "_ms + members[i];
+
+				ExecuteCommand(command);
+			}
+		}
+		catch (const std::exception & ex)
+		{
+			DebugPrint(ex.what());
+			this->displayError("Failed to assign material "_ms + assignment.first + " because of: " + ex.what());
+		}
 	}
+
+	m_pendingAssignments.clear();
 }
 
 MObject FireRenderConvertVRayCmd::ConvertVRayShader(const MFnDependencyNode & shaderNode, MString originalName)
@@ -790,6 +888,9 @@ MStatus FireRenderConvertVRayCmd::doIt(const MArgList & args)
 	int converted = 0, failed = 0;
 
 	m_conversionObjectMap.clear();
+	m_conversionNetworkMap.clear();
+	m_networkHashes.clear();
+	m_pendingAssignments.clear();
 	m_convertedVRayMaterials.clear();
 	m_convertedVRayShadingGroups.clear();
 
@@ -823,11 +924,11 @@ MStatus FireRenderConvertVRayCmd::doIt(const MArgList & args)
 		}
 	}
 
-	for (auto vrayObject : selectedObjects)
+	auto runGuarded = [&](std::function<bool()> convert)
 	{
 		try
 		{
-			if (ConvertVRayObjectInDagPath(vrayObject))
+			if (convert())
 				converted++;
 		}
 		catch (const std::exception & ex)
@@ -843,9 +944,68 @@ MStatus FireRenderConvertVRayCmd::doIt(const MArgList & args)
 
 			failed++;
 		}
+	};
+
+	// snapshot: read every V-Ray object and material assignment in one pass
+	auto phaseStart = GetCurrentChronoTime();
+
+	std::vector<MObject> lights;
+	std::vector<MeshSnapshot> meshes;
+
+	for (auto vrayObject : selectedObjects)
+	{
+		auto node = vrayObject.node();
+
+		if (node.isNull())
+			continue;
+
+		if (VRay::isVRayObject(node))
+		{
+			lights.push_back(node);
+			continue;
+		}
+
+		runGuarded([&]()
+		{
+			MeshSnapshot snapshot;
+			if (SnapshotVRayShadersOn(vrayObject, snapshot))
+				meshes.push_back(std::move(snapshot));
+
+			// meshes are counted when their shaders are converted
+			return false;
+		});
 	}
 
+	auto snapshotTime = TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), phaseStart);
+
+	// plan: face ranges of all meshes are computed off the main thread
+	phaseStart = GetCurrentChronoTime();
+	auto faceRanges = BuildFaceRanges(meshes);
+	auto planTime = TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), phaseStart);
+
+	// convert: lights and one RPR material per distinct source network
+	phaseStart = GetCurrentChronoTime();
+
+	for (auto light : lights)
+		runGuarded([&]() { return ConvertVRayObject(light); });
+
+	for (size_t i = 0; i < meshes.size(); i++)
+		runGuarded([&]() { return ConvertVRayShadersOn(meshes[i], faceRanges[i]); });
+
+	auto convertTime = TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), phaseStart);
+
+	// assign: one sets command per converted material instead of a selection per face range
+	phaseStart = GetCurrentChronoTime();
+	ApplyMaterialAssignments();
+	auto assignTime = TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), phaseStart);
+
+	phaseStart = GetCurrentChronoTime();
 	/* auto vrayShadersDeleted = */ TryDeleteUnusedVRayMaterials();
+	auto cleanupTime = TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), phaseStart);
+
+	LogPrint("VRay conversion: %d meshes, %d materials converted to %d (ms: snapshot %d, plan %d, convert %d, assign %d, cleanup %d)",
+		(int)meshes.size(), (int)m_conversionObjectMap.size(), (int)m_conversionNetworkMap.size(),
+		snapshotTime, planTime, convertTime, assignTime, cleanupTime);
 
 	MString message;
 
@@ -863,6 +1023,8 @@ MStatus FireRenderConvertVRayCmd::doIt(const MArgList & args)
 	this->setResult(message);
 
 	m_conversionObjectMap.clear();
+	m_conversionNetworkMap.clear();
+	m_networkHashes.clear();
 
 	return status;
 }
@@ -14,6 +14,7 @@ limitations under the License.
 
 #include <vector>
 #include <map>
+#include <string>
 
 #include <maya/MObject.h>
 #include <maya/MFnDagNode.h>
@@ -31,7 +32,31 @@ public:
 	virtual ~FireRenderConvertVRayCmd();
 
 private:
+	// Material assignment of a mesh, captured in one pass before anything is converted
+	struct MeshSnapshot
+	{
+		MString fullPathName;
+		MString partialPathName;
+		int materialCount = 0;
+		std::vector<int> faceMaterialIndices;
+		std::vector<MObject> materials;
+		std::vector<uint64_t> networkHashes;
+		MStringArray shadingGroups;
+	};
+
+	// Contiguous face ranges for every material index of a mesh
+	typedef std::vector<std::vector<std::pair<int, int>>> FaceRanges;
+
 	std::map<MString, MString, MStringComparison> m_conversionObjectMap;
+	// converted materials by network hash, with the network description to tell apart networks with colliding hashes
+	struct ConvertedNetwork
+	{
+		std::string network;
+		MString name;
+	};
+	std::map<uint64_t, ConvertedNetwork> m_conversionNetworkMap;
+	std::map<MString, uint64_t, MStringComparison> m_networkHashes;
+	std::map<MString, std::vector<MString>, MStringComparison> m_pendingAssignments;
 	MObjectArray	m_convertedVRayMaterials;
 	MStringArray	m_convertedVRayShadingGroups;
 
@@ -48,12 +73,15 @@ private:
 	static MDagPathArray FilterVRayObjects(const MDagPathArray & paths);
 
 private:
-	bool ConvertVRayObjectInDagPath(MDagPath originalVRayObjectDagPath);
 	bool ConvertVRayObject(MObject object);
-	bool ConvertVRayShadersOn(MDagPath path);
-
-	void AssignMaterialToAnObject(MFnDagNode &fnDagNode, MString newName);
-	void AssignMaterialToFaces(MFnDagNode &fnDagNode, const MIntArray & faceMaterialIndices, int materialIndex, MString newMaterial);
+	bool SnapshotVRayShadersOn(MDagPath path, MeshSnapshot & snapshot);
+	static FaceRanges GetFaceRanges(const MeshSnapshot & snapshot);
+	static std::vector<FaceRanges> BuildFaceRanges(const std::vector<MeshSnapshot> & snapshots);
+	bool ConvertVRayShadersOn(const MeshSnapshot & snapshot, const FaceRanges & faceRanges);
+	MString ConvertOrReuseVRayShader(MObject oldMaterial, uint64_t networkHash);
+
+	MString GetShadingGroup(MString material);
+	void ApplyMaterialAssignments();
 
 	MObject ConvertVRayShader(const MFnDependencyNode & shaderNode, MString originalName);
 
@@ -29,10 +29,17 @@ limitations under the License.
 #include <maya/MRenderUtil.h>
 #include <maya/MCommonRenderSettingsData.h>
 #include <maya/MFnRenderLayer.h>
+#include <maya/MFnAttribute.h>
+#include <maya/MFnMesh.h>
 #include "AnimationExporter.h"
 
+#include <filesystem>
 #include <fstream>
+#include <sstream>
 #include <regex>
+#include <map>
+#include <algorithm>
+#include <future>
 
 #ifdef __linux__
 	#include <../RprLoadStore.h>
@@ -72,6 +79,7 @@ MSyntax FireRenderExportCmd::newSyntax()
 	CHECK_MSTATUS(syntax.addFlag(kCompressionFlag, kCompressionFlagLong, MSyntax::kString));
 	CHECK_MSTATUS(syntax.addFlag(kPadding, kPaddingLong, MSyntax::kString, MSyntax::kLong));
 	CHECK_MSTATUS(syntax.addFlag(kSelectedCamera, kSelectedCameraLong, MSyntax::kString));
+	CHECK_MSTATUS(syntax.addFlag(kIncrementalFlag, kIncrementalFlagLong, MSyntax::kNoArg));
 
 	return syntax;
 }
@@ -92,28 +100,14 @@ std::string GetPluginLibrary(bool isRPR2)
 	return pluginDll;
 }
 
-bool SaveExportConfig(const std::wstring& filePath, TahoeContext& ctx, const std::wstring& fileName)
+// Render config of the exported frame, it is taken before the scene is moved to the next frame
+std::wstring GetExportConfig(TahoeContext& ctx, const std::wstring& fileName)
 {
-	std::wstring configName = std::regex_replace(filePath, std::wregex(L"rpr$"), L"json");
-
 	bool isRPR2 = TahoeContext::IsGivenContextRPR2(&ctx);
 
-#ifdef WIN32
-	// MSVS added an overload to accommodate using open with wide strings where xcode did not.
-	std::wofstream json(configName.c_str());
-#else
-	// thus different path for xcode is needed
-	std::string s_directory = SharedComponentsUtils::ws2s(configName);
-	std::wofstream json(s_directory);
-#endif
-
-	if (!json)
-		return false;
-
 	std::string pluginDll = GetPluginLibrary(isRPR2);
 
-	const std::locale utf8_locale = std::locale(std::locale(), new std::codecvt_utf8<wchar_t>());
-	json.imbue(utf8_locale);
+	std::wstringstream json;
 
 	json << "{" << std::endl;
 
@@ -261,9 +255,33 @@ bool SaveExportConfig(const std::wstring& filePath, TahoeContext& ctx, const std
 	json << "\n}" << std::endl;
 
 	json << "}" << std::endl;
+
+	return json.str();
+}
+
+bool SaveExportConfig(const std::wstring& filePath, const std::wstring& config)
+{
+	std::wstring configName = std::regex_replace(filePath, std::wregex(L"rpr$"), L"json");
+
+#ifdef WIN32
+	// MSVS added an overload to accommodate using open with wide strings where xcode did not.
+	std::wofstream json(configName.c_str());
+#else
+	// thus different path for xcode is needed
+	std::string s_directory = SharedComponentsUtils::ws2s(configName);
+	std::wofstream json(s_directory);
+#endif
+
+	if (!json)
+		return false;
+
+	const std::locale utf8_locale = std::locale(std::locale(), new std::codecvt_utf8<wchar_t>());
+	json.imbue(utf8_locale);
+
+	json << config;
 	json.close();
 
-	return true;
+	return !json.fail();
 }
 
 unsigned int SetupExportFlags(bool isExportAsSingleFileEnabled, bool isIncludeTextureCacheEnabled, MString& compressionOption)
@@ -307,6 +325,156 @@ unsigned int SetupExportFlags(bool isExportAsSingleFileEnabled, bool isIncludeTe
 	return exportFlags;
 }
 
+// Frame entry of the sequence index written by incremental export
+struct SequenceFrameEntry
+{
+	int frame;
+	std::wstring file;
+	size_t hash;
+	bool reused;
+	std::vector<MString> changedObjects;
+};
+
+void HashShadingEngine(MObject shadingEngine, HashValue& hash)
+{
+	// whole upstream networks, so that animated textures and their placement nodes are included as well
+	for (MObject shader : { getSurfaceShader(shadingEngine), getVolumeShader(shadingEngine), getDisplacementShader(shadingEngine) })
+	{
+		hash << (shader.isNull() ? uint64_t(0) : FireMaya::Scope::GetShadingNetworkHash(shader));
+	}
+}
+
+// Hash of the frame dependent content of an exported object: transform, visibility, deformed points,
+// shading networks of meshes and attributes and upstream networks of lights, environment, sky and camera.
+// Returns false for objects the hash can't describe (hair, fluids, instancers...), frames containing them are never reused.
+bool GetExportContentHash(FireRenderObject* object, HashValue& hash)
+{
+	const MObject& node = object->Object();
+
+	if (node.isNull())
+		return true;
+
+	if (auto frNode = dynamic_cast<FireRenderNode*>(object))
+	{
+		MDagPath dagPath = frNode->DagPath();
+		if (dagPath.isValid())
+		{
+			hash << dagPath.isVisible();
+			hash << dagPath.inclusiveMatrix();
+		}
+	}
+
+	if (auto mesh = dynamic_cast<FireRenderMesh*>(object))
+	{
+		MDagPath dagPath = mesh->DagPath();
+		if (dagPath.isValid() && node.hasFn(MFn::kMesh))
+		{
+			MStatus status;
+			MFnMesh fnMesh(dagPath);
+			const float* points = fnMesh.getRawPoints(&status);
+			if (status == MStatus::kSuccess && points)
+			{
+				hash.Append(points, fnMesh.numVertices() * 3);
+			}
+		}
+
+		for (const FrElement& element : mesh->Elements())
+		{
+			for (MObject shadingEngine : element.shadingEngines)
+			{
+				HashShadingEngine(shadingEngine, hash);
+			}
+		}
+
+		return true;
+	}
+
+	bool isCovered = (dynamic_cast<FireRenderLight*>(object) && !dynamic_cast<FireRenderCustomEmitter*>(object)) ||
+		dynamic_cast<FireRenderEnvLight*>(object) ||
+		dynamic_cast<FireRenderSky*>(object) ||
+		dynamic_cast<FireRenderCamera*>(object) ||
+		dynamic_cast<FireRenderDisplayLayer*>(object);
+
+	if (!isCovered)
+		return false;
+
+	hash << FireMaya::Scope::GetShadingNetworkHash(node);
+
+	return true;
+}
+
+std::wstring GetFileNameFromPath(const std::wstring& path)
+{
+	size_t separatorIndex = path.find_last_of(L"/\\");
+
+	return (separatorIndex == std::wstring::npos) ? path : path.substr(separatorIndex + 1);
+}
+
+// A reused frame still gets its own file, so that the sequence can be loaded by file name pattern.
+// The file is hard linked to the already exported frame, or copied if the file system doesn't support links.
+bool LinkReusedFrameFile(const std::wstring& exportedFilePath, const std::wstring& filePath)
+{
+	std::filesystem::path source(exportedFilePath);
+	std::filesystem::path destination(filePath);
+
+	// pattern without frame number writes all frames into the same file
+	if (source == destination)
+		return true;
+
+	std::error_code error;
+	std::filesystem::remove(destination, error);
+
+	std::filesystem::create_hard_link(source, destination, error);
+	if (!error)
+		return true;
+
+	return std::filesystem::copy_file(source, destination, std::filesystem::copy_options::overwrite_existing, error) && !error;
+}
+
+bool SaveSequenceIndex(const std::wstring& indexPath, const std::vector<SequenceFrameEntry>& frames)
+{
+#ifdef WIN32
+	std::wofstream json(indexPath.c_str());
+#else
+	std::string s_directory = SharedComponentsUtils::ws2s(indexPath);
+	std::wofstream json(s_directory);
+#endif
+
+	if (!json)
+		return false;
+
+	const std::locale utf8_locale = std::locale(std::locale(), new std::codecvt_utf8<wchar_t>());
+	json.imbue(utf8_locale);
+
+	json << "{" << std::endl;
+	json << "\"frames\" : [";
+
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		const SequenceFrameEntry& entry = frames[i];
+
+		json << (i == 0 ? "\n" : ",\n");
+		json << "{ \"frame\" : " << entry.frame;
+		json << ", \"file\" : \"" << GetFileNameFromPath(entry.file) << "\"";
+		json << ", \"hash\" : \"" << std::hex << entry.hash << std::dec << "\"";
+		json << ", \"reused\" : " << (entry.reused ? 1 : 0);
+		json << ", \"changed\" : [";
+
+		for (size_t j = 0; j < entry.changedObjects.size(); ++j)
+		{
+			json << (j == 0 ? "" : ", ") << "\"" << entry.changedObjects[j].asWChar() << "\"";
+		}
+
+		json << "] }";
+	}
+
+	json << "\n]" << std::endl;
+	json << "}" << std::endl;
+	json.close();
+
+	return true;
+}
+
 MStatus FireRenderExportCmd::doIt(const MArgList & args)
 {
 	MStatus status;
@@ -490,25 +658,81 @@ MStatus FireRenderExportCmd::doIt(const MArgList & args)
 		unsigned int framePadding = 0;
 		argData.getFlagArgument(kPadding, 1, framePadding);
 
+		// incremental sequence export: frames whose content matches an already exported frame are not written again
+		bool isIncrementalExportEnabled = isSequenceExportEnabled && argData.isFlagSet(kIncrementalFlag);
+		std::vector<SequenceFrameEntry> sequenceIndex;
+		std::map<size_t, std::wstring> exportedFrameFiles;
+		std::vector<std::pair<std::wstring, std::wstring>> reusedFrameFiles;
+		std::map<std::string, size_t> objectHashes;
+
 		// create rprs context
 		frw::RPRSContext rprsContext;
 
+		// Frames are exported in a two stage pipeline: the RPR scene is serialized on a worker thread
+		// while the main thread evaluates the next frame in Maya. The RPR scene can't be changed during
+		// serialization, so only one frame is in flight and Freshen waits for it.
+		std::future<rpr_int> pendingExport;
+		std::wstring pendingFilePath;
+		std::wstring pendingConfig;
+
+		long evaluationTime = 0;
+		long syncTime = 0;
+		long serializationTime = 0;
+		long waitTime = 0;
+
+		auto finishPendingExport = [&]() -> bool
+		{
+			if (!pendingExport.valid())
+				return true;
+
+			TimePoint waitStartTime = GetCurrentChronoTime();
+			rpr_int statusExport = pendingExport.get();
+			waitTime += TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), waitStartTime);
+
+			// save config
+			bool res = SaveExportConfig(pendingFilePath, pendingConfig);
+			if (!res)
+			{
+				MGlobal::displayError("Unable to export render config!\n");
+			}
+
+			if (statusExport != RPR_SUCCESS)
+			{
+				MGlobal::displayError("Unable to export fire render scene\n");
+				return false;
+			}
+
+			return true;
+		};
+
 		// process each frame
 		for (int frame = firstFrame; frame <= lastFrame; ++frame)
 		{
 			// Move the animation to the next frame.
 			if (isSequenceExportEnabled)
 			{
+				TimePoint evaluationStartTime = GetCurrentChronoTime();
+
 				MTime time;
 				time.setValue(static_cast<double>(frame));
 				MStatus isTimeSet = MGlobal::viewFrame(time);
 				CHECK_MSTATUS(isTimeSet);
+
+				evaluationTime += TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), evaluationStartTime);
 			}
 
+			// previous frame should be serialized before the RPR scene is updated
+			if (!finishPendingExport())
+				return MS::kFailure;
+
+			TimePoint syncStartTime = GetCurrentChronoTime();
+
 			// Refresh the context so it matches the
 			// current animation state and start the render.
 			tahoeContextPtr->Freshen();
 
+			syncTime += TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), syncStartTime);
+
 			// update file path
 			std::wstring newFilePath;
 			if (isSequenceExportEnabled)
@@ -539,22 +763,126 @@ MStatus FireRenderExportCmd::doIt(const MArgList & args)
 				animationExporter.Export(*tahoeContextPtr, &cameras, rprsContext);
 			}
 
+			if (isIncrementalExportEnabled)
+			{
+				SequenceFrameEntry entry;
+				entry.frame = frame;
+				entry.file = newFilePath;
+				entry.reused = false;
+
+				HashValue frameHash;
+				bool isFrameHashed = true;
+				for (auto& it : tahoeContextPtr->GetSceneObjects())
+				{
+					if (!it.second)
+						continue;
+
+					HashValue contentHash;
+					bool isObjectHashed = GetExportContentHash(it.second.get(), contentHash);
+					size_t objectHash = contentHash;
+
+					frameHash << it.first.size();
+					frameHash.Append(it.first.c_str(), int(it.first.size()));
+					frameHash << objectHash;
+
+					if (!isObjectHashed && isFrameHashed)
+					{
+						LogPrint("Incremental export: frame %d is exported, %s can't be compared between frames", frame, MFnDependencyNode(it.second->Object()).name().asChar());
+						isFrameHashed = false;
+					}
+
+					auto prevHash = objectHashes.find(it.first);
+					if (!isObjectHashed || prevHash == objectHashes.end() || prevHash->second != objectHash)
+					{
+						objectHashes[it.first] = objectHash;
+
+						if (frame != firstFrame)
+						{
+							entry.changedObjects.push_back(MFnDependencyNode(it.second->Object()).name());
+						}
+					}
+				}
+
+				HashValue cameraHash;
+				GetExportContentHash(&tahoeContextPtr->camera(), cameraHash);
+				frameHash << size_t(cameraHash);
+				entry.hash = frameHash;
+
+				// frames with content which is not fully described by the hash are always exported
+				auto exported = isFrameHashed ? exportedFrameFiles.find(entry.hash) : exportedFrameFiles.end();
+				if (exported != exportedFrameFiles.end())
+				{
+					entry.file = exported->second;
+					entry.reused = true;
+				}
+				else if (isFrameHashed)
+				{
+					exportedFrameFiles[entry.hash] = newFilePath;
+				}
+
+				sequenceIndex.push_back(entry);
+
+				if (entry.reused)
+				{
+					// exported file may be still serialized, so it is linked once all exports are finished
+					reusedFrameFiles.emplace_back(entry.file, newFilePath);
+
+					if (!SaveExportConfig(newFilePath, GetExportConfig(*tahoeContextPtr, fileName)))
+					{
+						MGlobal::displayError("Unable to export render config!\n");
+					}
+
+					continue;
+				}
+			}
+
 			// launch export
-			rpr_int statusExport = rprsExport(MString(newFilePath.c_str()).asUTF8(), tahoeContextPtr->context(), tahoeContextPtr->scene(),
-				0, 0, 0, 0, 0, 0, SetupExportFlags(isExportAsSingleFileEnabled, isIncludeTextureCacheEnabled, compressionOption), 
-				rprsContext.Handle());
-			
-			// save config
-			bool res = SaveExportConfig(newFilePath, *tahoeContextPtr, fileName);
-			if (!res)
+			std::string exportFilePath = MString(newFilePath.c_str()).asUTF8();
+			unsigned int exportFlags = SetupExportFlags(isExportAsSingleFileEnabled, isIncludeTextureCacheEnabled, compressionOption);
+			rpr_context exportContext = tahoeContextPtr->context();
+			rpr_scene exportScene = tahoeContextPtr->scene();
+			RPRS_context exportRprsContext = rprsContext.Handle();
+
+			pendingFilePath = newFilePath;
+			pendingConfig = GetExportConfig(*tahoeContextPtr, fileName);
+			pendingExport = std::async(std::launch::async, [exportFilePath, exportContext, exportScene, exportFlags, exportRprsContext, &serializationTime]()
 			{
-				MGlobal::displayError("Unable to export render config!\n");
+				TimePoint serializationStartTime = GetCurrentChronoTime();
+
+				rpr_int statusExport = rprsExport(exportFilePath.c_str(), exportContext, exportScene,
+					0, 0, 0, 0, 0, 0, exportFlags, exportRprsContext);
+
+				serializationTime += TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), serializationStartTime);
+
+				return statusExport;
+			});
+		}
+
+		if (!finishPendingExport())
+			return MS::kFailure;
+
+		if (isSequenceExportEnabled)
+		{
+			LogPrint("Sequence export: %d frames, evaluation %.2f s, sync %.2f s, serialization %.2f s (waited %.2f s)",
+				lastFrame - firstFrame + 1, evaluationTime / 1000.0, syncTime / 1000.0, serializationTime / 1000.0, waitTime / 1000.0);
+		}
+
+		if (isIncrementalExportEnabled)
+		{
+			for (const auto& reusedFrameFile : reusedFrameFiles)
+			{
+				if (!LinkReusedFrameFile(reusedFrameFile.first, reusedFrameFile.second))
+				{
+					MGlobal::displayError(MString("Unable to export reused frame ") + reusedFrameFile.second.c_str());
+				}
 			}
-			
-			if (statusExport != RPR_SUCCESS)
+
+			size_t reusedCount = std::count_if(sequenceIndex.begin(), sequenceIndex.end(), [](const SequenceFrameEntry& entry) { return entry.reused; });
+			LogPrint("Incremental export: %d of %d frames reused", int(reusedCount), int(sequenceIndex.size()));
+
+			if (!SaveSequenceIndex(fileName + L"_sequence.json", sequenceIndex))
 			{
-				MGlobal::displayError("Unable to export fire render scene\n");
-				return MS::kFailure;
+				MGlobal::displayError("Unable to export sequence index!\n");
 			}
 		}
 
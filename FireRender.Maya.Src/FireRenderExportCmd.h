@@ -32,6 +32,8 @@ limitations under the License.
 #define kPaddingLong "-padding"
 #define kSelectedCamera "-ca"
 #define kSelectedCameraLong "-camera"
+#define kIncrementalFlag "-inc"
+#define kIncrementalFlagLong "-incremental"
 
 class FireRenderExportCmd : public MPxCommand
 {
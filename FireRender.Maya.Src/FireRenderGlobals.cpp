@@ -44,11 +44,14 @@ namespace
 
 		MObject completionCriteriaMaxIterations;
 		MObject completionCriteriaMinIterations;
+		MObject completionCriteriaNoiseThreshold;
 
 		MObject adaptiveThreshold;
 		MObject adaptiveTileSize; //hidden attribute
 
 		MObject textureCompression;
+		MObject deduplicateGeometry;
+		MObject deduplicateShaders;
 
 		MObject giClampIrradiance;
 		MObject giClampIrradianceValue;
@@ -98,6 +101,14 @@ namespace
 		MObject velocityAOVMotionBlur;
 		MObject cameraType;
 
+		// hair level of detail
+		MObject hairLOD;
+		MObject hairLODQuality;
+
+		// light culling
+		MObject lightCulling;
+		MObject lightCullingThreshold;
+
 		// for MacOS only: "Use Metal Performance Shaders"
 		MObject useMPS;
 
@@ -300,6 +311,12 @@ MStatus FireRenderGlobals::initialize()
 	Attribute::textureCompression = nAttr.create("textureCompression", "texC", MFnNumericData::kBoolean, false, &status);
 	MAKE_INPUT(nAttr);
 
+	Attribute::deduplicateGeometry = nAttr.create("deduplicateGeometry", "ddg", MFnNumericData::kBoolean, false, &status);
+	MAKE_INPUT(nAttr);
+
+	Attribute::deduplicateShaders = nAttr.create("deduplicateShaders", "dds", MFnNumericData::kBoolean, false, &status);
+	MAKE_INPUT(nAttr);
+
 	Attribute::giClampIrradiance = nAttr.create("giClampIrradiance", "gici", MFnNumericData::kBoolean, true, &status);
 	MAKE_INPUT(nAttr);
 
@@ -452,6 +469,24 @@ MStatus FireRenderGlobals::initialize()
 	Attribute::velocityAOVMotionBlur = nAttr.create("velocityAOVMotionBlur", "vavb", MFnNumericData::kBoolean, 0, &status);
 	MAKE_INPUT(nAttr);
 
+	Attribute::hairLOD = nAttr.create("hairLOD", "hlod", MFnNumericData::kBoolean, 0, &status);
+	MAKE_INPUT(nAttr);
+
+	Attribute::hairLODQuality = nAttr.create("hairLODQuality", "hlq", MFnNumericData::kFloat, 1.0f, &status);
+	MAKE_INPUT(nAttr);
+	nAttr.setMin(0.01);
+	nAttr.setSoftMax(4.0);
+	nAttr.setMax(100.0);
+
+	Attribute::lightCulling = nAttr.create("lightCulling", "lcul", MFnNumericData::kBoolean, 0, &status);
+	MAKE_INPUT(nAttr);
+
+	Attribute::lightCullingThreshold = nAttr.create("lightCullingThreshold", "lcth", MFnNumericData::kFloat, 0.001f, &status);
+	MAKE_INPUT(nAttr);
+	nAttr.setMin(0.0);
+	nAttr.setSoftMax(0.05);
+	nAttr.setMax(1.0);
+
 	Attribute::cameraType = eAttr.create("cameraType", "camt", kCameraDefault, &status);
 	eAttr.addField("Default", kCameraDefault);
 	eAttr.addField("Spherical Panorama", kSphericalPanorama);
@@ -520,6 +555,8 @@ MStatus FireRenderGlobals::initialize()
 	// Needed for QA and CIS in order to switch on detailed sync and render logs
 
 	CHECK_MSTATUS(addAttribute(Attribute::textureCompression));
+	CHECK_MSTATUS(addAttribute(Attribute::deduplicateGeometry));
+	CHECK_MSTATUS(addAttribute(Attribute::deduplicateShaders));
 
 	CHECK_MSTATUS(addAttribute(Attribute::giClampIrradiance));
 	CHECK_MSTATUS(addAttribute(Attribute::giClampIrradianceValue));
@@ -537,6 +574,10 @@ MStatus FireRenderGlobals::initialize()
 	CHECK_MSTATUS(addAttribute(Attribute::cameraMotionBlur));
 	CHECK_MSTATUS(addAttribute(Attribute::motionBlurCameraExposure));
 	CHECK_MSTATUS(addAttribute(Attribute::velocityAOVMotionBlur));
+	CHECK_MSTATUS(addAttribute(Attribute::hairLOD));
+	CHECK_MSTATUS(addAttribute(Attribute::hairLODQuality));
+	CHECK_MSTATUS(addAttribute(Attribute::lightCulling));
+	CHECK_MSTATUS(addAttribute(Attribute::lightCullingThreshold));
 
 	CHECK_MSTATUS(addAttribute(Attribute::applyGammaToMayaViews));
 	CHECK_MSTATUS(addAttribute(Attribute::displayGamma));
@@ -707,6 +748,13 @@ void FireRenderGlobals::createCompletionCriteriaAttributes()
 	nAttr.setSoftMax(100);
 	nAttr.setMax(INT_MAX);
 
+	// stop when the estimated noise of every tile is below the threshold, 0 - disabled
+	Attribute::completionCriteriaNoiseThreshold = nAttr.create("completionCriteriaNoiseThreshold", "ccnt", MFnNumericData::kFloat, 0.0, &status);
+	MAKE_INPUT(nAttr);
+	nAttr.setMin(0.0);
+	nAttr.setSoftMax(0.1);
+	nAttr.setMax(1.0);
+
 	Attribute::adaptiveThreshold = nAttr.create("adaptiveThreshold", "at", MFnNumericData::kFloat, 0.05, &status);
 	MAKE_INPUT(nAttr);
 	nAttr.setMin(0.0);
@@ -723,6 +771,7 @@ void FireRenderGlobals::createCompletionCriteriaAttributes()
 	CHECK_MSTATUS(addAttribute(Attribute::completionCriteriaSeconds));
 	CHECK_MSTATUS(addAttribute(Attribute::completionCriteriaMaxIterations));
 	CHECK_MSTATUS(addAttribute(Attribute::completionCriteriaMinIterations));
+	CHECK_MSTATUS(addAttribute(Attribute::completionCriteriaNoiseThreshold));
 	CHECK_MSTATUS(addAttribute(Attribute::adaptiveThreshold));
 	CHECK_MSTATUS(addAttribute(Attribute::adaptiveTileSize));	
 }
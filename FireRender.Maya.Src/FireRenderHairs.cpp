@@ -15,10 +15,12 @@ limitations under the License.
 #include "FireRenderUtils.h"
 
 #include <float.h>
+#include <cmath>
 #include <array>
 #include <algorithm>
 #include <vector>
 #include <iterator>
+#include <limits>
 
 #include <maya/MFnDependencyNode.h>
 #include <maya/MPlug.h>
@@ -42,6 +44,8 @@ limitations under the License.
 #include <maya/MFnPluginData.h> 
 #include <maya/MPxData.h>
 #include <maya/MItDependencyGraph.h>
+#include <maya/MFnCamera.h>
+#include <maya/MBoundingBox.h>
 
 #include <maya/MFnPfxGeometry.h>
 #include <maya/MRenderLineArray.h>
@@ -258,19 +262,26 @@ const unsigned int PointsPerSegment = 4;
 void ProcessHairPoints(
 	std::vector<rpr_uint>& outCurveIndicesData,
 	unsigned int offset,
-	unsigned int length
+	unsigned int length,
+	unsigned int stride = 1
 )
 {
-	rpr_uint currIdx = offset;
-	for (unsigned int idx = 0; idx < length; idx++)
+	if (length == 0)
+		return;
+
+	// with stride > 1 intermediate points are skipped, but root and tip of the strand are always kept
+	unsigned int idx = 0;
+	while (true)
 	{
-		outCurveIndicesData.push_back(currIdx++);
+		outCurveIndicesData.push_back(offset + idx);
 
-		// duplicate index of last point in segment if necessary
-		if (outCurveIndicesData.size() % PointsPerSegment != 0)
-			continue;
+		if (idx == (length - 1))
+			break;
+
+		idx = std::min(idx + stride, length - 1);
 
-		if (idx < (length - 1))
+		// duplicate index of last point in segment if necessary
+		if (outCurveIndicesData.size() % PointsPerSegment == 0)
 			outCurveIndicesData.push_back(outCurveIndicesData.back());
 	}
 }
@@ -294,7 +305,8 @@ template <typename T>
 void ProcessHairWidth(
 	std::vector<float>& outRadiuses,
 	const T* width,
-	const std::vector<rpr_uint>& curveIndicesData)
+	const std::vector<rpr_uint>& curveIndicesData,
+	float widthScale = 1.0f)
 {
 	// ensure correct inputs
 	assert(width != nullptr);
@@ -308,16 +320,102 @@ void ProcessHairWidth(
 	{
 		// bottom circle
 		rpr_uint controlPointIdx = curveIndicesData[idx * PointsPerSegment];
-		float radius = (float)width[controlPointIdx] * 0.5f;
+		float radius = (float)width[controlPointIdx] * 0.5f * widthScale;
 		outRadiuses.push_back(radius);
 
 		// top circle
 		controlPointIdx = curveIndicesData[idx * PointsPerSegment + (PointsPerSegment - 1)];
-		radius = (float)width[controlPointIdx] * 0.5f;
+		radius = (float)width[controlPointIdx] * 0.5f * widthScale;
 		outRadiuses.push_back(radius);
 	}
 }
 
+// Level of detail of the hair object (see ComputeHairLOD)
+struct HairLOD
+{
+	float strandFraction = 1.0f; // part of strands that is sent to RPR
+	unsigned int segmentStride = 1; // every segmentStride-th control point of the strand is kept
+	float widthScale = 1.0f; // compensates coverage lost by dropped strands
+
+	bool IsFullDetail(void) const { return (strandFraction >= 1.0f) && (segmentStride == 1); }
+};
+
+// Projected size (in pixels) of the groom at which it is rendered with all strands and segments when quality factor is 1
+const double HairLODFullDetailPixels = 512.0;
+const float HairLODMin = 0.1f;
+const unsigned int HairLODMaxSegmentStride = 4;
+
+HairLOD ComputeHairLOD(FireRenderContext* context, const MDagPath& hairPath)
+{
+	HairLOD lod;
+
+	if (!context->hairLOD() || !hairPath.isValid())
+		return lod;
+
+	MDagPath cameraPath = MDagPath::getAPathTo(context->camera().Object());
+	if (!cameraPath.isValid() || !cameraPath.hasFn(MFn::kCamera))
+		return lod;
+
+	MStatus status;
+	MFnCamera fnCamera(cameraPath, &status);
+	if (status != MStatus::kSuccess)
+		return lod;
+
+	// world space bounds of the groom
+	MBoundingBox bbox = MFnDagNode(hairPath).boundingBox();
+	bbox.transformUsing(hairPath.inclusiveMatrix());
+	double radius = 0.5 * (bbox.max() - bbox.min()).length();
+
+	if (radius <= 0.0)
+		return lod;
+
+	// fraction of the frame height covered by the groom
+	double coverage = 1.0;
+	if (fnCamera.isOrtho())
+	{
+		coverage = 2.0 * radius / fnCamera.orthoWidth();
+	}
+	else
+	{
+		double distance = fnCamera.eyePoint(MSpace::kWorld).distanceTo(bbox.center());
+
+		// camera is inside or very close to the groom
+		if (distance <= radius)
+			return lod;
+
+		coverage = radius / (distance * tan(0.5 * fnCamera.verticalFieldOfView()));
+	}
+
+	double frameHeight = (context->height() > 0) ? context->height() : 2.0 * HairLODFullDetailPixels;
+	double projectedPixels = coverage * frameHeight;
+
+	float factor = (float)(context->hairLODQuality() * projectedPixels / HairLODFullDetailPixels);
+	factor = std::max(HairLODMin, std::min(factor, 1.0f));
+
+	if (factor >= 1.0f)
+		return lod;
+
+	// strand count follows screen size, segment count follows its square root (strands get shorter on screen slower than they get denser)
+	lod.strandFraction = factor;
+	lod.segmentStride = std::min(HairLODMaxSegmentStride, (unsigned int)(1.0f / sqrt(factor)));
+	lod.widthScale = 1.0f / factor;
+
+	return lod;
+}
+
+// Golden ratio sequence spreads kept strands evenly over the groom.
+// Selection depends only on strand index, so it is stable between re-translations and doesn't flicker in animation
+bool IsHairStrandKept(unsigned int strandIdx, const HairLOD& lod)
+{
+	if (lod.strandFraction >= 1.0f)
+		return true;
+
+	const double goldenRatioConjugate = 0.6180339887498949;
+	double sequenceValue = strandIdx * goldenRatioConjugate;
+
+	return (sequenceValue - floor(sequenceValue)) < lod.strandFraction;
+}
+
 std::tuple<unsigned int, unsigned int> GetHairLengthOffset(const XGenSplineAPI::XgItSpline& splineIt, unsigned int currCurveIdx)
 {
 	// find length of current segment and its offset in data arrays
@@ -338,6 +436,7 @@ struct CurvesBatchData
 	std::vector<float> m_uvCoord;
 	unsigned int m_pointCount;
 	const float* m_points;
+	std::vector<float> m_compactedPoints; // owns m_points after CompactPoints()
 
 	CurvesBatchData(void)
 		: m_indicesData()
@@ -389,6 +488,39 @@ struct CurvesBatchData
 		m_uvCoord.reserve(2 * curveCount);
 	}
 
+	// LOD drops strands and control points from the index list only; copy the points that are still referenced
+	// into a dense buffer and remap the indices, so dropped points aren't uploaded to RPR
+	void CompactPoints(void)
+	{
+		if ((m_points == nullptr) || m_indicesData.empty())
+			return;
+
+		const rpr_uint unusedPoint = std::numeric_limits<rpr_uint>::max();
+		std::vector<rpr_uint> remap(m_pointCount, unusedPoint);
+
+		std::vector<float> compacted;
+		compacted.reserve(std::min((size_t)m_pointCount, m_indicesData.size()) * 3);
+
+		for (rpr_uint& index : m_indicesData)
+		{
+			assert(index < m_pointCount);
+
+			if (remap[index] == unusedPoint)
+			{
+				remap[index] = (rpr_uint)(compacted.size() / 3);
+
+				const float* point = m_points + (size_t)index * 3;
+				compacted.insert(compacted.end(), point, point + 3);
+			}
+
+			index = remap[index];
+		}
+
+		m_compactedPoints.swap(compacted);
+		m_points = m_compactedPoints.data();
+		m_pointCount = (unsigned int)(m_compactedPoints.size() / 3);
+	}
+
 	frw::Curve CreateRPRCurve(frw::Context& currContext)
 	{
 		return currContext.CreateCurve(m_pointCount, m_points,
@@ -397,7 +529,7 @@ struct CurvesBatchData
 	}
 };
 
-frw::Curve ProcessCurvesBatch(const XGenSplineAPI::XgItSpline& splineIt, frw::Context currContext)
+frw::Curve ProcessCurvesBatch(const XGenSplineAPI::XgItSpline& splineIt, frw::Context currContext, const HairLOD& lod)
 {
 	// create data buffers
 	CurvesBatchData batchData;
@@ -406,13 +538,16 @@ frw::Curve ProcessCurvesBatch(const XGenSplineAPI::XgItSpline& splineIt, frw::Co
 	// for each primitive (for each hair in batch)
 	for (unsigned int currCurveIdx = 0; currCurveIdx < splineIt.primitiveCount(); ++currCurveIdx)
 	{
+		if (!IsHairStrandKept(currCurveIdx, lod))
+			continue;
+
 		unsigned int offset = 0;
 		unsigned int length = 0;
 		std::tie(length, offset) = GetHairLengthOffset(splineIt, currCurveIdx);
 
 		// Write indices and copy points
 		std::vector<rpr_uint> curveIndicesData;
-		ProcessHairPoints(curveIndicesData, offset, length);
+		ProcessHairPoints(curveIndicesData, offset, length, lod.segmentStride);
 		ProcessHairTail(curveIndicesData);
 		assert(curveIndicesData.size() % PointsPerSegment == 0);
 
@@ -428,7 +563,7 @@ frw::Curve ProcessCurvesBatch(const XGenSplineAPI::XgItSpline& splineIt, frw::Co
 		batchData.m_indicesData.insert(batchData.m_indicesData.end(), curveIndicesData.begin(), curveIndicesData.end());
 
 		// Hair segments radiuses
-		ProcessHairWidth(batchData.m_radiuses, splineIt.width(), curveIndicesData);
+		ProcessHairWidth(batchData.m_radiuses, splineIt.width(), curveIndicesData, lod.widthScale);
 	}
 
 	// find size of points array 
@@ -439,6 +574,11 @@ frw::Curve ProcessCurvesBatch(const XGenSplineAPI::XgItSpline& splineIt, frw::Co
 		batchData.m_pointCount = *maxIndexElement + 1;
 	}
 
+	if (!lod.IsFullDetail())
+	{
+		batchData.CompactPoints();
+	}
+
 	// create RPR curve (create batch of hairs)
 	return batchData.CreateRPRCurve(currContext);
 }
@@ -627,10 +767,12 @@ bool FireRenderHairXGenGrooming::CreateCurves()
 	if (!GetCurvesData(splines, fnDagNode))
 		return false;
 
+	HairLOD lod = ComputeHairLOD(context(), MDagPath::getAPathTo(node));
+
 	// create rpr curves (hair batch) for each primitive batch
 	for (XGenSplineAPI::XgItSpline splineIt = splines.iterator(); !splineIt.isDone(); splineIt.next())
 	{
-		m_Curves.push_back(ProcessCurvesBatch(splineIt, Context()));
+		m_Curves.push_back(ProcessCurvesBatch(splineIt, Context(), lod));
 	}
 
 	// apply transform to curves
@@ -701,7 +843,7 @@ void ProcessOrnatrixTextureCoordinates(
 	batchData.m_uvCoord.push_back(coords[0].y());
 }
 
-frw::Curve ProcessCurvesBatch(const std::shared_ptr<Ephere::Plugins::Ornatrix::IHair>& sourceHair, frw::Context currContext)
+frw::Curve ProcessCurvesBatch(const std::shared_ptr<Ephere::Plugins::Ornatrix::IHair>& sourceHair, frw::Context currContext, const HairLOD& lod)
 {
 	// ensure hair is described in supported way
 	assert(EnsureValidOrnatrixHairBatch(sourceHair));
@@ -741,6 +883,9 @@ frw::Curve ProcessCurvesBatch(const std::shared_ptr<Ephere::Plugins::Ornatrix::I
 		currStrandVertexCount = sourceHair->GetStrandPointCount(currCurveIdx);
 		assert(currStrandVertexCount == pointCounts[currCurveIdx]);
 
+		if (!IsHairStrandKept(currCurveIdx, lod))
+			continue;
+
 		// transform vertexes from local space
 		for (int currVtxIdx = 0; currVtxIdx < currStrandVertexCount; currVtxIdx++)
 		{
@@ -756,7 +901,7 @@ frw::Curve ProcessCurvesBatch(const std::shared_ptr<Ephere::Plugins::Ornatrix::I
 
 		// Write indices and copy points
 		std::vector<rpr_uint> curveIndicesData;
-		ProcessHairPoints(curveIndicesData, offset, length);
+		ProcessHairPoints(curveIndicesData, offset, length, lod.segmentStride);
 		ProcessHairTail(curveIndicesData);
 		assert(curveIndicesData.size() % PointsPerSegment == 0);
 
@@ -768,7 +913,12 @@ frw::Curve ProcessCurvesBatch(const std::shared_ptr<Ephere::Plugins::Ornatrix::I
 		batchData.m_indicesData.insert(batchData.m_indicesData.end(), curveIndicesData.begin(), curveIndicesData.end());
 
 		// Hair segments radiuses
-		ProcessHairWidth(batchData.m_radiuses, width.data(), curveIndicesData);
+		ProcessHairWidth(batchData.m_radiuses, width.data(), curveIndicesData, lod.widthScale);
+	}
+
+	if (!lod.IsFullDetail())
+	{
+		batchData.CompactPoints();
 	}
 
 	// create RPR curve (create batch of hairs)
@@ -785,8 +935,10 @@ bool FireRenderHairOrnatrix::CreateCurves()
 	if (sourceHair == nullptr)
 		return false;
 
+	HairLOD lod = ComputeHairLOD(context(), MDagPath::getAPathTo(node));
+
 	// create rpr curves
-	m_Curves.push_back(ProcessCurvesBatch(sourceHair, Context()));
+	m_Curves.push_back(ProcessCurvesBatch(sourceHair, Context(), lod));
 
 	// apply transform to curves
 	ApplyTransform();
@@ -804,7 +956,7 @@ FireRenderHairNHair::FireRenderHairNHair(FireRenderContext* context, const MDagP
 FireRenderHairNHair::~FireRenderHairNHair()
 {}
 
-frw::Curve ProcessCurvesBatch(MRenderLineArray& mainLines, frw::Context currContext)
+frw::Curve ProcessCurvesBatch(MRenderLineArray& mainLines, frw::Context currContext, const HairLOD& lod)
 {	
 	MStatus status;
 
@@ -824,6 +976,11 @@ frw::Curve ProcessCurvesBatch(MRenderLineArray& mainLines, frw::Context currCont
 	int countMainLines = mainLines.length();
 	for (int idx = 0; idx < countMainLines; ++idx, offset += currStrandVertexCount)
 	{
+		// dropped strands are not copied, so offset isn't advanced for them
+		currStrandVertexCount = 0;
+		if (!IsHairStrandKept(idx, lod))
+			continue;
+
 		MRenderLine renderLine = mainLines.renderLine(idx, &status);
 		MVectorArray lineVtxs = renderLine.getLine();
 		currStrandVertexCount = lineVtxs.length();
@@ -839,7 +996,7 @@ frw::Curve ProcessCurvesBatch(MRenderLineArray& mainLines, frw::Context currCont
 
 		// Write indices
 		std::vector<rpr_uint> curveIndicesData;
-		ProcessHairPoints(curveIndicesData, offset, currStrandVertexCount);
+		ProcessHairPoints(curveIndicesData, offset, currStrandVertexCount, lod.segmentStride);
 		ProcessHairTail(curveIndicesData);
 		assert(curveIndicesData.size() % PointsPerSegment == 0);
 
@@ -854,7 +1011,7 @@ frw::Curve ProcessCurvesBatch(MRenderLineArray& mainLines, frw::Context currCont
 		MDoubleArray width = renderLine.getWidth();
 		std::fill_n(std::back_inserter(widths), width.length(), 0.0);
 		width.get(&widths[offset]);
-		ProcessHairWidth(batchData.m_radiuses, widths.data(), curveIndicesData);
+		ProcessHairWidth(batchData.m_radiuses, widths.data(), curveIndicesData, lod.widthScale);
 
 		// Texcoord
 		MDoubleArray parameter = renderLine.getParameter();
@@ -867,6 +1024,13 @@ frw::Curve ProcessCurvesBatch(MRenderLineArray& mainLines, frw::Context currCont
 	}
 
 	batchData.m_points = vertices.data();
+	batchData.m_pointCount = (unsigned int)(vertices.size() / 3);
+
+	// dropped strands are already left out of vertices, this removes points skipped by segment stride
+	if (lod.segmentStride > 1)
+	{
+		batchData.CompactPoints();
+	}
 
 	// create RPR curve (create batch of hairs)
 	return batchData.CreateRPRCurve(currContext);
@@ -905,8 +1069,10 @@ bool FireRenderHairNHair::CreateCurves()
 	int countLeafLines = leafLines.length();
 	int countFlowerLines = flowerLines.length();
 
+	HairLOD lod = ComputeHairLOD(context(), MDagPath::getAPathTo(node));
+
 	// create rpr curves
-	m_Curves.push_back(ProcessCurvesBatch(mainLines, Context()));
+	m_Curves.push_back(ProcessCurvesBatch(mainLines, Context(), lod));
 
 	// clean up
 	mainLines.deleteArray();
@@ -527,19 +527,6 @@ int FireRenderXmlImportCmd::getAttrType(std::string attrTypeStr) {
 	return attrType;
 }
 
-void parseFloat4(std::string data, float fvalue[4]) {
-	std::replace(data.begin(), data.end(), ',', ' '); //replace comas by spaces to simplify string splitting
-
-	std::istringstream iss(data);
-	std::vector<std::string> tokens{ std::istream_iterator<std::string>{iss}, std::istream_iterator<std::string>{} };
-	int i = 0;
-	for (const auto& val : tokens)
-	{
-		fvalue[i] = std::stof(val);
-		++i;
-	}
-}
-
 void enableMaterialFlagByAttr(const std::string& plugName, MFnDependencyNode& nodeFn, bool isMap, float* floatData)
 {
 	if (!isMap && floatData == nullptr)
@@ -700,8 +687,8 @@ void FireRenderXmlImportCmd::parseAttributeParam(MObject shaderNode,
 	{
 		case RPR_MATERIAL_NODE_INPUT_TYPE_FLOAT4:
 		{
-			float fvalue[4] = { 0.f, 0.f, 0.f, 0.f };
-			parseFloat4(attrValue, fvalue);
+			// already parsed by the material loader
+			float fvalue[4] = { attrParam.floatValue[0], attrParam.floatValue[1], attrParam.floatValue[2], attrParam.floatValue[3] };
 
 			bool isColorValue = (attrName.find("color") != std::string::npos)
 				|| (attrName.find("Color") != std::string::npos)
@@ -747,7 +734,7 @@ void FireRenderXmlImportCmd::parseAttributeParam(MObject shaderNode,
 		}
 		case RPR_MATERIAL_NODE_INPUT_TYPE_UINT:
 		{
-			int value = std::stoi(attrValue);
+			int value = (int) attrParam.uintValue;
 
 			// handle special case (for uber)
 			if (attrName == "reflection.mode")
@@ -24,6 +24,9 @@ limitations under the License.
 #include "FireRenderSkyLocator.h"
 
 #include "FireRenderSwatchInstance.h"
+#include "BakedTextureCache.h"
+
+#include <algorithm>
 
 using namespace FireMaya;
 using namespace std::chrono;
@@ -32,7 +35,11 @@ FireRenderMaterialSwatchRender::FireRenderMaterialSwatchRender(MObject obj, MObj
 	MSwatchRenderBase(obj, renderObj, res),
 	m_runningAsyncRender(false),
 	m_finishedAsyncRender(false),
-	m_cancelAsyncRender(false)
+	m_cancelAsyncRender(false),
+	m_resolution(0),
+	m_iterations(0),
+	m_contextIndex(0),
+	m_networkHash(0)
 {
 
 }
@@ -65,11 +72,19 @@ bool FireRenderMaterialSwatchRender::doIteration()
 
 		if (IsFRNode())
 		{
-			if (!setupFRNode())
+			if (!setupFRNode() || loadFromCache())
 			{
 				return true;
 			}
-			getSwatchInstance().enqueSwatch(this);
+
+			FireRenderSwatchInstance& swatchInstance = getSwatchInstance();
+			MObject mnode = node();
+
+			m_contextIndex = swatchInstance.acquireContext();
+			m_shader = swatchInstance.getContext(m_contextIndex).GetShader(mnode);
+			m_volumeShader = swatchInstance.getContext(m_contextIndex).GetVolumeShader(mnode);
+
+			swatchInstance.enqueSwatch(this);
 		}
 		else
 		{
@@ -102,16 +117,17 @@ bool FireRenderMaterialSwatchRender::setupFRNode()
 	auto disableSwatchPlug = nodeFn.findPlug("disableSwatch");
 
 	bool enableSwatches = false;
-	FireRenderGlobalsData::getThumbnailIterCount(&enableSwatches);
+	int iterations = FireRenderGlobalsData::getThumbnailIterCount(&enableSwatches);
 	 
 	if (enableSwatches && (disableSwatchPlug.isNull() || !disableSwatchPlug.asBool()))
 	{
-		FireRenderSwatchInstance& swatchInstance = getSwatchInstance();
-
-		m_shader = swatchInstance.getContext().GetShader(mnode);
-		m_volumeShader = swatchInstance.getContext().GetVolumeShader(mnode);
-
 		m_resolution = resolution();
+		m_iterations = iterations;
+
+		m_nodeId = nodeFn.uuid().asString();
+		m_cacheKey = "swatch";
+		m_cacheKey += iterations;
+		m_networkHash = Scope::GetShadingNetworkHash(mnode);
 
 		return true;
 	}
@@ -119,48 +135,47 @@ bool FireRenderMaterialSwatchRender::setupFRNode()
 	return false;
 }
 
+bool FireRenderMaterialSwatchRender::loadFromCache()
+{
+	std::vector<unsigned char> pixels;
+	bool isStale = false;
+
+	if (!BakedTextureCache::GetSwatchInstance().Load(m_nodeId, m_cacheKey, m_resolution, m_resolution, m_networkHash, false, pixels, isStale))
+		return false;
+
+	image().setPixels(pixels.data(), m_resolution, m_resolution);
+
+	return true;
+}
+
 void FireRenderMaterialSwatchRender::processFromBackgroundThread()
 {
-	if (m_cancelAsyncRender)
-		return;
+	std::vector<float> pixels;
 
 	try
 	{
 		FireRenderSwatchInstance& swatchInstance = getSwatchInstance();
 
-		swatchInstance.getContext().setStartedRendering();
-		// consider using a different mesh depending on surface or value type
-		if (auto mesh = swatchInstance.getContext().getRenderObject<FireRenderMesh>("mesh"))
-		{
-			if (mesh->Elements().size())
-			{
-				if (auto shape = mesh->Element(0).shape)
-				{
-					shape.SetShader(m_shader);
-					shape.SetVolumeShader(m_volumeShader);
-				}
-			}
-		}
+		// low sample preview goes first, full quality swatch is rendered after all queued previews
+		int previewIterations = std::min(m_iterations, PreviewIterationCount);
 
-		if ((swatchInstance.getContext().width() != (unsigned int) m_resolution) || 
-			(swatchInstance.getContext().height() != (unsigned int) m_resolution))
-		{
-			swatchInstance.getContext().setResolution(m_resolution, m_resolution, false);
-		}
+		m_finishedAsyncRender = !m_cancelAsyncRender &&
+			swatchInstance.renderSwatch(m_contextIndex, m_shader, m_volumeShader, m_resolution, previewIterations, m_cancelAsyncRender, pixels);
 
-		swatchInstance.getContext().setDirty();
-		swatchInstance.getContext().m_restartRender = true;
-		swatchInstance.getContext().UpdateCompletionCriteriaForSwatch();
-
-		while (swatchInstance.getContext().keepRenderRunning())
+		if (m_finishedAsyncRender && previewIterations < m_iterations)
 		{
-			if (m_cancelAsyncRender)
-				break;
-
-			swatchInstance.getContext().render();
+			SwatchRefinement refinement;
+			refinement.node = MObjectHandle(node());
+			refinement.nodeId = m_nodeId;
+			refinement.cacheKey = m_cacheKey;
+			refinement.networkHash = m_networkHash;
+			refinement.shader = m_shader;
+			refinement.volumeShader = m_volumeShader;
+			refinement.resolution = m_resolution;
+			refinement.iterations = m_iterations;
+
+			swatchInstance.enqueRefinement(m_contextIndex, refinement);
 		}
-
-		m_finishedAsyncRender = !m_cancelAsyncRender;
 	}
 	catch (...)
 	{
@@ -169,7 +184,7 @@ void FireRenderMaterialSwatchRender::processFromBackgroundThread()
 
 	if (m_finishedAsyncRender)
 	{
-		finalizeRendering();
+		finalizeRendering(pixels);
 	}
 
 	std::unique_lock<std::mutex> lck(m_cancellationMutex);
@@ -177,20 +192,22 @@ void FireRenderMaterialSwatchRender::processFromBackgroundThread()
 	m_cancellationCondVar.notify_one();
 }
 
-bool FireRenderMaterialSwatchRender::finalizeRendering()
+bool FireRenderMaterialSwatchRender::finalizeRendering(const std::vector<float>& pixels)
 {
-	FireRenderContext & context = getSwatchInstance().getContext();
-	//FireRenderSwatchInstance& swatchInstance = getSwatchInstance();
-
-	unsigned int width = context.m_width;
-	unsigned int height = context.m_height;
-	std::vector<float> data = context.getRenderImageData();
-
 	MImage& img = image();
 
-	img.setFloatPixels(data.data(), width, height);
+	img.setFloatPixels(const_cast<float*>(pixels.data()), m_resolution, m_resolution);
 	img.convertPixelFormat(MImage::kByte);
 
+	// full quality swatch is stored right away (otherwise it is done by the refinement)
+	if (m_iterations <= PreviewIterationCount)
+	{
+		const unsigned char* imagePixels = img.pixels();
+		std::vector<unsigned char> swatchPixels(imagePixels, imagePixels + m_resolution * m_resolution * 4);
+
+		BakedTextureCache::GetSwatchInstance().Store(m_nodeId, m_cacheKey, m_resolution, m_resolution, m_networkHash, swatchPixels);
+	}
+
 	finishParallelRender();
 
 	return true;
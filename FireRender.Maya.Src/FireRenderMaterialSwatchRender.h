@@ -32,6 +32,9 @@ class FireRenderMaterialSwatchRender : public MSwatchRenderBase
 public:
 	static const unsigned int MaterialSwatchPreviewTextureSize = 64;
 
+	// Iterations of the quick preview delivered before the full quality swatch
+	static const int PreviewIterationCount = 4;
+
 	// Constructor
 	FireRenderMaterialSwatchRender(MObject obj, MObject renderObj, int res);
 
@@ -48,16 +51,18 @@ public:
 	void processFromBackgroundThread();
 
 	void setAsyncRunning(bool val) { m_runningAsyncRender = val; }
+	size_t getContextIndex() const { return m_contextIndex; }
 
 	// Creator function
 	static MSwatchRenderBase* creator(MObject dependNode, MObject renderNode, int imageResolution);
 
 private:
 	bool doIterationForNonFRNode();
-	bool finalizeRendering();
+	bool finalizeRendering(const std::vector<float>& pixels);
 
 	bool IsFRNode() const;
 	bool setupFRNode();
+	bool loadFromCache();
 
 private:
 	std::atomic<bool> m_runningAsyncRender;
@@ -68,6 +73,15 @@ private:
 	frw::Shader m_volumeShader;
 
 	int m_resolution;
+	int m_iterations;
+
+	// swatch instance context the shaders were parsed in
+	size_t m_contextIndex;
+
+	// persistent swatch cache key
+	MString m_nodeId;
+	MString m_cacheKey;
+	uint64_t m_networkHash;
 
 	// for cancelation synchronization
 	std::mutex m_cancellationMutex;
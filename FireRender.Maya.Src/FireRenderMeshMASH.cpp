@@ -25,6 +25,88 @@ void FireRenderMeshMASH::SetSelfTransform(const MMatrix& matrix)
 	m_SelfTransform = matrix;
 }
 
+void FireRenderMeshMASH::CreateInstanceShapes(size_t instanceCount, std::vector<frw::Shape>& outShapes)
+{
+	outShapes.clear();
+
+	if (m.elements.empty() || (instanceCount == 0))
+		return;
+
+	// render stats are the same for all instances
+	MFnDependencyNode depNode(Object());
+	bool visibleInReflections = depNode.findPlug("visibleInReflections").asBool();
+	bool visibleInRefractions = depNode.findPlug("visibleInRefractions").asBool();
+	bool castsShadows = depNode.findPlug("castsShadows").asBool();
+	bool primaryVisibility = depNode.findPlug("primaryVisibility").asBool();
+
+	// faces of each shader are also the same, so split them once
+	const std::vector<int>& faceMaterialIndices = GetFaceMaterialIndices();
+	std::vector<std::vector<std::vector<int>>> elementFaceIds(m.elements.size());
+	for (size_t elementIdx = 0; elementIdx < m.elements.size(); ++elementIdx)
+	{
+		const FrElement& element = m.elements[elementIdx];
+		if (element.shaders.size() < 2)
+			continue;
+
+		std::vector<std::vector<int>>& faceIds = elementFaceIds[elementIdx];
+		faceIds.resize(element.shaders.size());
+		for (int faceIdx = 0; faceIdx < faceMaterialIndices.size(); ++faceIdx)
+		{
+			int shaderIdx = faceMaterialIndices[faceIdx];
+			if ((shaderIdx >= 0) && (shaderIdx < faceIds.size()))
+				faceIds[shaderIdx].push_back(faceIdx);
+		}
+	}
+
+	frw::Context context = Context();
+	outShapes.reserve(instanceCount * m.elements.size());
+
+	for (size_t instanceIdx = 0; instanceIdx < instanceCount; ++instanceIdx)
+	{
+		for (size_t elementIdx = 0; elementIdx < m.elements.size(); ++elementIdx)
+		{
+			const FrElement& element = m.elements[elementIdx];
+			if (!element.shape)
+			{
+				outShapes.emplace_back();
+				continue;
+			}
+
+			frw::Shape shape = element.shape.CreateInstance(context);
+
+			if (element.shaders.size() == 1)
+			{
+				shape.SetShader(element.shaders.front());
+			}
+			else
+			{
+				for (size_t shaderIdx = 0; shaderIdx < element.shaders.size(); ++shaderIdx)
+				{
+					shape.SetPerFaceShader(element.shaders[shaderIdx], elementFaceIds[elementIdx][shaderIdx]);
+				}
+			}
+
+			bool isCatcher = false;
+			for (const frw::Shader& shader : element.shaders)
+			{
+				isCatcher = isCatcher || shader.IsShadowCatcher() || shader.IsReflectionCatcher();
+			}
+
+			if (element.volumeShader)
+			{
+				shape.SetVolumeShader(element.volumeShader);
+			}
+
+			shape.SetReflectionVisibility(visibleInReflections && !isCatcher);
+			shape.setRefractionVisibility(visibleInRefractions && !isCatcher);
+			shape.SetShadowFlag(castsShadows);
+			shape.SetPrimaryVisibility(primaryVisibility);
+
+			outShapes.push_back(shape);
+		}
+	}
+}
+
 bool FireRenderMeshMASH::IsMeshVisible(const MDagPath& meshPath, const FireRenderContext* context) const
 {
 	(void)meshPath;
@@ -26,6 +26,12 @@ public:
 
 	const FireRenderMesh& GetOriginalFRMeshinstancedObject() const { return m_originalFRMesh; }
 
+	/** Creates instanceCount RPR instances of translated shapes with the same shaders and render stats, elements count shapes per instance */
+	void CreateInstanceShapes(size_t instanceCount, std::vector<frw::Shape>& outShapes);
+
+	/** Forces mesh reload on next Rebuild, used when the instancer sees the prototype shape being edited */
+	void MarkMeshChanged(void) { m.changed.mesh = true; }
+
 	virtual void Rebuild(void) override;
 	virtual bool PreProcessMesh(unsigned int sampleIdx = 0) override;
 
@@ -680,12 +680,16 @@ FireRenderMesh::~FireRenderMesh()
 
 void FireRenderMesh::clear()
 {
+	context()->ReleaseCachedGeometry(TakeGeometryCacheHash());
 	m.elements.clear();
 	FireRenderObject::clear();
 }
 
 void FireRenderMeshCommon::detachFromScene()
 {
+	// let identical meshes translated later upload their own geometry instead of instancing shapes of a detached mesh
+	context()->ReleaseCachedGeometry(TakeGeometryCacheHash());
+
 	if (!m_isVisible)
 		return;
 
@@ -698,6 +702,9 @@ void FireRenderMeshCommon::detachFromScene()
 		}
 	}
 	m_isVisible = false;
+
+	context()->AddScenePolygonCount(-(long long)m_attachedPolygonCount);
+	m_attachedPolygonCount = 0;
 }
 
 void FireRenderMeshCommon::attachToScene()
@@ -707,12 +714,24 @@ void FireRenderMeshCommon::attachToScene()
 
 	if (auto scene = context()->GetScene())
 	{
+		size_t attachedPolygonCount = 0;
+
 		for (auto element : m.elements)
 		{
 			if (auto shape = element.shape)
+			{
 				scene.Attach(shape);
+
+				size_t polygonCount = 0;
+				rprMeshGetInfo(shape.Handle(), RPR_MESH_POLYGON_COUNT, sizeof(polygonCount), &polygonCount, nullptr);
+				attachedPolygonCount += polygonCount;
+			}
 		}
 		m_isVisible = true;
+
+		// scene polygon count for render statistics is kept up to date here instead of walking all shapes after render
+		m_attachedPolygonCount = attachedPolygonCount;
+		context()->AddScenePolygonCount((long long)m_attachedPolygonCount);
 	}
 }
 
@@ -1637,6 +1656,9 @@ void FireRenderMesh::GetShapes(std::vector<frw::Shape>& outShapes)
 	{
 		bool success = mainMesh->TranslateMeshWrapped(dagPath, outShapes);
 		assert(success);
+
+		// shapes are used by this mesh, so is the geometry cache entry they came from
+		m_geometryCacheHash = mainMesh->TakeGeometryCacheHash();
 	}
 
 	if (mainMesh == nullptr)
@@ -1674,7 +1696,8 @@ bool FireRenderMesh::TranslateMeshWrapped(const MDagPath& dagPath, std::vector<f
 		MFnDagNode dagNode(Object());
 		MString name = dagNode.fullPathName();
 		assert(m_meshData.IsInitialized());
-		outShapes = FireMaya::MeshTranslator::TranslateMesh(m_meshData, context->GetContext(), Object(), m.faceMaterialIndices, motionSamplesCount, dagPath.fullPathName());
+		context->ReleaseCachedGeometry(TakeGeometryCacheHash());
+		outShapes = FireMaya::MeshTranslator::TranslateMesh(m_meshData, context->GetContext(), Object(), m.faceMaterialIndices, motionSamplesCount, dagPath.fullPathName(), context->GetGeometryCache(), &m_geometryCacheHash);
 	}
 
 	m.isPreProcessed = false;
@@ -1924,10 +1947,7 @@ bool FireRenderMesh::PreProcessMesh(unsigned int sampleIdx /*= 0*/)
 		context->AddMainMesh(this);
 	}
 
-	bool finishedPreProcessing = deformationMotionBlurEnabled ? (motionSamplesCount == sampleIdx + 1) : true;
-	if (!finishedPreProcessing)
-		return success;
-
+	// all deformation motion samples are read together with the first one
 	m.isPreProcessed = true;
 
 	return success;
@@ -1936,10 +1956,64 @@ bool FireRenderMesh::PreProcessMesh(unsigned int sampleIdx /*= 0*/)
 //===================
 // Light
 //===================
+namespace
+{
+	// Rough estimate of the power emitted by a light, used only to rank lights against each other
+	float EstimateLightPower(const MObject& node, bool& isInfinite)
+	{
+		MFnDependencyNode depNode(node);
+		isInfinite = false;
+
+		if (depNode.typeId() == FireMaya::TypeId::FireRenderPhysicalLightLocator)
+		{
+			PLType lightType = PhysicalLightAttributes::GetLightType(depNode);
+			isInfinite = (lightType == PLTDirectional);
+
+			MColor color = (PhysicalLightAttributes::GetColorMode(depNode) == PLCTemperature) ?
+				PhysicalLightAttributes::GetTempreratureColor(depNode) : PhysicalLightAttributes::GetColor(depNode);
+
+			float power = PhysicalLightAttributes::GetIntensity(depNode) * std::max({ color.r, color.g, color.b });
+
+			PLIntensityUnit units = PhysicalLightAttributes::GetIntensityUnits(depNode);
+			if (units == PLTIULumen || units == PLTIULuminance)
+			{
+				float efficacy = PhysicalLightAttributes::GetLuminousEfficacy(depNode);
+				power /= std::max(efficacy, 1.0f);
+			}
+
+			// luminance and radiance are given per unit area
+			if (lightType == PLTArea && (units == PLTIULuminance || units == PLTIURadiance))
+			{
+				power *= PhysicalLightAttributes::GetAreaWidth(depNode) * PhysicalLightAttributes::GetAreaLength(depNode);
+			}
+
+			return power;
+		}
+
+		if (node.hasFn(MFn::kLight))
+		{
+			MFnLight fnLight(node);
+			isInfinite = node.hasFn(MFn::kDirectionalLight) || node.hasFn(MFn::kAmbientLight);
+
+			MColor color = fnLight.color();
+			return fnLight.intensity() * std::max({ color.r, color.g, color.b });
+		}
+
+		// other light locators (IES, VRay lights); use intensity if present
+		MPlug intensityPlug = depNode.findPlug("intensity");
+
+		return intensityPlug.isNull() ? 1.0f : intensityPlug.asFloat();
+	}
+}
+
 FireRenderLight::FireRenderLight(FireRenderContext* context, const MDagPath& dagPath) :
 	FireRenderNode(context, dagPath),
 	m_light(FrLight()),
-	m_portal(false)
+	m_portal(false),
+	m_culled(false),
+	m_alwaysKeep(false),
+	m_cullingInfinite(false),
+	m_cullingPower(0.0f)
 {}
 
 FireRenderLight::~FireRenderLight()
@@ -1972,7 +2046,7 @@ void FireRenderLight::detachFromScene()
 
 void FireRenderLight::attachToScene()
 {
-	if (m_isVisible)
+	if (m_isVisible || m_culled)
 		return;
 	if (auto scene = Scene())
 	{
@@ -2071,6 +2145,11 @@ void FireRenderLight::Freshen(bool shouldCalculateHash)
 			FireMaya::translateLight(m_light, context()->GetScope(), Context(), node, mMtx);
 		}
 
+		m_cullingPower = EstimateLightPower(node, m_cullingInfinite);
+
+		MPlug alwaysKeepPlug = depNode.findPlug("RPRAlwaysKeepLight");
+		m_alwaysKeep = !alwaysKeepPlug.isNull() && alwaysKeepPlug.asBool();
+
 		if (dagPath.isVisible())
 		{
 			attachToScene();
@@ -2080,6 +2159,32 @@ void FireRenderLight::Freshen(bool shouldCalculateHash)
 	FireRenderNode::Freshen(shouldCalculateHash);
 }
 
+bool FireRenderLight::SetCulled(bool culled)
+{
+	if (m_culled == culled)
+		return false;
+
+	bool wasVisible = IsVisible();
+
+	if (culled)
+	{
+		detachFromScene();
+		m_culled = true;
+	}
+	else
+	{
+		m_culled = false;
+
+		const MDagPath& dagPath = DagPath();
+		if (dagPath.isValid() && dagPath.isVisible())
+		{
+			attachToScene();
+		}
+	}
+
+	return wasVisible != IsVisible();
+}
+
 void FireRenderLight::buildSwatchLight()
 {
 	m_light.light = Context().CreateDirectionalLight();
@@ -2767,6 +2872,9 @@ void FireRenderSky::Freshen(bool shouldCalculateHash)
 
 	if (dagPath.isValid())
 	{
+		// interactive renders start with a low resolution sky while the full one is generated
+		m_skyBuilder->setProgressive(context()->isInteractive());
+
 		if (FireMaya::translateSky(m_envLight, m_sunLight, m_image, *m_skyBuilder, Context(), node, dagPath.inclusiveMatrix(), m_initialized))
 		{
 			setPortal_Sky(dagPath.transform(), this);
@@ -2788,6 +2896,11 @@ void FireRenderSky::Freshen(bool shouldCalculateHash)
 	FireRenderNode::Freshen(shouldCalculateHash);
 }
 
+void FireRenderSky::PrecomputeFrames(const std::vector<MTime>& times)
+{
+	m_skyBuilder->precomputeFrames(times);
+}
+
 void FireRenderSky::attachPortals()
 {
 	detachPortals();
@@ -18,6 +18,7 @@ limitations under the License.
 #include <maya/MDagMessage.h>
 #include <maya/MPlug.h>
 #include <maya/MFnFluid.h>
+#include <maya/MTime.h>
 #include <string>
 #include <atomic>
 #include "FireMaya.h"
@@ -305,6 +306,12 @@ public:
 	// translate mesh
 	virtual bool TranslateMeshWrapped(const MDagPath& dagPath, std::vector<frw::Shape>& outShapes) { return false; }
 
+	// Returns geometry cache entry used by the last translated shapes and passes its ownership to the caller
+	uint64_t TakeGeometryCacheHash(void) { uint64_t hash = m_geometryCacheHash; m_geometryCacheHash = 0; return hash; }
+
+	// motion blur is enabled in render settings and in render stats of the mesh
+	bool IsMotionBlurEnabled(const MFnDagNode& meshFn);
+
 protected:
 	// Detach from the scene
 	virtual void detachFromScene() override;
@@ -321,8 +328,6 @@ protected:
 	void ProcessMotionBlur(const MFnDagNode& meshFn);
 	virtual bool IsMeshVisible(const MDagPath& meshPath, const FireRenderContext* context) const = 0;
 
-	bool IsMotionBlurEnabled(const MFnDagNode& meshFn);
-
 
 protected:
 
@@ -350,6 +355,12 @@ protected:
 	// this is the limitation of Maya's relationship editor
 	// thus, it is correct to match filename with UV map index
 	std::unordered_map<std::string /*texture file name*/, unsigned int /*UV map index*/ > m_uvSetCachedMappingData;
+
+	// polygons of the shapes attached to the scene, added to the context polygon count
+	size_t m_attachedPolygonCount = 0;
+
+	// geometry cache entry used by the shapes of this mesh (0 if they aren't shared)
+	uint64_t m_geometryCacheHash = 0;
 };
 
 // Fire render mesh
@@ -469,6 +480,15 @@ public:
 	// return portal
 	bool portal();
 
+	// light culling support: rough emitted power estimated on Freshen
+	float GetCullingPower() const { return m_cullingPower; }
+	bool IsInfinite() const { return m_cullingInfinite; }
+	bool IsAlwaysKept() const { return m_alwaysKeep; }
+	bool IsCulled() const { return m_culled; }
+
+	// excludes the light from the scene (or brings it back) without retranslating it, returns true if the light visibility has changed
+	bool SetCulled(bool culled);
+
 protected:
 	void UpdateTransform(const MMatrix& matrix) override;
 
@@ -484,6 +504,12 @@ protected:
 
 	// portal flag
 	bool m_portal;
+
+	// light culling data
+	bool m_culled;
+	bool m_alwaysKeep;
+	bool m_cullingInfinite;
+	float m_cullingPower;
 };
 
 class FireRenderPhysLight : public FireRenderLight
@@ -664,6 +690,9 @@ public:
 	// Detach portals.
 	void detachPortals();
 
+	// Generate sky images of the given frames ahead of a batch render.
+	void PrecomputeFrames(const std::vector<MTime>& times);
+
 public:
 	// The environment light.
 	frw::EnvironmentLight m_envLight;
@@ -20,6 +20,7 @@ limitations under the License.
 #include <thread>
 #include <maya/MCommonRenderSettingsData.h>
 #include <maya/MRenderUtil.h>
+#include <maya/MAnimControl.h>
 
 #include "FireRenderGlobals.h"
 #include "FireRenderUtils.h"
@@ -27,10 +28,11 @@ limitations under the License.
 #include "RenderViewUpdater.h"
 
 #include "TileRenderer.h"
-#include "Athena/athenaWrap.h"
+#include "TelemetrySpool.h"
 
 #include "RenderStampUtils.h"
 #include "GlobalRenderUtilsDataHolder.h"
+#include "RenderStats.h"
 #include <iostream>
 #include <fstream>
 
@@ -286,9 +288,12 @@ bool FireRenderProduction::Init(int contextWidth, int contextHeight, RenderRegio
 	if (m_width == 0 || m_height == 0)
 		return false;
 
+	RenderStats::BeginFrame(static_cast<int>(MAnimControl::currentTime().value()), "production");
+
 	m_contextPtr->setCallbackCreationDisabled(true);
 	if (!m_contextPtr->buildScene(false, false, false))
 	{
+		RenderStats::EndFrame();
 		return false;
 	}
 
@@ -515,22 +520,24 @@ bool FireRenderProduction::stop()
 		}
 	}
 
+	RenderStats::EndFrame();
+
 	return true;
 }
 
 // -----------------------------------------------------------------------------
 template <class T>
-void WriteAthenaFieldAsString(const std::string& fieldName, const T& data)
+void WriteAthenaFieldAsString(TelemetryRecord& record, const std::string& fieldName, const T& data)
 {
 	std::ostringstream ss;
 	ss << data;
-	AthenaWrapper::GetAthenaWrapper()->WriteField(fieldName, ss.str());
+	record.Add(fieldName, ss.str());
 }
 
 template <class T>
-void WriteAthenaField(const std::string& fieldName, const T& data)
+void WriteAthenaField(TelemetryRecord& record, const std::string& fieldName, const T& data)
 {
-	AthenaWrapper::GetAthenaWrapper()->WriteField(fieldName, data);
+	record.Add(fieldName, data);
 }
 
 #if defined(OSMac_)
@@ -572,41 +579,45 @@ void FireRenderProduction::UploadAthenaData()
 	return;
 #endif
 
-	AthenaWrapper::GetAthenaWrapper()->StartNewFile();
+	// user opted out with athenaEnable -ae 0, nothing is written to the spool either
+	if (!TelemetrySpool::IsEnabled())
+		return;
+
+	TelemetryRecord record;
 
 	// operating system
 #if defined(_WIN32)
 	std::string osName;
 	std::string osVersion;
 	getOSName(osName, osVersion);
-	WriteAthenaField("OS Name", osName);
-	WriteAthenaField("OS Version", osVersion);
+	WriteAthenaField(record, "OS Name", osName);
+	WriteAthenaField(record, "OS Version", osVersion);
 
 	// - Get the timezone info.
 	std::string timezoneName;
 	getTimeZone(timezoneName);
-	WriteAthenaField("OS TZ", timezoneName);
+	WriteAthenaField(record, "OS TZ", timezoneName);
 
 #elif defined(__APPLE__)
     char buffer[1024];
 
     getTimeZone(buffer, sizeof(buffer)/sizeof(buffer[0]));
-    WriteAthenaField("OS TZ", buffer);
+    WriteAthenaField(record, "OS TZ", buffer);
 
     getOSName(buffer, sizeof(buffer)/sizeof(buffer[0]));
-    WriteAthenaField("OS Name", buffer);
+    WriteAthenaField(record, "OS Name", buffer);
 
     getOSVersion(buffer, sizeof(buffer)/sizeof(buffer[0]));
-    WriteAthenaField("OS Version", buffer);
+    WriteAthenaField(record, "OS Version", buffer);
 #elif defined(__linux__)
-	WriteAthenaField("OS Name", "Linux");
+	WriteAthenaField(record, "OS Name", "Linux");
 #endif
 
 	// os arch
-	WriteAthenaField("OS Arch", "64bit");
+	WriteAthenaField(record, "OS Arch", "64bit");
 
 	// plug-in version
-	WriteAthenaFieldAsString("ProRender Plugin Version", PLUGIN_VERSION);
+	WriteAthenaFieldAsString(record, "ProRender Plugin Version", PLUGIN_VERSION);
 
 	// core version
 #ifdef RPR_VERSION_MAJOR_MINOR_REVISION
@@ -620,29 +631,29 @@ void FireRenderProduction::UploadAthenaData()
 	oss << std::hex << mj << "." << mn;
 #endif
 
-	WriteAthenaField("ProRender Core Version", oss.str());
+	WriteAthenaField(record, "ProRender Core Version", oss.str());
 
 	// host application
-	WriteAthenaField("Host App", "Maya");
+	WriteAthenaField(record, "Host App", "Maya");
 
 	// render time
-	WriteAthenaField("Seconds spent on render", m_contextPtr->m_secondsSpentOnLastRender);
+	WriteAthenaField(record, "Seconds spent on render", m_contextPtr->m_secondsSpentOnLastRender);
 
 	// device used
 	// - CPU Name
 	std::string CPUName = RenderStampUtils::GetCPUNameString();
-	WriteAthenaField("CPU Name", CPUName);
+	WriteAthenaField(record, "CPU Name", CPUName);
 
 	// - CPU Cores
 	int numCPU = getNumCPUCores();
-	WriteAthenaField("CPU Cores", numCPU);
+	WriteAthenaField(record, "CPU Cores", numCPU);
 
 	// - GPU0 Name
 	std::vector<HardwareResources::Device> allDevices = HardwareResources::GetAllDevices();
 	if (allDevices.size() > 0)
 	{
 		std::string GPU0Name = allDevices[0].name;
-		WriteAthenaField("GPU0 Name", GPU0Name);
+		WriteAthenaField(record, "GPU0 Name", GPU0Name);
 	}
 
 	// - GPU1 Name
@@ -650,7 +661,7 @@ void FireRenderProduction::UploadAthenaData()
 	GPU1Name.reserve(allDevices.size());
 	for (HardwareResources::Device& device : allDevices)
 		GPU1Name.push_back(device.name);
-	WriteAthenaField("GPU1 Name", GPU1Name);
+	WriteAthenaField(record, "GPU1 Name", GPU1Name);
 
 	// - device used
 	int renderDevice = RenderStampUtils::GetRenderDevice();
@@ -658,21 +669,21 @@ void FireRenderProduction::UploadAthenaData()
 	{
 		case RenderStampUtils::RPR_RENDERDEVICE_CPUONLY:
 		{
-			WriteAthenaField("CPU Enabled", true);
-			WriteAthenaField("GPU0 Enabled", false);
+			WriteAthenaField(record, "CPU Enabled", true);
+			WriteAthenaField(record, "GPU0 Enabled", false);
 			break;
 		}
 
 		case RenderStampUtils::RPR_RENDERDEVICE_GPUONLY:
 		{
-			WriteAthenaField("CPU Enabled", false);
-			WriteAthenaField("GPU0 Enabled", true);
+			WriteAthenaField(record, "CPU Enabled", false);
+			WriteAthenaField(record, "GPU0 Enabled", true);
 			break;
 		}
 
 		default: // CPU+GPU
-			WriteAthenaField("CPU Enabled", true);
-			WriteAthenaField("GPU0 Enabled", true);
+			WriteAthenaField(record, "CPU Enabled", true);
+			WriteAthenaField(record, "GPU0 Enabled", true);
 	}
 
 	std::vector<bool> gpusUsed;
@@ -683,54 +694,54 @@ void FireRenderProduction::UploadAthenaData()
 	for (size_t idx = 0; idx < numDevices; ++idx)
 		gpusUsed.push_back(devicesUsing[(unsigned int)idx] != 0);
 
-	WriteAthenaField("GPU1 Enabled", gpusUsed);
+	WriteAthenaField(record, "GPU1 Enabled", gpusUsed);
 
 	// polygon count
-	WriteAthenaField("Num Polygons", GetScenePolyCount());
+	WriteAthenaField(record, "Num Polygons", m_contextPtr->GetScenePolygonCount());
 
 	// render resolution
 	std::vector<unsigned int> imgRes = { m_width, m_height };
-	WriteAthenaField("Resolution", imgRes);
+	WriteAthenaField(record, "Resolution", imgRes);
 
 	// render result
 	switch (m_contextPtr->m_lastRenderResultState)
 	{
 		case FireRenderContext::COMPLETED:
 		{
-			WriteAthenaField("End status", "successfull | completed");
+			WriteAthenaField(record, "End status", "successfull | completed");
 			break;
 		}
 
 		case FireRenderContext::CANCELED:
 		{
-			WriteAthenaField("End status", "successfull | cancelled");
+			WriteAthenaField(record, "End status", "successfull | cancelled");
 			break;
 		}
 
 		case FireRenderContext::CRASHED:
 		{
-			WriteAthenaField("End status", "failed | crashed");
+			WriteAthenaField(record, "End status", "failed | crashed");
 			break;
 		}
 
 		default:
-			WriteAthenaField("End status", "failed | error!");
+			WriteAthenaField(record, "End status", "failed | error!");
 	}
 
 	// locale
 	const char* currLocale = std::setlocale(LC_NUMERIC, "");
-	WriteAthenaFieldAsString("OS Locale", currLocale);
+	WriteAthenaFieldAsString(record, "OS Locale", currLocale);
 
 	// lights
-	WriteAthenaField("Lights Count", m_contextPtr->GetScene().LightObjectCount());
+	WriteAthenaField(record, "Lights Count", m_contextPtr->GetScene().LightObjectCount());
 
 	// time and date
 	auto curr = std::chrono::system_clock::now();
 	std::time_t currTime = std::chrono::system_clock::to_time_t(curr);
-	WriteAthenaField("Stop Time", std::string(std::ctime(&currTime)) );
+	WriteAthenaField(record, "Stop Time", std::string(std::ctime(&currTime)) );
 
 	std::time_t renderStartTime = std::chrono::system_clock::to_time_t(m_contextPtr->m_lastRenderStartTime);
-	WriteAthenaField("Start Time", std::string(std::ctime(&renderStartTime)) );
+	WriteAthenaField(record, "Start Time", std::string(std::ctime(&renderStartTime)) );
 
 	// aov's
 	static std::map<unsigned int, std::string> aovNames =
@@ -776,28 +787,28 @@ void FireRenderProduction::UploadAthenaData()
 		if (m_contextPtr->isAOVEnabled(aovID))
 			aovsUsed.push_back(aovNames[aovID]);
 
-	WriteAthenaField("AOVs Enabled", aovsUsed);
+	WriteAthenaField(record, "AOVs Enabled", aovsUsed);
 
 	// completed iterations
-	WriteAthenaField("Samples", m_contextPtr->m_currentIteration);
+	WriteAthenaField(record, "Samples", m_contextPtr->m_currentIteration);
 
 	// textures
 	size_t countTextures = 0;
 	long long texturesSize = 0;
-	std::tie(countTextures, texturesSize) = GeSceneTexturesCountAndSize();
-	WriteAthenaField("Num Textures", countTextures);
-	WriteAthenaField("Textures Size", texturesSize/1000);
+	std::tie(countTextures, texturesSize) = m_contextPtr->GetScope().GetCachedImagesCountAndSize();
+	WriteAthenaField(record, "Num Textures", countTextures);
+	WriteAthenaField(record, "Textures Size", texturesSize/1000);
 
 	// ray depth
-	WriteAthenaField("Ray Depth", m_globals.maxRayDepth);
-	WriteAthenaField("Diffuse Ray Depth", m_globals.maxRayDepthDiffuse);
-	WriteAthenaField("Reflection Ray Depth", m_globals.maxRayDepthGlossy);
-	WriteAthenaField("Refraction Ray Depth", m_globals.maxRayDepthRefraction);
-	WriteAthenaField("Shadow Ray Depth", m_globals.maxRayDepthShadow);
+	WriteAthenaField(record, "Ray Depth", m_globals.maxRayDepth);
+	WriteAthenaField(record, "Diffuse Ray Depth", m_globals.maxRayDepthDiffuse);
+	WriteAthenaField(record, "Reflection Ray Depth", m_globals.maxRayDepthGlossy);
+	WriteAthenaField(record, "Refraction Ray Depth", m_globals.maxRayDepthRefraction);
+	WriteAthenaField(record, "Shadow Ray Depth", m_globals.maxRayDepthShadow);
 
 	// maya version
 	MString mayaVer = MGlobal::mayaVersion();
-	WriteAthenaFieldAsString("App Version", mayaVer.asChar());
+	WriteAthenaFieldAsString(record, "App Version", mayaVer.asChar());
 
 	// denoiser
 	static std::map<FireRenderGlobals::DenoiserType, std::string> denoiserName =
@@ -809,7 +820,7 @@ void FireRenderProduction::UploadAthenaData()
 	};
 
 	bool isDenoiserEnabled = m_globals.denoiserSettings.enabled;
-	WriteAthenaField("RIF Type", isDenoiserEnabled ? denoiserName[m_globals.denoiserSettings.type] : "Not Enabled");
+	WriteAthenaField(record, "RIF Type", isDenoiserEnabled ? denoiserName[m_globals.denoiserSettings.type] : "Not Enabled");
 
 	RenderType renderType = m_contextPtr->GetRenderType();
 	RenderQuality quality = GetRenderQualityForRenderType(renderType);
@@ -820,49 +831,10 @@ void FireRenderProduction::UploadAthenaData()
 		{RenderQuality::RenderQualityMedium, "Medium"},
 		{RenderQuality::RenderQualityLow, "Low"},
 	};
-	WriteAthenaField("Quality", renderQualityName[quality]);
+	WriteAthenaField(record, "Quality", renderQualityName[quality]);
 
-	AthenaWrapper::GetAthenaWrapper()->AthenaSendFile(pythonCallWrap);
-}
-
-std::tuple<size_t, long long> FireRenderProduction::GeSceneTexturesCountAndSize() const
-{
-	size_t data_size = 0;
-	rprContextGetInfo(m_contextPtr->context(), RPR_CONTEXT_LIST_CREATED_IMAGES, 0, nullptr, &data_size);
-	std::vector<rpr_image> images(data_size / sizeof(rpr_image));
-	rprContextGetInfo(m_contextPtr->context(), RPR_CONTEXT_LIST_CREATED_IMAGES, data_size, images.data(), &data_size);
-
-	long long texturesSize = 0;
-
-	for (auto image : images) 
-	{
-		size_t data_size = 0;
-		rprImageGetInfo(image, RPR_IMAGE_DATA_SIZEBYTE, 0, nullptr, &data_size);
-
-		long long temp;
-		rprImageGetInfo(image, RPR_IMAGE_DATA_SIZEBYTE, data_size, &temp, nullptr);
-
-		texturesSize += temp;
-	}
-
-	return std::make_tuple(images.size(), texturesSize);
-}
-
-size_t FireRenderProduction::GetScenePolyCount() const
-{
-	size_t shapeCount = 0;
-	auto status = rprSceneGetInfo(m_contextPtr->scene(), RPR_SCENE_SHAPE_LIST, 0, nullptr, &shapeCount);
-	shapeCount /= sizeof(rpr_shape);
-	if (status != RPR_SUCCESS || shapeCount == 0) return 0;
-
-	std::vector<rpr_shape> shapes(shapeCount);
-	status = rprSceneGetInfo(m_contextPtr->scene(), RPR_SCENE_SHAPE_LIST, shapeCount * sizeof(rpr_shape), shapes.data(), nullptr);
-	return std::accumulate(std::begin(shapes), std::end(shapes), (size_t)0, [](size_t accumulator, const rpr_shape shape) 
-		{
-			size_t polygonCount = 0;
-			rprMeshGetInfo(shape, RPR_MESH_POLYGON_COUNT, sizeof(polygonCount), &polygonCount, nullptr);
-			return accumulator + polygonCount;
-		});
+	// sent from the background thread, or kept in the spool if the node is offline
+	TelemetrySpool::Enqueue(std::move(record));
 }
 
 bool FireRenderProduction::RunOnViewportThread()
@@ -1098,6 +1070,8 @@ void FireRenderProduction::RenderFullFrame()
 			MString filePath = GlobalRenderUtilsDataHolder::GetGlobalRenderUtilsDataHolder()->FolderPath().c_str();
 			filePath += m_contextPtr->m_currentIteration;
 			filePath += ".jpg";
+
+			RenderStats::Scope statsScope("output", "Write intermediate image");
 			m_renderViewAOV->writeToFile(*m_contextPtr, filePath, colorOnly, imageFormat);
 
 			std::ofstream timeLoggingFile;
@@ -138,13 +138,9 @@ private:
 	/** Refresh the context. */
 	void refreshContext();
 
-	/* Gather and send render data by Athena */
+	/* Gather render data and queue it for sending by Athena */
 	void UploadAthenaData();
 
-	size_t GetScenePolyCount() const;
-
-	std::tuple<size_t, long long> GeSceneTexturesCountAndSize() const;
-
 	void OnBufferAvailableCallback(float progress);
 
 private:
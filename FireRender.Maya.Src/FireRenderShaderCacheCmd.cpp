@@ -0,0 +1,244 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#include "FireRenderShaderCacheCmd.h"
+
+#include "Context/ContextCreator.h"
+#include "FireRenderThread.h"
+#include "FireRenderUtils.h"
+#include "Logger.h"
+#include "StartupContextChecker.h"
+
+#include <maya/MGlobal.h>
+
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// Uber material layers, each of them enables its own kernel features
+	const rpr_material_node_input WARMUP_UBER_LAYERS[] =
+	{
+		RPR_MATERIAL_INPUT_UBER_DIFFUSE_WEIGHT,
+		RPR_MATERIAL_INPUT_UBER_REFLECTION_WEIGHT,
+		RPR_MATERIAL_INPUT_UBER_REFRACTION_WEIGHT,
+		RPR_MATERIAL_INPUT_UBER_COATING_WEIGHT,
+		RPR_MATERIAL_INPUT_UBER_SHEEN_WEIGHT,
+		RPR_MATERIAL_INPUT_UBER_SSS_WEIGHT,
+		RPR_MATERIAL_INPUT_UBER_EMISSION_WEIGHT,
+		RPR_MATERIAL_INPUT_UBER_TRANSPARENCY
+	};
+
+	const int WARMUP_RESOLUTION = 32;
+	const int WARMUP_ITERATIONS = 1;
+
+	// Surface and volume shader pairs covering material features typically used in scenes
+	std::vector<std::pair<frw::Shader, frw::Shader>> CreateWarmupShaders(FireRenderContext& context)
+	{
+		std::vector<std::pair<frw::Shader, frw::Shader>> shaders;
+
+		frw::MaterialSystem materialSystem = context.GetScope().MaterialSystem();
+		frw::Context rprContext = context.GetContext();
+
+		auto createUber = [&](rpr_material_node_input enabledLayer, bool allLayers)
+		{
+			frw::Shader shader(materialSystem, rprContext);
+
+			for (rpr_material_node_input layer : WARMUP_UBER_LAYERS)
+			{
+				bool enabled = allLayers || (layer == enabledLayer) || (layer == RPR_MATERIAL_INPUT_UBER_DIFFUSE_WEIGHT);
+				float weight = (layer == RPR_MATERIAL_INPUT_UBER_TRANSPARENCY) ? (enabled ? 0.5f : 0.0f) : (enabled ? 1.0f : 0.0f);
+
+				shader.xSetParameterF(layer, weight, weight, weight, weight);
+			}
+
+			return shader;
+		};
+
+		for (rpr_material_node_input layer : WARMUP_UBER_LAYERS)
+		{
+			shaders.emplace_back(createUber(layer, false), frw::Shader());
+		}
+
+		shaders.emplace_back(createUber(RPR_MATERIAL_INPUT_UBER_DIFFUSE_WEIGHT, true), frw::Shader());
+
+		if (context.IsVolumeSupported())
+		{
+			frw::Shader surface(materialSystem, frw::ShaderTypeTransparent);
+			frw::Shader volume(materialSystem, frw::ShaderTypeVolume);
+
+			shaders.emplace_back(surface, volume);
+		}
+
+		return shaders;
+	}
+
+	// Renders the swatch scene with every warmup material, so kernels get compiled and written into the shader cache
+	bool WarmupShaderCache(RenderType deviceSettings)
+	{
+		FireRenderContextPtr context = ContextCreator::CreateAppropriateContextForRenderType(deviceSettings);
+
+		try
+		{
+			context->setCallbackCreationDisabled(true);
+			context->SetRenderType(RenderType::Thumbnail);
+			context->initSwatchScene(deviceSettings);
+		}
+		catch (...)
+		{
+			context->cleanScene();
+			return false;
+		}
+
+		bool success = FireRenderThread::RunOnceAndWait<bool>([&context]()
+		{
+			std::vector<std::pair<frw::Shader, frw::Shader>> shaders = CreateWarmupShaders(*context);
+
+			FireRenderMesh* mesh = context->getRenderObject<FireRenderMesh>("mesh");
+			if (!mesh || mesh->Elements().empty() || !mesh->Element(0).shape)
+				return false;
+
+			context->setResolution(WARMUP_RESOLUTION, WARMUP_RESOLUTION, false);
+
+			for (const auto& shader : shaders)
+			{
+				mesh->Element(0).shape.SetShader(shader.first);
+				mesh->Element(0).shape.SetVolumeShader(shader.second);
+
+				context->setStartedRendering();
+				context->setDirty();
+				context->m_restartRender = true;
+				context->UpdateCompletionCriteriaForSwatch(WARMUP_ITERATIONS);
+
+				while (context->keepRenderRunning())
+				{
+					context->render();
+				}
+			}
+
+			return true;
+		});
+
+		context->cleanScene();
+
+		return success;
+	}
+}
+
+void* FireRenderShaderCacheCmd::creator()
+{
+	return new FireRenderShaderCacheCmd;
+}
+
+MSyntax FireRenderShaderCacheCmd::newSyntax()
+{
+	MSyntax syntax;
+
+	CHECK_MSTATUS(syntax.addFlag(kShaderCacheWarmupFlag, kShaderCacheWarmupFlagLong, MSyntax::kNoArg));
+	CHECK_MSTATUS(syntax.addFlag(kShaderCacheCheckFlag, kShaderCacheCheckFlagLong, MSyntax::kNoArg));
+	CHECK_MSTATUS(syntax.addFlag(kShaderCacheForceFlag, kShaderCacheForceFlagLong, MSyntax::kNoArg));
+
+	return syntax;
+}
+
+MStatus FireRenderShaderCacheCmd::doIt(const MArgList& args)
+{
+	MStatus status;
+	MArgDatabase argData(syntax(), args, &status);
+	if (!status)
+		return status;
+
+	// Metal does not cache shaders the way OCL does
+	if (isMetalOn())
+	{
+		setResult(argData.isFlagSet(kShaderCacheCheckFlag) ? 1 : 0);
+		return MS::kSuccess;
+	}
+
+	// final render and viewport/IPR device settings may select different devices
+	std::set<int> createFlagsSet;
+	std::vector<RenderType> deviceSettingsToWarmup;
+
+	for (RenderType deviceSettings : { RenderType::ProductionRender, RenderType::ViewportRender })
+	{
+		int createFlags = FireMaya::Options::GetContextDeviceFlags(deviceSettings);
+
+		// cpu kernels are not stored in the shader cache
+		if ((createFlags & ~RPR_CREATION_FLAGS_ENABLE_CPU) == 0)
+			continue;
+
+		if (createFlagsSet.insert(createFlags).second)
+		{
+			deviceSettingsToWarmup.push_back(deviceSettings);
+		}
+	}
+
+	// kernels compiled by other plug-in, core or driver versions are not reused by the core
+	std::string versionKey = StartupContextChecker::GetVersionKey();
+
+	auto isWarmedUp = [&versionKey](RenderType deviceSettings)
+	{
+		return isShaderCacheWarmedUp(FireMaya::Options::GetContextDeviceFlags(deviceSettings), versionKey);
+	};
+
+	if (argData.isFlagSet(kShaderCacheCheckFlag))
+	{
+		bool valid = true;
+		for (RenderType deviceSettings : deviceSettingsToWarmup)
+		{
+			valid = valid && isWarmedUp(deviceSettings);
+		}
+
+		setResult(valid);
+		return MS::kSuccess;
+	}
+
+	if (!argData.isFlagSet(kShaderCacheWarmupFlag))
+	{
+		MGlobal::displayError("fireRenderShaderCache: either -check or -warmup flag should be set");
+		return MS::kFailure;
+	}
+
+	bool force = argData.isFlagSet(kShaderCacheForceFlag);
+	int warmedUpCount = 0;
+
+	for (RenderType deviceSettings : deviceSettingsToWarmup)
+	{
+		int createFlags = FireMaya::Options::GetContextDeviceFlags(deviceSettings);
+
+		if (!force && isWarmedUp(deviceSettings))
+		{
+			LogPrint("Shader cache is already warmed up for creation flags 0x%x", createFlags);
+			continue;
+		}
+
+		TimePoint startTime = GetCurrentChronoTime();
+
+		if (!WarmupShaderCache(deviceSettings))
+		{
+			MGlobal::displayError(MString("fireRenderShaderCache: unable to compile kernels for creation flags ") + createFlags);
+			return MS::kFailure;
+		}
+
+		markShaderCacheWarmedUp(createFlags, versionKey);
+		++warmedUpCount;
+
+		LogPrint("Shader cache warmed up for creation flags 0x%x in %ld ms", createFlags,
+			TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), startTime));
+	}
+
+	MGlobal::displayInfo(MString("Radeon ProRender shader cache: ") + getShaderCachePath());
+	setResult(warmedUpCount);
+
+	return MS::kSuccess;
+}
@@ -0,0 +1,39 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#pragma once
+
+#include <maya/MPxCommand.h>
+#include <maya/MSyntax.h>
+#include <maya/MArgDatabase.h>
+
+#define kShaderCacheWarmupFlag "-w"
+#define kShaderCacheWarmupFlagLong "-warmup"
+#define kShaderCacheCheckFlag "-c"
+#define kShaderCacheCheckFlagLong "-check"
+#define kShaderCacheForceFlag "-f"
+#define kShaderCacheForceFlagLong "-force"
+
+/**
+ * Compiles render kernels into the shader cache ahead of the first render
+ * and checks whether the cache is populated for the selected devices.
+ * Intended to be run on render nodes during provisioning, for example:
+ * mayabatch -command "loadPlugin RadeonProRender; fireRenderShaderCache -warmup"
+ */
+class FireRenderShaderCacheCmd : public MPxCommand
+{
+public:
+	MStatus doIt(const MArgList& args) override;
+
+	static void* creator();
+	static MSyntax newSyntax();
+};
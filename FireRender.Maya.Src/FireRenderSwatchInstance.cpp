@@ -12,30 +12,64 @@ limitations under the License.
 ********************************************************************/
 #include "FireRenderMaterialSwatchRender.h"
 #include "FireRenderSwatchInstance.h"
+#include "BakedTextureCache.h"
+#include "OptionVarHelpers.h"
 
 #include "AutoLock.h"
+#include "Logger.h"
 #include "FireRenderThread.h"
 
+#include <maya/MGlobal.h>
+
+#include <algorithm>
+#include <cmath>
+
 FireRenderSwatchInstance FireRenderSwatchInstance::m_instance;
 
 using namespace FireMaya;
 
+namespace
+{
+	const size_t DefaultSwatchContextCount = 2;
+	const size_t MaxSwatchContextCount = 8;
+}
+
 FireRenderSwatchInstance::FireRenderSwatchInstance()
 {
 	sceneIsCleaned = true;
+	m_maxContextCount = DefaultSwatchContextCount;
+	m_cancelRefinements = false;
 }
 
 void FireRenderSwatchInstance::initScene()
 {
+	m_warningDialogOpen = false;
+	m_cancelRefinements = false;
+
+	int contextCount = getOptionVarIntValue("RPR_SwatchContextCount");
+	m_maxContextCount = contextCount > 0 ? std::min((size_t) contextCount, MaxSwatchContextCount) : DefaultSwatchContextCount;
+
+	// contexts are accessed by index from worker threads, so the storage must not be reallocated
+	m_contexts.reserve(m_maxContextCount);
+
+	addContext();
+
+	sceneIsCleaned = false;
+}
+
+void FireRenderSwatchInstance::addContext()
+{
+	std::unique_ptr<SwatchContext> swatchContext = std::make_unique<SwatchContext>();
+	swatchContext->context = std::make_unique<TahoeContext>();
+
+	TahoeContext& context = *swatchContext->context;
+
 #ifdef _WIN32
 	// force using NorthStar for swatches
 	context.SetPluginEngine(TahoePluginVersion::RPR2);
 #endif
 
-	backgroundRendererBusy = false;
-	m_warningDialogOpen = false;
-
-	if (getContext().isFirstIterationAndShadersNOTCached())
+	if (m_contexts.empty() && context.isFirstIterationAndShadersNOTCached())
 	{
 		//first iteration and shaders are _NOT_ cached
 		rcWarningDialog.show();
@@ -46,7 +80,15 @@ void FireRenderSwatchInstance::initScene()
 	context.SetRenderType(RenderType::Thumbnail);
 	context.initSwatchScene();
 	context.Freshen();
-	sceneIsCleaned = false;
+
+	size_t contextIndex = 0;
+	{
+		RPR::AutoLock<MSpinLock> lock(mutex);
+		m_contexts.push_back(std::move(swatchContext));
+		contextIndex = m_contexts.size() - 1;
+	}
+
+	ProcessInRenderThread(contextIndex);
 }
 
 FireRenderSwatchInstance::~FireRenderSwatchInstance()
@@ -76,75 +118,241 @@ void FireRenderSwatchInstance::cleanScene()
 {
 	if (!sceneIsCleaned)
 	{
-		context.cleanScene();
+		m_cancelRefinements = true;
+
+		for (auto& swatchContext : m_contexts)
+		{
+			{
+				RPR::AutoLock<MSpinLock> lock(mutex);
+				swatchContext->refinementQueue.clear();
+				swatchContext->stopWorker = true;
+			}
+
+			swatchContext->workAvailable.notify_all();
+
+			if (swatchContext->worker.joinable())
+			{
+				swatchContext->worker.join();
+			}
+
+			swatchContext->context->cleanScene();
+		}
+
+		m_contexts.clear();
 		sceneIsCleaned = true;
 	}
 }
 
-void FireRenderSwatchInstance::ProcessInRenderThread()
+size_t FireRenderSwatchInstance::acquireContext()
 {
-	backgroundRendererBusy = true;
+	size_t bestIndex = 0;
+	size_t bestLoad = SIZE_MAX;
 
-	FireRenderThread::KeepRunning([this]() -> bool
 	{
-		try
-		{
-			FireRenderMaterialSwatchRender* item = nullptr;
+		RPR::AutoLock<MSpinLock> lock(mutex);
 
-			while ((item = dequeSwatch()) != nullptr)
+		for (size_t i = 0; i < m_contexts.size(); i++)
+		{
+			size_t load = m_contexts[i]->queueToProcess.size() + (m_contexts[i]->busy ? 1 : 0);
+			if (load < bestLoad)
 			{
-				item->processFromBackgroundThread();
+				bestIndex = i;
+				bestLoad = load;
 			}
 		}
-		catch (...)
-		{
-		}
+	}
 
-		backgroundRendererBusy = false;
+	// all contexts are busy => start one more
+	if (bestLoad > 0 && m_contexts.size() < m_maxContextCount)
+	{
+		addContext();
+		return m_contexts.size() - 1;
+	}
+
+	return bestIndex;
+}
 
-		if (m_warningDialogOpen &&  rcWarningDialog.shown)
+void FireRenderSwatchInstance::ProcessInRenderThread(size_t contextIndex)
+{
+	SwatchContext& swatchContext = *m_contexts[contextIndex];
+
+	swatchContext.worker = std::thread([this, contextIndex, &swatchContext]()
+	{
+		while (true)
 		{
-			FireRenderThread::RunProcOnMainThread([this]
+			FireRenderMaterialSwatchRender* item = nullptr;
+			SwatchRefinement refinement;
+
 			{
-				rcWarningDialog.close();
-			});
-		}
+				std::unique_lock<MSpinLock> lock(mutex);
 
-		return false;
+				swatchContext.busy = false;
+				swatchContext.workAvailable.wait(lock, [&swatchContext]()
+				{
+					return swatchContext.stopWorker || !swatchContext.queueToProcess.empty() || !swatchContext.refinementQueue.empty();
+				});
+
+				// full quality renders go after all the previews; queued previews are finished even if the worker is stopped
+				if (!swatchContext.queueToProcess.empty())
+				{
+					item = swatchContext.queueToProcess.front();
+					swatchContext.queueToProcess.pop_front();
+
+					item->setAsyncRunning(true);
+				}
+				else if (swatchContext.stopWorker)
+				{
+					break;
+				}
+				else
+				{
+					refinement = swatchContext.refinementQueue.front();
+					swatchContext.refinementQueue.pop_front();
+				}
+
+				swatchContext.busy = true;
+			}
+
+			try
+			{
+				if (item)
+				{
+					item->processFromBackgroundThread();
+				}
+				else
+				{
+					processRefinement(contextIndex, refinement);
+				}
+			}
+			catch (...)
+			{
+				// only the failed item is dropped, the rest of the queue is processed
+				DebugPrint("Unknown error processing swatch queue");
+			}
+
+			bool queueDrained = false;
+			{
+				RPR::AutoLock<MSpinLock> lock(mutex);
+				queueDrained = swatchContext.queueToProcess.empty() && swatchContext.refinementQueue.empty();
+			}
+
+			if (queueDrained && m_warningDialogOpen && rcWarningDialog.shown)
+			{
+				FireRenderThread::KeepRunningOnMainThread([this]() -> bool
+				{
+					rcWarningDialog.close();
+					return false;
+				});
+			}
+		}
 	});
 }
 
 void FireRenderSwatchInstance::enqueSwatch(FireRenderMaterialSwatchRender* swatch)
 {
+	size_t contextIndex = swatch->getContextIndex();
+
+	// new request resumes refinements cancelled before
+	m_cancelRefinements = false;
+
 	{
 		RPR::AutoLock<MSpinLock> lock(mutex);
-		queueToProcess.push_back(swatch);
+		m_contexts[contextIndex]->queueToProcess.push_back(swatch);
 	}
 
-	if (!backgroundRendererBusy)
+	// worker of the context is woken up, it is never joined on the main thread while it is running
+	m_contexts[contextIndex]->workAvailable.notify_one();
+}
+
+void FireRenderSwatchInstance::removeFromQueue(FireRenderMaterialSwatchRender* swatch)
+{
+	RPR::AutoLock<MSpinLock> lock(mutex);
+
+	for (auto& swatchContext : m_contexts)
 	{
-		ProcessInRenderThread();
+		swatchContext->queueToProcess.remove(swatch);
 	}
 }
 
-FireRenderMaterialSwatchRender* FireRenderSwatchInstance::dequeSwatch()
+void FireRenderSwatchInstance::enqueRefinement(size_t contextIndex, const SwatchRefinement& refinement)
 {
-	RPR::AutoLock<MSpinLock> lock(mutex);
+	{
+		RPR::AutoLock<MSpinLock> lock(mutex);
+
+		// called from the worker of the context, so it will pick the refinement up
+		m_contexts[contextIndex]->refinementQueue.push_back(refinement);
+	}
+
+	m_contexts[contextIndex]->workAvailable.notify_one();
+}
 
-	if (queueToProcess.size() == 0)
+bool FireRenderSwatchInstance::renderSwatch(size_t contextIndex, frw::Shader shader, frw::Shader volumeShader, int resolution, int iterations,
+	const std::atomic<bool>& cancel, std::vector<float>& outPixels)
+{
+	FireRenderContext& context = getContext(contextIndex);
+
+	context.setStartedRendering();
+	// consider using a different mesh depending on surface or value type
+	if (auto mesh = context.getRenderObject<FireRenderMesh>("mesh"))
+	{
+		if (mesh->Elements().size())
+		{
+			if (auto shape = mesh->Element(0).shape)
+			{
+				shape.SetShader(shader);
+				shape.SetVolumeShader(volumeShader);
+			}
+		}
+	}
+
+	if ((context.width() != (unsigned int) resolution) ||
+		(context.height() != (unsigned int) resolution))
 	{
-		return nullptr;
+		context.setResolution(resolution, resolution, false);
+	}
+
+	context.setDirty();
+	context.m_restartRender = true;
+	context.UpdateCompletionCriteriaForSwatch(iterations);
+
+	while (context.keepRenderRunning())
+	{
+		if (cancel)
+			return false;
+
+		context.render();
 	}
 
-	FireRenderMaterialSwatchRender* item = queueToProcess.front();
-	queueToProcess.pop_front();
+	outPixels = context.getRenderImageData();
 
-	item->setAsyncRunning(true);
-	return item;
+	return true;
 }
 
-void FireRenderSwatchInstance::removeFromQueue(FireRenderMaterialSwatchRender* swatch)
+void FireRenderSwatchInstance::processRefinement(size_t contextIndex, const SwatchRefinement& refinement)
 {
-	RPR::AutoLock<MSpinLock> lock(mutex);
-	queueToProcess.remove(swatch);
+	std::vector<float> pixels;
+	if (!renderSwatch(contextIndex, refinement.shader, refinement.volumeShader, refinement.resolution, refinement.iterations, m_cancelRefinements, pixels))
+		return;
+
+	// plain conversion to 8 bit RGBA, Maya images must not be created outside of the main thread
+	std::vector<unsigned char> swatchPixels(pixels.size());
+	for (size_t i = 0; i < pixels.size(); i++)
+	{
+		swatchPixels[i] = (unsigned char) std::lround(std::min(std::max(pixels[i], 0.0f), 1.0f) * 255.0f);
+	}
+
+	BakedTextureCache::GetSwatchInstance().Store(refinement.nodeId, refinement.cacheKey, refinement.resolution, refinement.resolution,
+		refinement.networkHash, swatchPixels);
+
+	// swatch is requested again and picked up from the cache
+	MObjectHandle node = refinement.node;
+	FireRenderThread::KeepRunningOnMainThread([node]() -> bool
+	{
+		if (node.isValid())
+		{
+			MGlobal::executeCommand("swatchRefresh " + MFnDependencyNode(node.object()).name());
+		}
+
+		return false;
+	});
 }
@@ -13,12 +13,34 @@ limitations under the License.
 #pragma once
 
 #include <maya/MSpinLock.h>
+#include <maya/MObjectHandle.h>
 
 #include "RenderCacheWarningDialog.h"
 #include "Context/TahoeContext.h"
 
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <thread>
+#include <vector>
+
 class FireRenderMaterialSwatchRender;
 
+// Full quality render of a swatch which has got a low sample preview already
+struct SwatchRefinement
+{
+	MObjectHandle node;
+	MString nodeId;
+	MString cacheKey;
+	uint64_t networkHash;
+
+	frw::Shader shader;
+	frw::Shader volumeShader;
+
+	int resolution;
+	int iterations;
+};
+
 class FireRenderSwatchInstance
 {
 public:
@@ -26,20 +48,44 @@ public:
 	static bool IsCleaned();
 	void cleanScene();
 
+	// Returns index of the context which should parse and render next swatch
+	size_t acquireContext();
+
 	void enqueSwatch(FireRenderMaterialSwatchRender* swatch);
-	FireRenderMaterialSwatchRender* dequeSwatch();
 	void removeFromQueue(FireRenderMaterialSwatchRender* swatch);
 
-	FireRenderContext& getContext() { return context; }
+	void enqueRefinement(size_t contextIndex, const SwatchRefinement& refinement);
+
+	FireRenderContext& getContext(size_t contextIndex = 0) { return *m_contexts[contextIndex]->context; }
+
+	// Renders swatch sphere with the shaders, returns false if rendering was cancelled
+	bool renderSwatch(size_t contextIndex, frw::Shader shader, frw::Shader volumeShader, int resolution, int iterations,
+		const std::atomic<bool>& cancel, std::vector<float>& outPixels);
 
 private:
+	struct SwatchContext
+	{
+		std::unique_ptr<TahoeContext> context;
+		std::list<FireRenderMaterialSwatchRender*> queueToProcess;
+		std::list<SwatchRefinement> refinementQueue;
+
+		bool busy = false;
+		bool stopWorker = false;
+
+		// worker thread lives as long as the context and sleeps while the queues are empty
+		std::condition_variable_any workAvailable;
+		std::thread worker;
+	};
+
 	FireRenderSwatchInstance();
 
 	void initScene();
+	void addContext();
 
 	~FireRenderSwatchInstance();
 
-	void ProcessInRenderThread();
+	void ProcessInRenderThread(size_t contextIndex);
+	void processRefinement(size_t contextIndex, const SwatchRefinement& refinement);
 
 	FireRenderSwatchInstance(const FireRenderSwatchInstance&);
 
@@ -49,14 +95,14 @@ private:
 	bool sceneIsCleaned;
 	MSpinLock mutex;
 
-	TahoeContext context;
-	std::atomic<bool> backgroundRendererBusy;
+	// swatches are rendered concurrently, each context has its own queue and worker thread
+	std::vector<std::unique_ptr<SwatchContext>> m_contexts;
+	size_t m_maxContextCount;
 
-	std::list<FireRenderMaterialSwatchRender*> queueToProcess;
+	std::atomic<bool> m_cancelRefinements;
 
 	RenderCacheWarningDialog rcWarningDialog;
 	bool m_warningDialogOpen;
 
 	static FireRenderSwatchInstance m_instance;
 };
-
@@ -34,6 +34,8 @@ limitations under the License.
 #include <vector>
 #include <time.h>
 #include <iostream>
+#include <filesystem>
+#include <fstream>
 
 #include "attributeNames.h"
 #include "OptionVarHelpers.h"
@@ -72,6 +74,8 @@ FireRenderGlobalsData::FireRenderGlobalsData() :
 	adaptiveThreshold(0.0f),
 	adaptiveThresholdViewport(0.0f),
 	textureCompression(false),
+	deduplicateGeometry(false),
+	deduplicateShaders(false),
 	giClampIrradiance(true),
 	giClampIrradianceValue(1.0),
 	samplesPerUpdate(5),
@@ -106,6 +110,10 @@ FireRenderGlobalsData::FireRenderGlobalsData() :
 	cameraMotionBlur(false),
 	motionBlurCameraExposure(0.0f),
 	motionSamples(0),
+	hairLOD(false),
+	hairLODQuality(1.0f),
+	lightCulling(false),
+	lightCullingThreshold(0.001f),
 	tileRenderingEnabled(false),
 	tileSizeX(0),
 	tileSizeY(0),
@@ -171,6 +179,10 @@ void FireRenderGlobalsData::readFromCurrentScene()
 		if (!plug.isNull())
 			completionCriteriaFinalRender.completionCriteriaMinIterations = plug.asInt();
 
+		plug = frGlobalsNode.findPlug("completionCriteriaNoiseThreshold");
+		if (!plug.isNull())
+			completionCriteriaFinalRender.completionCriteriaNoiseThreshold = plug.asFloat();
+
 
 		/*plug = frGlobalsNode.findPlug("completionCriteriaTypeViewport");
 		if (!plug.isNull())
@@ -213,6 +225,14 @@ void FireRenderGlobalsData::readFromCurrentScene()
 		if (!plug.isNull())
 			textureCompression = plug.asBool();
 
+		plug = frGlobalsNode.findPlug("deduplicateGeometry");
+		if (!plug.isNull())
+			deduplicateGeometry = plug.asBool();
+
+		plug = frGlobalsNode.findPlug("deduplicateShaders");
+		if (!plug.isNull())
+			deduplicateShaders = plug.asBool();
+
 		plug = frGlobalsNode.findPlug("renderModeViewport");
 		if (!plug.isNull())
 			viewportRenderMode = plug.asInt();
@@ -415,6 +435,22 @@ void FireRenderGlobalsData::readFromCurrentScene()
 		if (!plug.isNull())
 			motionSamples = plug.asInt();	
 
+		plug = frGlobalsNode.findPlug("hairLOD");
+		if (!plug.isNull())
+			hairLOD = plug.asBool();
+
+		plug = frGlobalsNode.findPlug("hairLODQuality");
+		if (!plug.isNull())
+			hairLODQuality = plug.asFloat();
+
+		plug = frGlobalsNode.findPlug("lightCulling");
+		if (!plug.isNull())
+			lightCulling = plug.asBool();
+
+		plug = frGlobalsNode.findPlug("lightCullingThreshold");
+		if (!plug.isNull())
+			lightCullingThreshold = plug.asFloat();
+
 		plug = frGlobalsNode.findPlug("cameraType");
 		if (!plug.isNull())
 			cameraType = plug.asShort();
@@ -642,6 +678,38 @@ bool FireRenderGlobalsData::IsMotionBlur(MString name)
 	return propNames.find(name.asChar()) != propNames.end();
 }
 
+bool FireRenderGlobalsData::IsHairLOD(MString name)
+{
+	name = GetPropertyNameFromPlugName(name);
+
+	static const std::set<std::string> propNames{ "hairLOD", "hairLODQuality" };
+
+	return propNames.find(name.asChar()) != propNames.end();
+}
+
+bool FireRenderGlobalsData::IsLightCulling(MString name)
+{
+	name = GetPropertyNameFromPlugName(name);
+
+	static const std::set<std::string> propNames{ "lightCulling", "lightCullingThreshold" };
+
+	return propNames.find(name.asChar()) != propNames.end();
+}
+
+bool FireRenderGlobalsData::IsDeduplicateGeometry(MString name)
+{
+	name = GetPropertyNameFromPlugName(name);
+
+	return name == "deduplicateGeometry";
+}
+
+bool FireRenderGlobalsData::IsDeduplicateShaders(MString name)
+{
+	name = GetPropertyNameFromPlugName(name);
+
+	return name == "deduplicateShaders";
+}
+
 void FireRenderGlobalsData::getCPUThreadSetup(bool& overriden, int& cpuThreadCount, RenderType renderType)
 {
 	// Apply defaults in case if global node isn't created yet
@@ -1147,35 +1215,152 @@ MString getShaderCachePath()
 			return cacheFolder.c_str();
 		}
 	}
-	return MGlobal::executeCommandStringResult("getenv FR_SHADER_CACHE_PATH");
+	const char* envPath = std::getenv("FR_SHADER_CACHE_PATH");
+	return envPath ? envPath : "";
 #elif defined(OSMac_)
 	return "/Users/Shared/RadeonProRender/cache"_ms;
 #else
-	return MGlobal::executeCommandStringResult("getenv FR_SHADER_CACHE_PATH");
+	const char* envPath = std::getenv("FR_SHADER_CACHE_PATH");
+	return envPath ? envPath : "";
 #endif
 }
 
-std::string replaceStrChar(std::string str, const std::string& replace, char ch) {
+MString getBakedTextureCachePath()
+{
+	MString envPath = MGlobal::executeCommandStringResult("getenv RPR_BAKED_TEXTURE_CACHE_PATH");
+	if (envPath.length() > 0)
+	{
+		return envPath;
+	}
 
-	// set our locator equal to the first appearance of any character in replace
-	size_t found = str.find_first_of(replace);
+#ifdef WIN32
+	PWSTR sz = nullptr;
+	if (S_OK == ::SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &sz))
+	{
+		std::wstring cacheFolder(sz);
+		cacheFolder += L"\\RadeonProRender\\Maya\\BakedTextures";
+		switch (SHCreateDirectoryExW(nullptr, cacheFolder.c_str(), nullptr))
+		{
+		case ERROR_SUCCESS:
+		case ERROR_FILE_EXISTS:
+		case ERROR_ALREADY_EXISTS:
+			cacheFolder += L"\\";
+			return cacheFolder.c_str();
+		}
+	}
+	return "";
+#elif defined(OSMac_)
+	return "/Users/Shared/RadeonProRender/cache/BakedTextures/"_ms;
+#else
+	const char* homePath = std::getenv("HOME");
+	return homePath ? MString(homePath) + "/.RadeonProRender/Maya/BakedTextures/" : "";
+#endif
+}
 
-	while (found != std::string::npos) { // While our position in the sting is in range.
-		str[found] = ch; // Change the character at position.
-		found = str.find_first_of(replace, found + 1); // Relocate again.
+MString getTelemetrySpoolPath()
+{
+	const char* envPath = std::getenv("RPR_MAYA_TELEMETRY_SPOOL_PATH");
+	if (envPath != nullptr && envPath[0] != '\0')
+	{
+		return envPath;
 	}
 
-	return str; // return our new string.
+#ifdef WIN32
+	PWSTR sz = nullptr;
+	if (S_OK == ::SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &sz))
+	{
+		std::wstring spoolFolder(sz);
+		spoolFolder += L"\\RadeonProRender\\Maya\\Telemetry";
+		switch (SHCreateDirectoryExW(nullptr, spoolFolder.c_str(), nullptr))
+		{
+		case ERROR_SUCCESS:
+		case ERROR_FILE_EXISTS:
+		case ERROR_ALREADY_EXISTS:
+			spoolFolder += L"\\";
+			return spoolFolder.c_str();
+		}
+	}
+	return "";
+#elif defined(OSMac_)
+	return "/Users/Shared/RadeonProRender/telemetry/"_ms;
+#else
+	const char* homePath = std::getenv("HOME");
+	return homePath ? MString(homePath) + "/.RadeonProRender/Maya/Telemetry/" : "";
+#endif
 }
 
 int areShadersCached() 
 {
-	std::string temp = getShaderCachePath().asChar();
-	temp = replaceStrChar(temp, "\\", '/');
-	MString test = "source common.mel; getNumberOfCachedShaders(\"" + MString(temp.c_str()) + "\");";
-	int result = 0;
-	MGlobal::executeCommand(test, result);
-	return result != 0;
+	MString cachePath = getShaderCachePath();
+	if (cachePath.length() == 0)
+		return false;
+
+	std::error_code error;
+	for (std::filesystem::directory_iterator it(cachePath.asUTF8(), error), end; !error && it != end; it.increment(error))
+	{
+		if (it->path().extension() == ".bin")
+			return true;
+	}
+
+	return false;
+}
+
+namespace
+{
+	const char* SHADER_CACHE_WARMUP_STAMP = "warmup.stamp";
+
+	std::string getShaderCacheStampPath()
+	{
+		MString cachePath = getShaderCachePath();
+		if (cachePath.length() == 0)
+			return std::string();
+
+		return (std::filesystem::u8path(cachePath.asUTF8()) / SHADER_CACHE_WARMUP_STAMP).string();
+	}
+
+	// one line per warmup: creation flags followed by the version key
+	std::string getShaderCacheStampLine(int createFlags, const std::string& versionKey)
+	{
+		std::string line = std::to_string(createFlags) + "\t" + versionKey;
+
+		// key is written on a single line
+		std::replace(line.begin(), line.end(), '\n', ' ');
+
+		return line;
+	}
+}
+
+bool isShaderCacheWarmedUp(int createFlags, const std::string& versionKey)
+{
+	if (!areShadersCached())
+		return false;
+
+	std::ifstream stamp(getShaderCacheStampPath());
+	if (!stamp)
+		return false;
+
+	std::string expectedLine = getShaderCacheStampLine(createFlags, versionKey);
+
+	std::string line;
+	while (std::getline(stamp, line))
+	{
+		if (line == expectedLine)
+			return true;
+	}
+
+	return false;
+}
+
+void markShaderCacheWarmedUp(int createFlags, const std::string& versionKey)
+{
+	if (isShaderCacheWarmedUp(createFlags, versionKey))
+		return;
+
+	std::ofstream stamp(getShaderCacheStampPath(), std::ios::app);
+	if (stamp)
+	{
+		stamp << getShaderCacheStampLine(createFlags, versionKey) << std::endl;
+	}
 }
 
 MString getLogFolder()
@@ -92,6 +92,7 @@ struct CompletionCriteriaParams
 
 		completionCriteriaMaxIterations = 0;
 		completionCriteriaMinIterations = 1; // should not be zero
+		completionCriteriaNoiseThreshold = 0.0f;
 	}
 
 	int getTotalSecondsCount()
@@ -121,6 +122,11 @@ struct CompletionCriteriaParams
 		return isUnlimitedTime() && isUnlimitedIterations();
 	}
 
+	bool hasNoiseThreshold() const
+	{
+		return completionCriteriaNoiseThreshold > 0.0f;
+	}
+
 	//short completionCriteriaType;
 	int completionCriteriaHours;
 	int completionCriteriaMinutes;
@@ -128,6 +134,9 @@ struct CompletionCriteriaParams
 
 	int completionCriteriaMaxIterations;
 	int completionCriteriaMinIterations;
+
+	// max relative noise per tile, 0 - disabled
+	float completionCriteriaNoiseThreshold;
 };
 
 enum class RenderType
@@ -181,6 +190,13 @@ public:
 
 	static bool IsMotionBlur(MString name);
 
+	static bool IsHairLOD(MString name);
+	static bool IsLightCulling(MString name);
+
+	static bool IsDeduplicateGeometry(MString name);
+
+	static bool IsDeduplicateShaders(MString name);
+
 	static void getCPUThreadSetup(bool& overriden, int& cpuThreadCount, RenderType renderType);
 	static int getThumbnailIterCount(bool* pSwatchesEnabled = nullptr);
 	static bool isExrMultichannelEnabled(void);
@@ -197,6 +213,12 @@ public:
 
 	bool textureCompression;
 
+	// Identical meshes are translated once and instanced
+	bool deduplicateGeometry;
+
+	// Structurally identical shading networks share one shader
+	bool deduplicateShaders;
+
 	int viewportRenderMode;
 	int renderMode;
 
@@ -290,6 +312,15 @@ public:
 	float motionBlurCameraExposure;
 	unsigned int motionSamples;
 
+	// Hair level of detail
+	bool hairLOD;
+	float hairLODQuality;
+
+	// Light culling: lights contributing less than the threshold
+	// (relative to the strongest light) are left out of the scene
+	bool lightCulling;
+	float lightCullingThreshold;
+
 	// Contour
 	bool contourIsEnabled;
 	bool contourUseObjectID;
@@ -383,9 +414,22 @@ MDagPath getSkyObject(MStatus& status);
 // Get shader cache path
 MString getShaderCachePath();
 
+// Get folder for baked procedural textures (empty if there is no such folder)
+MString getBakedTextureCachePath();
+
+// Get folder where telemetry records wait to be sent (empty if there is no such folder)
+MString getTelemetrySpoolPath();
+
 //Get if shaders have been cached (Shader System)
 int areShadersCached();
 
+// Get if kernels for the given context creation flags were compiled ahead of time by fireRenderShaderCache -warmup
+// with the same plug-in, core and driver versions (described by versionKey)
+bool isShaderCacheWarmedUp(int createFlags, const std::string& versionKey);
+
+// Record that kernels for the given context creation flags and versions are in the shader cache
+void markShaderCacheWarmedUp(int createFlags, const std::string& versionKey);
+
 // Get the log folder.
 MString getLogFolder();
 
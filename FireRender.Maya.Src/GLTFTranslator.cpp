@@ -133,6 +133,15 @@ MStatus	GLTFTranslator::writer(const MFileObject& file,
 
 	try
 	{
+		OptionMap optionMap;
+		ParseOptionStringValues(optionMap, optionsString);
+
+		OptionMap::const_iterator toleranceIt = optionMap.find("AnimationKeyTolerance");
+		if (toleranceIt != optionMap.end())
+		{
+			animationExporter.SetKeyReductionTolerance(MString(toleranceIt->second.c_str()).asFloat());
+		}
+
 		m_progressBars->SetTextAboveProgress("Preparing Animation...", true);
 
 		animationExporter.Export(*fireRenderContext, &renderableCameras, rprsContext);
@@ -140,9 +149,6 @@ MStatus	GLTFTranslator::writer(const MFileObject& file,
 		std::vector<rpr_scene> scenes;
 		scenes.push_back(scene.Handle());
 
-		OptionMap optionMap;
-		ParseOptionStringValues(optionMap, optionsString);
-
 		unsigned int gltfFlags = RPRGLTF_EXPORTFLAG_COPY_IMAGES_USING_OBJECTNAME | RPRGLTF_EXPORTFLAG_KHR_LIGHT;
 
 		OptionMap::const_iterator it = optionMap.find("BuildPbrImages");
@@ -12,16 +12,28 @@ limitations under the License.
 ********************************************************************/
 #include <InstancerMASH.h>
 #include <FireRenderMeshMASH.h>
+#include "Context/TahoeContext.h"
 #include <maya/MItDag.h>
-#include <maya/MEulerRotation.h>
+#include <maya/MAnimControl.h>
+#include <maya/MDGContext.h>
+#include <maya/MFnMatrixData.h>
+#include <algorithm>
+#include <cmath>
 
 InstancerMASH::InstancerMASH(FireRenderContext* context, const MDagPath& dagPath) :
 	FireRenderNode(context, dagPath),
-	m_instancedObjectsCachedSize(0)
+	m_instancedObjectsCachedSize(0),
+	m_fullUpdateRequired(true),
+	m_instancerVisible(false)
 {
 	GenerateInstances();
 }
 
+InstancerMASH::~InstancerMASH()
+{
+	ClearInstances();
+}
+
 void InstancerMASH::RegisterCallbacks()
 {
 	FireRenderNode::RegisterCallbacks();
@@ -30,21 +42,51 @@ void InstancerMASH::RegisterCallbacks()
 		return;
 
 	AddCallback(MNodeMessage::addNodeDirtyPlugCallback(m.object, plugDirty_callback, this));
+
+	// prototypes aren't scene objects of their own, so edits of their shapes are tracked by the instancer
+	for (const PrototypeInstances& prototypeInstances : m_prototypes)
+	{
+		MObject prototypeShape = prototypeInstances.prototype->Object();
+		if (!prototypeShape.isNull())
+		{
+			AddCallback(MNodeMessage::addNodeDirtyPlugCallback(prototypeShape, plugDirty_callback, this));
+		}
+	}
+
+	// visibility of the instancer transform and its parents hides all instances
+	MDagPath parentPath = DagPath();
+	while (parentPath.pop() == MStatus::kSuccess && parentPath.length() > 0)
+	{
+		AddCallback(MNodeMessage::addNodeDirtyPlugCallback(parentPath.node(), plugDirty_callback, this));
+	}
 }
 
 void InstancerMASH::OnPlugDirty(MObject& node, MPlug& plug)
 {
-	(void) node;
-	(void) plug;
-
-	if (ShouldBeRecreated())
+	if (node != m.object)
 	{
-		for (auto o : m_instancedObjects)
+		// prototype shape is edited, it is translated again and all its instances are recreated
+		for (PrototypeInstances& prototypeInstances : m_prototypes)
 		{
-			for (auto it = o.second.begin(); it != o.second.end(); ++it)
-				(*it)->setVisibility(false);
+			if (prototypeInstances.prototype->Object() == node)
+			{
+				prototypeInstances.prototype->MarkMeshChanged();
+				m_fullUpdateRequired = true;
+			}
 		}
-		m_instancedObjects.clear();
+
+		// otherwise a parent transform is changed, its visibility is checked in Freshen
+	}
+	// Changes of MASH points data are caught by comparing instance transforms, anything else updates all instances
+	else if (plug.attribute() != MFnDependencyNode(m.object).attribute("inp"))
+	{
+		m_fullUpdateRequired = true;
+	}
+
+	if (ShouldBeRecreated())
+	{
+		ClearInstances();
+		m_fullUpdateRequired = true;
 	}
 	setDirty();
 }
@@ -115,40 +157,260 @@ std::vector<MObject> GetShapesFromNode(MObject node)
 	return out;
 }
 
-std::vector<MMatrix> InstancerMASH::GetTransformMatrices() const
+// Builds scale * rotation * translation matrices from MASH points data in one pass.
+// Gives the same result as MTransformationMatrix with XYZ rotation order and no pivots or shear, rotation is in degrees
+void BuildMASHTransforms(const double (*positions)[3], const double (*rotations)[3], const double (*scales)[3], MMatrix* out, int count)
 {
-	std::vector<MMatrix> result;
-	result.reserve(GetInstanceCount());
+	const double degToRad = M_PI / 180.0;
+
+#pragma omp parallel for
+	for (int i = 0; i < count; ++i)
+	{
+		const double rx = rotations[i][0] * degToRad;
+		const double ry = rotations[i][1] * degToRad;
+		const double rz = rotations[i][2] * degToRad;
+
+		const double sx = std::sin(rx);
+		const double cx = std::cos(rx);
+		const double sy = std::sin(ry);
+		const double cy = std::cos(ry);
+		const double sz = std::sin(rz);
+		const double cz = std::cos(rz);
+
+		double (*m)[4] = out[i].matrix;
+
+		m[0][0] = scales[i][0] * (cy * cz);
+		m[0][1] = scales[i][0] * (cy * sz);
+		m[0][2] = scales[i][0] * (-sy);
+		m[0][3] = 0.0;
+
+		m[1][0] = scales[i][1] * (sx * sy * cz - cx * sz);
+		m[1][1] = scales[i][1] * (sx * sy * sz + cx * cz);
+		m[1][2] = scales[i][1] * (sx * cy);
+		m[1][3] = 0.0;
+
+		m[2][0] = scales[i][2] * (cx * sy * cz + sx * sz);
+		m[2][1] = scales[i][2] * (cx * sy * sz - sx * cz);
+		m[2][2] = scales[i][2] * (cx * cy);
+		m[2][3] = 0.0;
+
+		m[3][0] = positions[i][0];
+		m[3][1] = positions[i][1];
+		m[3][2] = positions[i][2];
+		m[3][3] = 1.0;
+	}
+}
 
+std::vector<MMatrix> InstancerMASH::GetTransformMatrices(const MTime* time) const
+{
 	MFnDependencyNode instancerDagNode(m.object);
 	MPlug plug(m.object, instancerDagNode.attribute("inp"));
-	MObject data = plug.asMDataHandle().data();
+
+	// points data at other time is evaluated without changing scene time
+	MObject data;
+	if (time != nullptr)
+	{
+		plug.getValue(data, MDGContext(*time));
+	}
+	else
+	{
+		data = plug.asMDataHandle().data();
+	}
+
 	MFnArrayAttrsData arrayAttrsData(data);
 
 	MVectorArray positionData = arrayAttrsData.getVectorData("position");
 	MVectorArray rotationData = arrayAttrsData.getVectorData("rotation");
 	MVectorArray scaleData = arrayAttrsData.getVectorData("scale");
 
-	for (unsigned int i = 0; i < static_cast<unsigned int>(GetInstanceCount()); i++)
-	{
-		MVector position = positionData[i];
-		MVector rotation = rotationData[i];
-		MVector scale = scaleData[i];
+	unsigned int count = static_cast<unsigned int>(GetInstanceCount());
+	count = std::min(count, positionData.length());
+	count = std::min(count, rotationData.length());
+	count = std::min(count, scaleData.length());
+
+	std::vector<MMatrix> result(count);
+	if (count == 0)
+		return result;
+
+	// Read points data into flat arrays once instead of accessing MVectorArray per element
+	std::vector<double> positions(count * 3);
+	std::vector<double> rotations(count * 3);
+	std::vector<double> scales(count * 3);
+
+	positionData.setLength(count);
+	rotationData.setLength(count);
+	scaleData.setLength(count);
+
+	positionData.get(reinterpret_cast<double(*)[3]>(positions.data()));
+	rotationData.get(reinterpret_cast<double(*)[3]>(rotations.data()));
+	scaleData.get(reinterpret_cast<double(*)[3]>(scales.data()));
+
+	BuildMASHTransforms(
+		reinterpret_cast<const double(*)[3]>(positions.data()),
+		reinterpret_cast<const double(*)[3]>(rotations.data()),
+		reinterpret_cast<const double(*)[3]>(scales.data()),
+		result.data(),
+		static_cast<int>(count));
 
-		double rotationRadiansArray[] = { deg2rad(rotation.x), deg2rad(rotation.y), deg2rad(rotation.z) };
-		double scaleArray[] = { scale.x, scale.y, scale.z };
+	return result;
+}
 
-		MTransformationMatrix transformFromMASH;
-		transformFromMASH.setScale(scaleArray, MSpace::Space::kWorld);
-		transformFromMASH.setRotation(rotationRadiansArray, MTransformationMatrix::RotationOrder::kXYZ);
-		transformFromMASH.setTranslation(position, MSpace::Space::kWorld);
+std::vector<char> InstancerMASH::GetVisibility(size_t count) const
+{
+	std::vector<char> result(count, 1);
 
-		result.push_back(transformFromMASH.asMatrix());
+	MFnDependencyNode instancerDagNode(m.object);
+	MPlug plug(m.object, instancerDagNode.attribute("inp"));
+	MObject data = plug.asMDataHandle().data();
+	MFnArrayAttrsData arrayAttrsData(data);
+
+	// visibility channel is optional
+	MStatus res;
+	MFnArrayAttrsData::Type arrType;
+	if (!arrayAttrsData.checkArrayExist("visibility", arrType, &res))
+		return result;
+
+	MDoubleArray visibilityData = arrayAttrsData.getDoubleData("visibility", &res);
+	if (res != MStatus::kSuccess)
+		return result;
+
+	size_t visibilityCount = std::min(count, static_cast<size_t>(visibilityData.length()));
+	for (size_t i = 0; i < visibilityCount; ++i)
+	{
+		result[i] = (visibilityData[static_cast<unsigned int>(i)] > 0.0) ? 1 : 0;
 	}
 
 	return result;
 }
 
+MMatrix InstancerMASH::GetTargetTransform(const FireRenderMesh& renderMesh) const
+{
+	//Target node translation shouldn't affect the result 
+	// translation of shape in group however should
+	MFnDagNode meshTransformNode(MFnDagNode(renderMesh.Object()).parent(0));
+	MTransformationMatrix targetNodeMatrix = MFnTransform(meshTransformNode.object()).transformation();
+	MFnDagNode groupTransformNode(meshTransformNode.parent(0));
+	if (groupTransformNode.name() != "world")
+	{
+		MTransformationMatrix groupNodeMatrix = MFnTransform(groupTransformNode.object()).transformation();
+		groupNodeMatrix.setTranslation({ 0., 0., 0. }, MSpace::kObject);
+		MMatrix groupTransform = groupNodeMatrix.asMatrix();
+		MMatrix meshTransform = targetNodeMatrix.asMatrix();
+
+		targetNodeMatrix = meshTransform * groupTransform;
+	}
+	else
+	{
+		targetNodeMatrix.setTranslation({ 0., 0., 0. }, MSpace::kObject);
+	}
+
+	return targetNodeMatrix.asMatrix();
+}
+
+const std::vector<std::string>& InstancerMASH::GetPrototypeIds(size_t objectIndex, size_t shapeCount)
+{
+	// Generate unique uuid, because we can't use instancer uuid - it initiates infinite Freshen() on whole hierarchy.
+	// Ids are generated once per prototype shape and kept across updates, so the prototype mesh built from the shape keeps its id.
+	// All points instancing the shape are instances of that single prototype, which is translated separately from the source mesh
+	std::vector<std::string>& ids = m_prototypeIds[objectIndex];
+	while (ids.size() < shapeCount)
+	{
+		MUuid uuid;
+		uuid.generate();
+		ids.push_back(uuid.asString().asChar());
+	}
+
+	return ids;
+}
+
+// Sets motion of MASH instance shape from its transforms at current and next frame, the same way FireRenderMeshCommon::ProcessMotionBlur does for meshes
+void SetInstanceMotionBlur(frw::Shape& shape, const MMatrix& matrix, const MMatrix& nextFrameMatrix, bool isRPR2)
+{
+	if (isRPR2)
+	{
+		float nextFrameFloats[4][4];
+		FireMaya::ScaleMatrixFromCmToMFloats(nextFrameMatrix, nextFrameFloats);
+		shape.SetMotionTransform(&nextFrameFloats[0][0], false);
+		return;
+	}
+
+	MVector linearMotion(0, 0, 0);
+	MVector rotationAxis(1, 0, 0);
+	double rotationAngle = 0.0;
+
+	FireMaya::CalculateMotionBlurParams(matrix, nextFrameMatrix, linearMotion, rotationAxis, rotationAngle);
+
+	shape.SetLinearMotion(float(linearMotion.x), float(linearMotion.y), float(linearMotion.z));
+	shape.SetAngularMotion(float(rotationAxis.x), float(rotationAxis.y), float(rotationAxis.z), float(rotationAngle));
+}
+
+void InstancerMASH::CreateInstances(const MASHContext& mashContext, size_t objectIndex, size_t pointIndex)
+{
+	// get object(s) to be instanced
+	auto it = mashContext.m_shapesCache.find(objectIndex);
+	assert(it != mashContext.m_shapesCache.end());
+	if (it == mashContext.m_shapesCache.end())
+		return;
+
+	const std::vector<MObject>& shapesToBeCreated = it->second;
+	const std::vector<std::string>& ids = GetPrototypeIds(objectIndex, shapesToBeCreated.size());
+
+	for (size_t currObjIdx = 0; currObjIdx < shapesToBeCreated.size(); ++currObjIdx)
+	{
+		// prototype is created once per shape, instances only store point index
+		auto lookupIt = m_prototypeLookup.find(std::make_pair(objectIndex, currObjIdx));
+		if (lookupIt == m_prototypeLookup.end())
+		{
+			FireRenderObject* pFoundObj = context()->getRenderObject(shapesToBeCreated[currObjIdx]);
+			if (!pFoundObj)
+				continue;
+
+			FireRenderMesh* renderMesh = static_cast<FireRenderMesh*>(pFoundObj);
+			assert(renderMesh);
+
+			PrototypeInstances prototypeInstances;
+			prototypeInstances.prototype = std::make_shared<FireRenderMeshMASH>(*renderMesh, ids[currObjIdx], m.object);
+			m_prototypes.push_back(std::move(prototypeInstances));
+
+			lookupIt = m_prototypeLookup.emplace(std::make_pair(objectIndex, currObjIdx), m_prototypes.size() - 1).first;
+		}
+
+		m_prototypes[lookupIt->second].pointIndices.push_back(pointIndex);
+	}
+}
+
+void InstancerMASH::DetachInstances(PrototypeInstances& prototypeInstances)
+{
+	frw::Scene scene = context()->GetScene();
+
+	for (size_t instanceIdx = 0; instanceIdx < prototypeInstances.attached.size(); ++instanceIdx)
+	{
+		if (!prototypeInstances.attached[instanceIdx])
+			continue;
+
+		for (size_t elementIdx = 0; elementIdx < prototypeInstances.elementCount; ++elementIdx)
+		{
+			frw::Shape& shape = prototypeInstances.shapes[instanceIdx * prototypeInstances.elementCount + elementIdx];
+			if (shape && scene)
+				scene.Detach(shape);
+		}
+
+		prototypeInstances.attached[instanceIdx] = 0;
+	}
+}
+
+void InstancerMASH::ClearInstances()
+{
+	for (PrototypeInstances& prototypeInstances : m_prototypes)
+	{
+		DetachInstances(prototypeInstances);
+		prototypeInstances.prototype->setVisibility(false);
+	}
+
+	m_prototypes.clear();
+	m_prototypeLookup.clear();
+}
+
 InstancerMASH::MASHContext::MASHContext()
 	: m_isValid(false)
 	, m_objectIndexArray()
@@ -157,7 +419,6 @@ InstancerMASH::MASHContext::MASHContext()
 	, m_rotationArray()
 	, m_scaleArray()
 	, m_shapesCache()
-	, m_uuidVectors()
 {}
 
 bool InstancerMASH::MASHContext::Init(MFnArrayAttrsData& arrayAttrsData, const InstancerMASH* pInstancer)
@@ -193,9 +454,6 @@ bool InstancerMASH::MASHContext::Init(MFnArrayAttrsData& arrayAttrsData, const I
 
 	m_objectIndexArray = dblArray;
 
-	// Generate unique uuid, because we can't use instancer uuid - it initiates infinite Freshen() on whole hierarchy
-	m_uuidVectors.resize(m_objectIndexArray.length());
-
 	for (unsigned int idx = 0; idx < m_objectIndexArray.length(); ++idx)
 	{
 		size_t objectIndex = (size_t)m_objectIndexArray[idx];
@@ -310,44 +568,10 @@ void InstancerMASH::GenerateInstancesById(
 	// generate objects
 	for (unsigned int idArrayIndex = 0; idArrayIndex < mashContext.m_idArray.length(); ++idArrayIndex)
 	{
-		// get object(s) to be instanced
 		size_t objectIndex = (size_t)mashContext.m_objectIndexArray[idArrayIndex];
-		auto it = mashContext.m_shapesCache.find(objectIndex);
-		assert(it != mashContext.m_shapesCache.end());
-		if (it == mashContext.m_shapesCache.end())
-			continue;
-
-		std::vector<MObject>& shapesToBeCreated = it->second;
-
-		// generate objectId(s) for new objects if neceessary
-		std::vector<MUuid>& uuidVector = mashContext.m_uuidVectors[objectIndex];
-		while (shapesToBeCreated.size() != uuidVector.size())
-		{
-			MUuid uuid;
-			uuid.generate();
-			uuidVector.push_back(uuid);
-		}
-
-		// proceeed with generating objects
 		size_t id = (size_t)mashContext.m_idArray[idArrayIndex];
-		size_t currObjIdx = 0;
-		for (MObject& tmpObj : shapesToBeCreated)
-		{
-			FireRenderObject* pFoundObj = context()->getRenderObject(tmpObj);
-			if (!pFoundObj)
-				continue;
 
-			FireRenderMesh* renderMesh = static_cast<FireRenderMesh*>(pFoundObj);
-			assert(renderMesh);
-
-			auto instance = std::make_shared<FireRenderMeshMASH>(
-				*renderMesh,
-				uuidVector[currObjIdx].asString().asChar(),
-				m.object);
-			m_instancedObjects[id].push_back(instance);
-
-			currObjIdx++;
-		}
+		CreateInstances(mashContext, objectIndex, id);
 	}
 }
 
@@ -358,65 +582,13 @@ void InstancerMASH::GenerateInstancesByParams(
 	assert(mashContext.IsValid());
 	assert(mashContext.IsByParams());
 
-	MStatus res;
-
+	// transforms are set in PreProcessMesh for all instances at once
 	unsigned int countObjects = mashContext.m_objectIndexArray.length();
 	for (unsigned int idx = 0; idx < countObjects; ++idx)
 	{
-		// make transformation matrix for object to be instanced
-		MTransformationMatrix matr;
-		double vec_scale[3];
-		res = mashContext.m_scaleArray[idx].get(vec_scale);
-		assert(res == MStatus::kSuccess);
-		matr.setScale(vec_scale, MSpace::kTransform);
-
-		MEulerRotation rot(mashContext.m_rotationArray[idx]);
-		matr.rotateTo(rot);
-
-		double vec_transform[3];
-		res = mashContext.m_positionArray[idx].get(vec_transform);
-		assert(res == MStatus::kSuccess);
-		matr.setTranslation(vec_transform, MSpace::kTransform);
-
-		// get object(s) to be instanced
 		size_t objectIndex = (size_t)mashContext.m_objectIndexArray[idx];
-		auto it = mashContext.m_shapesCache.find(objectIndex);
-		assert(it != mashContext.m_shapesCache.end());
-		if (it == mashContext.m_shapesCache.end())
-			continue;
-
-		std::vector<MObject>& shapesToBeCreated = it->second;
-
-		// generate objectId(s) for new objects if neceessary
-		std::vector<MUuid>& uuidVector = mashContext.m_uuidVectors[objectIndex];
-		while (shapesToBeCreated.size() != uuidVector.size())
-		{
-			MUuid uuid;
-			uuid.generate();
-			uuidVector.push_back(uuid);
-		}
-
-		// proceeed with generating objects
-		size_t currObjIdx = 0;
-		for (MObject& tmpObj : shapesToBeCreated)
-		{
-			FireRenderObject* pFoundObj = context()->getRenderObject(tmpObj);
-			if (!pFoundObj)
-				continue;
-
-			FireRenderMesh* renderMesh = static_cast<FireRenderMesh*>(pFoundObj);
-			assert(renderMesh);
 
-			auto instance = std::make_shared<FireRenderMeshMASH>(
-				*renderMesh,
-				uuidVector[currObjIdx].asString().asChar(),
-				m.object);
-			m_instancedObjects[idx].push_back(instance);
-
-			instance->SetSelfTransform(matr.asMatrix());
-
-			currObjIdx++;
-		}
+		CreateInstances(mashContext, objectIndex, idx);
 	}
 }
 
@@ -430,66 +602,96 @@ bool InstancerMASH::ShouldBeRecreated() const
 
 bool InstancerMASH::PreProcessMesh(unsigned int sampleIdx /*= 0*/)
 {
-	if (sampleIdx != 0)
-	{
-		for (auto it = m_instancedObjects.begin(); it != m_instancedObjects.end(); ++it)
-		{
-			for (auto& instancedFRObject : it->second)
-			{
-				instancedFRObject->PreProcessMesh(sampleIdx);
-			}
-		}
-
-		return true;
-	}
-
 	if (GetTargetObjects().empty())
 	{
 		return false;
 	}
 
-	if (m_instancedObjects.empty())
+	if (m_prototypes.empty())
 	{
 		GenerateInstances();
+		m_fullUpdateRequired = true;
 	}
 
-	MTransformationMatrix instancerMatrix = MFnTransform(m.object).transformation();
+	MMatrix instancerMatrix = MFnTransform(m.object).transformation().asMatrix();
 	std::vector<MMatrix> matricesFromMASH = GetTransformMatrices();
 
-	std::vector<MObject> targetObjects = GetTargetObjects();
+	const size_t instanceCount = std::min(GetInstanceCount(), matricesFromMASH.size());
+	std::vector<char> visibility = GetVisibility(instanceCount);
+
+	if (m_instanceTransforms.size() != instanceCount)
+	{
+		m_instanceTransforms.resize(instanceCount);
+		m_instanceVisibility.resize(instanceCount);
+		m_fullUpdateRequired = true;
+	}
 
-	for (size_t i = 0; i < GetInstanceCount(); i++)
+	// motion blur moves instances to their transforms at the next frame, like GetMatrixForTheNextFrame does for meshes
+	bool motionBlur = context()->motionBlur() && (MAnimControl::currentTime() != MAnimControl::maxTime());
+
+	std::vector<MMatrix> nextMatricesFromMASH;
+	MMatrix nextInstancerMatrix = instancerMatrix;
+	if (motionBlur)
 	{
-		std::vector<std::shared_ptr<FireRenderMeshMASH>>& instancedObjects = m_instancedObjects.at(i);
-		for (auto& instancedFRObject : instancedObjects)
+		MTime nextTime = MAnimControl::currentTime();
+		nextTime++;
+
+		nextMatricesFromMASH = GetTransformMatrices(&nextTime);
+
+		MObject matrixData;
+		MPlug matrixPlug(m.object, MFnDependencyNode(m.object).attribute("matrix"));
+		if (!matrixPlug.isNull() && (matrixPlug.getValue(matrixData, MDGContext(nextTime)) == MStatus::kSuccess))
 		{
-			const FireRenderMesh& renderMesh = instancedFRObject->GetOriginalFRMeshinstancedObject();
-
-			//Target node translation shouldn't affect the result 
-			// translation of shape in group however should
-			MFnDagNode meshTransformNode(MFnDagNode(renderMesh.Object()).parent(0));
-			MTransformationMatrix targetNodeMatrix = MFnTransform(meshTransformNode.object()).transformation();
-			MFnDagNode groupTransformNode(meshTransformNode.parent(0));
-			if (groupTransformNode.name() != "world")
-			{
-				MTransformationMatrix groupNodeMatrix = MFnTransform(groupTransformNode.object()).transformation();
-				groupNodeMatrix.setTranslation({ 0., 0., 0. }, MSpace::kObject);
-				MMatrix groupTransform = groupNodeMatrix.asMatrix();
-				MMatrix meshTransform = targetNodeMatrix.asMatrix();
+			nextInstancerMatrix = MFnMatrixData(matrixData).matrix();
+		}
+	}
 
-				targetNodeMatrix = meshTransform * groupTransform;
-			}
-			else
-			{
-				targetNodeMatrix.setTranslation({ 0., 0., 0. }, MSpace::kObject);
-			}
+	size_t nextTransformCount = motionBlur ? instanceCount : 0;
+	if (m_nextInstanceTransforms.size() != nextTransformCount)
+	{
+		m_nextInstanceTransforms.resize(nextTransformCount);
+		m_fullUpdateRequired = true;
+	}
 
-			MMatrix newTransform = targetNodeMatrix.asMatrix();
-			newTransform *= matricesFromMASH.at(i);
-			newTransform *= instancerMatrix.asMatrix();
+	// Target transforms are the same for all instances of a prototype
+	for (PrototypeInstances& prototypeInstances : m_prototypes)
+	{
+		MMatrix targetTransform = GetTargetTransform(prototypeInstances.prototype->GetOriginalFRMeshinstancedObject());
+		if (targetTransform != prototypeInstances.targetTransform)
+		{
+			prototypeInstances.targetTransform = targetTransform;
+			m_fullUpdateRequired = true;
+		}
+	}
 
-			instancedFRObject->SetSelfTransform(newTransform);
-			instancedFRObject->PreProcessMesh(sampleIdx);
+	// Only points whose transform or visibility has changed are updated
+	m_changedPoints.assign(instanceCount, 0);
+	for (size_t i = 0; i < instanceCount; i++)
+	{
+		MMatrix instanceTransform = matricesFromMASH[i] * instancerMatrix;
+
+		// points without data at the next frame don't move
+		MMatrix nextInstanceTransform = (i < nextMatricesFromMASH.size()) ? nextMatricesFromMASH[i] * nextInstancerMatrix : instanceTransform;
+		bool nextTransformChanged = motionBlur && (nextInstanceTransform != m_nextInstanceTransforms[i]);
+
+		if (!m_fullUpdateRequired && (instanceTransform == m_instanceTransforms[i]) && (visibility[i] == m_instanceVisibility[i]) && !nextTransformChanged)
+			continue;
+
+		m_instanceTransforms[i] = instanceTransform;
+		m_instanceVisibility[i] = visibility[i];
+		m_changedPoints[i] = 1;
+
+		if (motionBlur)
+		{
+			m_nextInstanceTransforms[i] = nextInstanceTransform;
+		}
+	}
+
+	if (m_fullUpdateRequired)
+	{
+		for (PrototypeInstances& prototypeInstances : m_prototypes)
+		{
+			prototypeInstances.prototype->PreProcessMesh(sampleIdx);
 		}
 	}
 
@@ -502,13 +704,79 @@ void InstancerMASH::Freshen(bool shouldCalculateHash)
 {
 	RegisterCallbacks();
 
-	for (auto it = m_instancedObjects.begin(); it != m_instancedObjects.end(); ++it)
+	frw::Scene scene = context()->GetScene();
+	bool isRPR2 = TahoeContext::IsGivenContextRPR2(context());
+
+	// hiding the instancer (or any of its parents) detaches all instances
+	MDagPath instancerPath = DagPath();
+	bool instancerVisible = instancerPath.isValid() && instancerPath.isVisible();
+	bool instancerVisibilityChanged = instancerVisible != m_instancerVisible;
+	m_instancerVisible = instancerVisible;
+
+	for (PrototypeInstances& prototypeInstances : m_prototypes)
 	{
-		for (auto& instancedFRObject : it->second)
+		FireRenderMeshMASH& prototype = *prototypeInstances.prototype;
+
+		if (m_fullUpdateRequired)
 		{
-			instancedFRObject->Rebuild();
-			instancedFRObject->setDirty();
+			DetachInstances(prototypeInstances);
+
+			// prototype is translated once, its own shapes are only used as a source for instances
+			prototype.Rebuild();
+			prototype.setVisibility(false);
+
+			prototypeInstances.elementCount = prototype.Elements().size();
+			prototype.CreateInstanceShapes(prototypeInstances.pointIndices.size(), prototypeInstances.shapes);
+			prototypeInstances.attached.assign(prototypeInstances.pointIndices.size(), 0);
+		}
+
+		bool motionBlur = !m_nextInstanceTransforms.empty() && prototype.IsMotionBlurEnabled(MFnDagNode(prototype.Object()));
+
+		const size_t elementCount = prototypeInstances.elementCount;
+		for (size_t instanceIdx = 0; instanceIdx < prototypeInstances.pointIndices.size(); ++instanceIdx)
+		{
+			size_t pointIdx = prototypeInstances.pointIndices[instanceIdx];
+			if (pointIdx >= m_instanceTransforms.size())
+				continue;
+
+			bool changed = (pointIdx < m_changedPoints.size()) && m_changedPoints[pointIdx];
+			if (!m_fullUpdateRequired && !changed && !instancerVisibilityChanged)
+				continue;
+
+			// convert Maya mesh in cm to m
+			MMatrix instanceTransform = prototypeInstances.targetTransform * m_instanceTransforms[pointIdx];
+			float mfloats[4][4];
+			FireMaya::ScaleMatrixFromCmToMFloats(instanceTransform, mfloats);
+
+			MMatrix nextInstanceTransform = motionBlur ? prototypeInstances.targetTransform * m_nextInstanceTransforms[pointIdx] : instanceTransform;
+
+			bool visible = instancerVisible && (m_instanceVisibility[pointIdx] != 0);
+			for (size_t elementIdx = 0; elementIdx < elementCount; ++elementIdx)
+			{
+				frw::Shape& shape = prototypeInstances.shapes[instanceIdx * elementCount + elementIdx];
+				if (!shape)
+					continue;
+
+				shape.SetTransform(&mfloats[0][0]);
+
+				if (motionBlur)
+				{
+					SetInstanceMotionBlur(shape, instanceTransform, nextInstanceTransform, isRPR2);
+				}
+
+				if (!scene || (visible == (prototypeInstances.attached[instanceIdx] != 0)))
+					continue;
+
+				if (visible)
+					scene.Attach(shape);
+				else
+					scene.Detach(shape);
+			}
+
+			prototypeInstances.attached[instanceIdx] = visible ? 1 : 0;
 		}
 	}
-}
 
+	m_changedPoints.clear();
+	m_fullUpdateRequired = false;
+}
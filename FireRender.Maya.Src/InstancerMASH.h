@@ -24,20 +24,62 @@ class FireRenderMeshMASH;
 
 /**
 	Instancer class used to pass generated data from MASH into core.
-	Handles all instanced objects lifecycle.
-	For now supports only one target object, but already retieves all instanced object array
+	Each prototype shape is translated once and instanced in RPR,
+	instances themselves are stored as plain arrays without scene objects of their own.
 */
 class InstancerMASH: public FireRenderNode
 {
-	using FireRenderObjectMap = std::map<std::size_t, std::vector<std::shared_ptr<FireRenderMeshMASH>>>;
+	/** Prototype shape with all its instances */
+	struct PrototypeInstances
+	{
+		/** Translated prototype, its own shapes are not attached to scene */
+		std::shared_ptr<FireRenderMeshMASH> prototype;
+
+		/** Transform of target node applied to all instances */
+		MMatrix targetTransform;
+
+		/** MASH point index of each instance */
+		std::vector<size_t> pointIndices;
+
+		/** RPR instances of prototype shapes, elementCount shapes per instance */
+		std::vector<frw::Shape> shapes;
+		size_t elementCount = 0;
+
+		/** Attached to scene state of each instance */
+		std::vector<char> attached;
+	};
+
+	std::vector<PrototypeInstances> m_prototypes;
 
-	/** All objects created by instancer */
-	FireRenderObjectMap m_instancedObjects;
+	/** Index in m_prototypes for (object index, shape index) */
+	std::map<std::pair<size_t, size_t>, size_t> m_prototypeLookup;
 
 	size_t m_instancedObjectsCachedSize;
 
+	/** Ids of prototype shapes (object index -> id per shape) */
+	std::map<size_t, std::vector<std::string>> m_prototypeIds;
+
+	/** MASH * instancer transforms per point, used to update only changed instances */
+	std::vector<MMatrix> m_instanceTransforms;
+
+	/** Transforms per point at the next frame, empty if motion blur is off */
+	std::vector<MMatrix> m_nextInstanceTransforms;
+
+	/** Visibility per point */
+	std::vector<char> m_instanceVisibility;
+
+	/** Points changed since last Freshen call */
+	std::vector<char> m_changedPoints;
+
+	/** Set when prototypes should be rebuilt and all instances updated */
+	bool m_fullUpdateRequired;
+
+	/** DAG visibility of the instancer at last Freshen call, instances are attached only if the instancer is visible */
+	bool m_instancerVisible;
+
 public:
     InstancerMASH(FireRenderContext* context, const MDagPath& dagPath);
+	virtual ~InstancerMASH();
 	virtual void RegisterCallbacks(void) override final;
 	virtual void Freshen(bool shouldCalculateHash) override final;
 	virtual void OnPlugDirty(MObject& node, MPlug& plug) override final;
@@ -55,7 +97,6 @@ private:
 		MVectorArray m_scaleArray;
 
 		std::map<size_t, std::vector<MObject>> m_shapesCache;
-		std::vector<std::vector<MUuid>> m_uuidVectors;
 
 		bool m_isValid;
 
@@ -69,7 +110,13 @@ private:
 
 	size_t GetInstanceCount(void) const;
 	std::vector<MObject> GetTargetObjects(void) const;
-	std::vector<MMatrix> GetTransformMatrices(void) const;
+	std::vector<MMatrix> GetTransformMatrices(const MTime* time = nullptr) const;
+	std::vector<char> GetVisibility(size_t count) const;
+	MMatrix GetTargetTransform(const FireRenderMesh& renderMesh) const;
+	const std::vector<std::string>& GetPrototypeIds(size_t objectIndex, size_t shapeCount);
+	void CreateInstances(const MASHContext& mashContext, size_t objectIndex, size_t pointIndex);
+	void ClearInstances(void);
+	void DetachInstances(PrototypeInstances& prototypeInstances);
 	void GenerateInstances(void);
 	void GenerateInstancesById(MASHContext& mashContext);
 	void GenerateInstancesByParams(MASHContext& mashContext);
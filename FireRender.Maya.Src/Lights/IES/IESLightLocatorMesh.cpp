@@ -14,8 +14,6 @@ limitations under the License.
 #include "IESLightLocatorMesh.h"
 
 #include <cassert>
-#include <fstream>
-#include <sstream>
 
 #include <maya/MFloatMatrix.h>
 #include <maya/MEulerRotation.h>
@@ -23,8 +21,7 @@ limitations under the License.
 #include "base_mesh.h"
 #include "FireRenderError.h"
 #include "FireRenderUtils.h"
-#include "IESLight/IESprocessor.h"
-#include "IESLight/IESLightRepresentationCalc.h"
+#include "IESProfileCache.h"
 #if defined(OSMac_)
 #include "Translators.h"
 #else
@@ -42,125 +39,38 @@ namespace
 		return N;
 	}
 
-	const char* DescribeIESError(IESLightRepresentationErrorCode code)
-	{
-		switch (code)
-		{
-			case IESLightRepresentationErrorCode::INVALID_DATA:
-				return "Invalid ies data";
-
-			case IESLightRepresentationErrorCode::NO_EDGES:
-				return "Could not build nay edges to show ies light";
-		}
-
-		// Wrong use of this function
-		assert(false);
-		return nullptr;
-	}
-
-	const char* DescribeIESError(IESProcessor::ErrorCode code)
-	{
-		switch (code)
-		{
-			case IESProcessor::ErrorCode::NO_FILE:
-				return "Given file is empty";
-
-			case IESProcessor::ErrorCode::NOT_IES_FILE:
-				return "Wrong file (not *ies)";
-
-			case IESProcessor::ErrorCode::FAILED_TO_READ_FILE:
-				return "Failed to open the file";
-
-			case IESProcessor::ErrorCode::INVALID_DATA_IN_IES_FILE:
-				return "Invalid data in ies file";
-
-			case IESProcessor::ErrorCode::PARSE_FAILED:
-				return "ies file parsing failed";
-
-			case IESProcessor::ErrorCode::UNEXPECTED_END_OF_FILE:
-				return "Unexpected end of ies file";
-
-			case IESProcessor::ErrorCode::NOT_SUPPORTED:
-				return "Not supported format of ies file";
-		}
-
-		// Wrong use of this function
-		assert(false);
-		return nullptr;
-	}
-
 	bool GenerateIESRepresentation(
-		const wchar_t* filename,
+		const MString& filename,
 		size_t pointsPerPolyline,
 		float scale,
 		std::vector<MFloatVector>& vertices,
 		std::vector<unsigned int>& indices)
 	{
-		vertices.clear();
-		indices.clear();
-
-		FireRenderError error;
-		IESProcessor processor;
-		IESLightRepresentationParams params;
-		std::vector<std::vector<RadeonProRender::float3>> polylines;
-		params.maxPointsPerPLine = pointsPerPolyline;
-		params.webScale = scale;
+		// The profile is parsed and its representation is built once for all lights using the file
+		auto profile = IESProfileCache::GetProfileWithRepresentation(filename, pointsPerPolyline, scale);
 
-		auto parseError = processor.Parse(params.data, filename);
-
-		if (parseError != IESProcessor::ErrorCode::SUCCESS)
+		if (!profile->error.empty())
 		{
-			std::stringstream errorMessage;
-			const char* errorDescription = DescribeIESError(parseError);
-			errorMessage << "RPR Error: Failed to parse ies file";
+			FireRenderError error;
 
-			if (errorDescription != nullptr)
+			if (!profile->valid)
 			{
-				errorMessage << " (reason: " << errorDescription << ") ";
+				error.set("Parse error", profile->error.c_str(), false, false);
 			}
-
-			error.set("Parse error", errorMessage.str().c_str(), false, false);
-		}
-
-		if (!error.check())
-		{
-			auto calcError = CalculateIESLightRepresentation(polylines, params);
-
-			if (calcError != IESLightRepresentationErrorCode::SUCCESS)
+			else
 			{
-				std::stringstream errorMessage;
-				const char* errorDescription = DescribeIESError(calcError);
-				errorMessage << "RPR Warning: ies file parsed successfully but failed to build it's representation";
-
-				if (errorDescription != nullptr)
-				{
-					errorMessage << " (reason: " << errorDescription << ") ";
-				}
-
-				error.set("Show ies form failed", errorMessage.str().c_str());
+				error.set("Show ies form failed", profile->error.c_str());
 			}
-		}
 
-		if (error.check())
-		{
+			vertices.clear();
+			indices.clear();
+
 			// report failure
 			return false;
 		}
 
-		// Convert polyline to lines
-		for (const auto& polyline : polylines)
-		{
-			size_t verticesCount = polyline.size();
-			for (size_t nVertex = 0; nVertex < verticesCount; ++nVertex)
-			{
-				const bool duplicateIndex = (nVertex > 0 && nVertex + 1 < verticesCount);
-				const auto& vertex = polyline[nVertex];
-				const unsigned vertexIndex = static_cast<unsigned>(vertices.size());
-
-				indices.insert(indices.end(), duplicateIndex ? 2 : 1, vertexIndex);
-				vertices.emplace_back(vertex.x, vertex.y, vertex.z);
-			}
-		}
+		vertices = profile->vertices;
+		indices = profile->indices;
 
 		// report success
 		return true;
@@ -225,7 +135,7 @@ bool IESLightLocatorMeshBase::SetFilename(const MString filename, bool forcedUpd
 	else
 	{
 		const size_t pointsPerPolyline = 32;
-		bool isGenerated = GenerateIESRepresentation(castedName, pointsPerPolyline, IES_SCALE_MUL, m_vertices, m_indices);
+		bool isGenerated = GenerateIESRepresentation(filename, pointsPerPolyline, IES_SCALE_MUL, m_vertices, m_indices);
 	}
 
 	m_filename = filename;
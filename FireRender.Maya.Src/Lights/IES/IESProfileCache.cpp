@@ -0,0 +1,199 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#include "IESProfileCache.h"
+
+#include <cassert>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include "IESLight/IESprocessor.h"
+#include "IESLight/IESLightRepresentationCalc.h"
+
+namespace
+{
+	const char* DescribeIESError(IESLightRepresentationErrorCode code)
+	{
+		switch (code)
+		{
+			case IESLightRepresentationErrorCode::INVALID_DATA:
+				return "Invalid ies data";
+
+			case IESLightRepresentationErrorCode::NO_EDGES:
+				return "Could not build nay edges to show ies light";
+		}
+
+		// Wrong use of this function
+		assert(false);
+		return nullptr;
+	}
+
+	const char* DescribeIESError(IESProcessor::ErrorCode code)
+	{
+		switch (code)
+		{
+			case IESProcessor::ErrorCode::NO_FILE:
+				return "Given file is empty";
+
+			case IESProcessor::ErrorCode::NOT_IES_FILE:
+				return "Wrong file (not *ies)";
+
+			case IESProcessor::ErrorCode::FAILED_TO_READ_FILE:
+				return "Failed to open the file";
+
+			case IESProcessor::ErrorCode::INVALID_DATA_IN_IES_FILE:
+				return "Invalid data in ies file";
+
+			case IESProcessor::ErrorCode::PARSE_FAILED:
+				return "ies file parsing failed";
+
+			case IESProcessor::ErrorCode::UNEXPECTED_END_OF_FILE:
+				return "Unexpected end of ies file";
+
+			case IESProcessor::ErrorCode::NOT_SUPPORTED:
+				return "Not supported format of ies file";
+		}
+
+		// Wrong use of this function
+		assert(false);
+		return nullptr;
+	}
+
+	struct CacheEntry
+	{
+		long long modificationTime = 0;
+		IESLightRepresentationParams params;
+		std::shared_ptr<const IESProfileCache::Profile> profile;
+	};
+
+	std::mutex cacheMutex;
+	std::map<std::wstring, CacheEntry> cache;
+
+	long long GetModificationTime(const std::wstring& filePath)
+	{
+		std::error_code errorCode;
+		auto time = std::filesystem::last_write_time(std::filesystem::path(filePath), errorCode);
+
+		return errorCode ? 0 : static_cast<long long>(time.time_since_epoch().count());
+	}
+
+	// Must be called with the cache mutex locked
+	CacheEntry& FindOrParse(const MString& filePath)
+	{
+		std::wstring path = filePath.asWChar();
+		long long modificationTime = GetModificationTime(path);
+
+		auto it = cache.find(path);
+		if (it != cache.end() && it->second.modificationTime == modificationTime)
+		{
+			return it->second;
+		}
+
+		CacheEntry& entry = cache[path];
+		entry = CacheEntry();
+		entry.modificationTime = modificationTime;
+
+		auto profile = std::make_shared<IESProfileCache::Profile>();
+
+		IESProcessor processor;
+		auto parseError = processor.Parse(entry.params.data, path.c_str());
+
+		if (parseError == IESProcessor::ErrorCode::SUCCESS)
+		{
+			profile->valid = true;
+			profile->iesData = processor.ToString(entry.params.data);
+		}
+		else
+		{
+			std::stringstream errorMessage;
+			const char* errorDescription = DescribeIESError(parseError);
+			errorMessage << "RPR Error: Failed to parse ies file";
+
+			if (errorDescription != nullptr)
+			{
+				errorMessage << " (reason: " << errorDescription << ") ";
+			}
+
+			profile->error = errorMessage.str();
+		}
+
+		entry.profile = profile;
+
+		return entry;
+	}
+}
+
+std::shared_ptr<const IESProfileCache::Profile> IESProfileCache::GetProfile(const MString& filePath)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	return FindOrParse(filePath).profile;
+}
+
+std::shared_ptr<const IESProfileCache::Profile> IESProfileCache::GetProfileWithRepresentation(const MString& filePath, size_t pointsPerPolyline, float scale)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	CacheEntry& entry = FindOrParse(filePath);
+
+	if (!entry.profile->valid || entry.profile->hasRepresentation)
+	{
+		return entry.profile;
+	}
+
+	// Profiles handed out earlier are not modified, the representation is added to a copy
+	auto profile = std::make_shared<Profile>(*entry.profile);
+	profile->hasRepresentation = true;
+
+	std::vector<std::vector<RadeonProRender::float3>> polylines;
+	entry.params.maxPointsPerPLine = pointsPerPolyline;
+	entry.params.webScale = scale;
+
+	auto calcError = CalculateIESLightRepresentation(polylines, entry.params);
+
+	if (calcError != IESLightRepresentationErrorCode::SUCCESS)
+	{
+		std::stringstream errorMessage;
+		const char* errorDescription = DescribeIESError(calcError);
+		errorMessage << "RPR Warning: ies file parsed successfully but failed to build it's representation";
+
+		if (errorDescription != nullptr)
+		{
+			errorMessage << " (reason: " << errorDescription << ") ";
+		}
+
+		profile->error = errorMessage.str();
+	}
+	else
+	{
+		// Convert polyline to lines
+		for (const auto& polyline : polylines)
+		{
+			size_t verticesCount = polyline.size();
+			for (size_t nVertex = 0; nVertex < verticesCount; ++nVertex)
+			{
+				const bool duplicateIndex = (nVertex > 0 && nVertex + 1 < verticesCount);
+				const auto& vertex = polyline[nVertex];
+				const unsigned vertexIndex = static_cast<unsigned>(profile->vertices.size());
+
+				profile->indices.insert(profile->indices.end(), duplicateIndex ? 2 : 1, vertexIndex);
+				profile->vertices.emplace_back(vertex.x, vertex.y, vertex.z);
+			}
+		}
+	}
+
+	entry.profile = profile;
+
+	return entry.profile;
+}
@@ -0,0 +1,54 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#pragma once
+
+#include <maya/MString.h>
+#include <maya/MFloatVector.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+* Parsed IES profiles shared by all lights using the same file.
+* Entries are keyed by file path and modification time,
+* so a file which is edited on disk is parsed again.
+*/
+class IESProfileCache
+{
+public:
+	struct Profile
+	{
+		/** True if the file has been parsed successfully. */
+		bool valid = false;
+
+		/** Description of the parse or representation error. */
+		std::string error;
+
+		/** Photometric data in the form accepted by RPR IES lights. */
+		std::string iesData;
+
+		/** True once building the viewport representation has been attempted. */
+		bool hasRepresentation = false;
+
+		/** Viewport representation as a line list. */
+		std::vector<MFloatVector> vertices;
+		std::vector<unsigned int> indices;
+	};
+
+	/** Get the parsed profile of the file. */
+	static std::shared_ptr<const Profile> GetProfile(const MString& filePath);
+
+	/** Get the parsed profile of the file with its viewport representation. */
+	static std::shared_ptr<const Profile> GetProfileWithRepresentation(const MString& filePath, size_t pointsPerPolyline, float scale);
+};
@@ -21,6 +21,8 @@ limitations under the License.
 #include <string>
 #include <stack>
 #include <regex>
+#include <functional>
+#include <cstring>
 
 #include "frWrap.h"
 #include "FileSystemUtils.h"
@@ -254,31 +256,22 @@ namespace
 		bool top_written; // show is element in top of m_nodes stack already written into xml or not.
 	};
 
-	class XmlReader
+	// Streaming (SAX style) xml reader: the document is scanned once and every element is reported
+	// to the callbacks as soon as it is read, no tree or copies of the remaining text are made
+	class XmlStreamReader
 	{
 	public:
-		struct Node
-		{
-			std::string name;
-			std::string text;
-			std::map<string, string> atts;
-			bool is_closing;
-			Node() : name(""), text(""), is_closing(false) {};
-		};
+		typedef std::vector<std::pair<std::string, std::string>> Attributes;
+		typedef std::function<void(const std::string& name, const Attributes& atts)> StartElementCallback;
 
-		XmlReader(const std::string& file) noexcept
-			: m_xml_text("")
-			, m_is_open(false)
-			, m_is_end(false)
-			, m_self_closing(false)
+		XmlStreamReader(const std::string& file)
+			: m_pos(0)
 		{
-			std::ifstream doc(file);
+			std::ifstream doc(file, std::ios::binary);
 			m_is_open = doc.is_open();
-			m_is_end = !m_is_open;
 			if (m_is_open)
 			{
-				m_xml_text = std::move(std::string((std::istreambuf_iterator<char>(doc)), std::istreambuf_iterator<char>()));
-				next();
+				m_xml_text.assign(std::istreambuf_iterator<char>(doc), std::istreambuf_iterator<char>());
 			}
 		}
 
@@ -287,127 +280,179 @@ namespace
 			return m_is_open;
 		}
 
-		bool isEnd() const noexcept
-		{
-			return m_is_end;
-		}
-		bool next() noexcept
+		// Reports opening and self-closing elements; throws on malformed xml
+		void parse(const StartElementCallback& onStartElement)
 		{
-			//root element is closed
-			if (!m_is_open || m_is_end)
-				return false;
+			std::string name;
+			Attributes atts;
 
-			if (m_self_closing)
+			while (skipTo('<'))
 			{
-				m_self_closing = false;
-				Node& node = m_nodes.top();
-				node.is_closing = true;
-				return true;
-			}
+				m_pos++;
 
-			try
-			{
-				//remove last node if its closed
-				if (!m_nodes.empty() && m_nodes.top().is_closing)
-					m_nodes.pop();
-
-				//regex for searching XML nodes
-				std::regex node_reg("<[^<^>]*>");
-				std::smatch node_match;
-				m_is_end = !std::regex_search(m_xml_text, node_match, node_reg);
-				if (m_is_end)
-					return !m_is_end;
-
-				if (node_match.size() == 0)
-					Throw("Invalid xml: bad node");
-
-				std::string value = node_match[0];
-				std::regex name_reg("[^<][^>\\s/]+"); //ignoring '<' symbol
-				std::smatch name_match;
-				std::regex_search(value, name_match, name_reg);
-
-				//create new node if this is not closing one
-				if (name_match.str().find('/') == std::string::npos)
-					m_nodes.push(Node());
-
-				Node& node = m_nodes.top();
-				node.name = name_match.str();
-				const std::string ksc_ending = "/>"; //self-closing node ending
-				if (value.size() > ksc_ending.size())
-					m_self_closing = std::equal(ksc_ending.rbegin(), ksc_ending.rend(), value.rbegin());
-
-				if (node.name.find('/') != std::string::npos)
+				if (startsWith("?"))
 				{
-					node.is_closing = true;
-					node.name.erase(std::remove(node.name.begin(), node.name.end(), '/')); //remove closing '/'
+					skipPast("?>");
 				}
-				std::regex att_split_reg("[\\S]+=\".*?\""); //split attributes regex string="string"
-				std::string attributes = name_match.suffix().str();
-				auto att_split_begin = std::sregex_iterator(attributes.begin(), attributes.end(), att_split_reg);
-				auto att_split_end = std::sregex_iterator();
-
-				//parsing attributes
-				for (auto i = att_split_begin; i != att_split_end; ++i)
+				else if (startsWith("!--"))
 				{
-					std::string att = i->str();
-					std::regex att_reg("[^=?>\"]+");
-					auto att_begin = std::sregex_iterator(att.begin(), att.end(), att_reg);
-					auto att_end = std::sregex_iterator();
-					std::vector<std::string> splited_att;
-					splited_att.reserve(2); //should be 2 values
-					for (auto j = att_begin; j != att_end; ++j)
-					{
-						splited_att.push_back(j->str());
-					}
-
-					if (splited_att.size() == 2)
-						node.atts[splited_att[0]] = splited_att[1];
-					else // value="" case
-						node.atts[splited_att[0]] = "";
+					skipPast("-->");
 				}
-				//cut parsed data
-				m_xml_text = node_match.suffix().str();
-				//looking for node text data
-				size_t pos = m_xml_text.find('<');
-				if (pos != std::string::npos && !m_self_closing)
+				else if (startsWith("![CDATA["))
 				{
+					skipPast("]]>");
+				}
+				else if (startsWith("!") || startsWith("/"))
+				{
+					// doctype or closing element
+					skipPast(">");
+				}
+				else
+				{
+					readToken(name);
+					readAttributes(atts);
 
-					std::string text = "Quick brown fox";
-					std::regex vowel_re("a|e|i|o|u");
-
-					// write the results to an output iterator
-
-					node.text = m_xml_text.substr(0, pos);
-					node.text = std::regex_replace(node.text, std::regex("^[\\s]+"), std::string("")); //removing beginning white-spaces
-					node.text = std::regex_replace(node.text, std::regex("[\\s]+^"), std::string("")); //removing ending white-spaces
-					node.text = std::regex_replace(node.text, std::regex("[\\s]+"), std::string(" ")); //replace multiple white-spaces by single space
+					onStartElement(name, atts);
 				}
 			}
-			catch (std::exception e)
+		}
+
+		static const std::string& attribute(const Attributes& atts, const char* name)
+		{
+			for (const auto& att : atts)
 			{
-				cout << "Regex exception: " << e.what() << endl;
-				m_is_end = true;
+				if (att.first == name)
+					return att.second;
 			}
-			return !m_is_end;
+
+			throw std::out_of_range(std::string("Invalid xml: missing attribute ") + name);
 		}
 
-		const Node& get() const
+	private:
+		bool skipTo(char c)
 		{
-			return m_nodes.top();
+			m_pos = m_xml_text.find(c, m_pos);
+			return m_pos != std::string::npos;
 		}
-	private:
-		void Throw(const std::string& msg)
+
+		void skipPast(const char* str)
+		{
+			size_t pos = m_xml_text.find(str, m_pos);
+			if (pos == std::string::npos)
+				throw std::runtime_error("Invalid xml: unterminated tag");
+
+			m_pos = pos + strlen(str);
+		}
+
+		bool startsWith(const char* str) const
+		{
+			return m_xml_text.compare(m_pos, strlen(str), str) == 0;
+		}
+
+		void skipWhitespaces()
+		{
+			while (m_pos < m_xml_text.size() && isspace((unsigned char)m_xml_text[m_pos]))
+				m_pos++;
+		}
+
+		void readToken(std::string& out)
+		{
+			size_t begin = m_pos;
+			while (m_pos < m_xml_text.size())
+			{
+				char c = m_xml_text[m_pos];
+				if (isspace((unsigned char)c) || c == '/' || c == '>' || c == '=')
+					break;
+				m_pos++;
+			}
+
+			if (m_pos == begin)
+				throw std::runtime_error("Invalid xml: bad node");
+
+			out.assign(m_xml_text, begin, m_pos - begin);
+		}
+
+		void readAttributes(Attributes& atts)
 		{
-			m_is_end = true;
-			throw std::runtime_error(msg);
+			size_t count = 0;
+
+			while (true)
+			{
+				skipWhitespaces();
+				if (m_pos >= m_xml_text.size())
+					throw std::runtime_error("Invalid xml: unterminated tag");
+
+				if (startsWith("/>"))
+				{
+					m_pos += 2;
+					break;
+				}
+
+				if (m_xml_text[m_pos] == '>')
+				{
+					m_pos++;
+					break;
+				}
+
+				// attribute strings are reused between elements to avoid allocations
+				if (count == atts.size())
+					atts.emplace_back();
+
+				auto& att = atts[count++];
+				readToken(att.first);
+
+				skipWhitespaces();
+				if (m_pos >= m_xml_text.size() || m_xml_text[m_pos] != '=')
+					throw std::runtime_error("Invalid xml: bad attribute");
+				m_pos++;
+				skipWhitespaces();
+
+				char quote = m_pos < m_xml_text.size() ? m_xml_text[m_pos] : 0;
+				if (quote != '"' && quote != '\'')
+					throw std::runtime_error("Invalid xml: bad attribute");
+
+				size_t end = m_xml_text.find(quote, m_pos + 1);
+				if (end == std::string::npos)
+					throw std::runtime_error("Invalid xml: bad attribute");
+
+				att.second.assign(m_xml_text, m_pos + 1, end - m_pos - 1);
+				m_pos = end + 1;
+			}
+
+			atts.resize(count);
 		}
+
 		std::string m_xml_text;
+		size_t m_pos;
 		bool m_is_open;
-		bool m_is_end;
-		bool m_self_closing;
-		std::stack<Node> m_nodes; //stored previously opened but not closed nodes
 	};
 
+	// Parses "x, y, z, w" (or single value) float params once on import
+	void ParseTypedValue(Param& param)
+	{
+		if (param.type == "float4" || param.type == "float")
+		{
+			const char* str = param.value.c_str();
+			for (int i = 0; i < 4 && *str; i++)
+			{
+				while (*str == ',' || isspace((unsigned char)*str))
+					str++;
+
+				char* end = nullptr;
+				float value = strtof(str, &end);
+				if (end == str)
+					break;
+
+				param.floatValue[i] = value;
+				str = end;
+			}
+		}
+		else if (param.type == "uint")
+		{
+			param.uintValue = (unsigned int) strtoul(param.value.c_str(), nullptr, 10);
+		}
+	}
+
 	rpr_material_node CreateMaterial(rpr_material_system sys, const MaterialNode& node, const std::string& name)
 	{
 		rpr_material_node mat = nullptr;
@@ -629,7 +674,7 @@ void ExportMaterials(const std::string& filename, rpr_material_node* materials,
 
 bool ImportMaterials(const std::string& filename, std::map<std::string, MaterialNode> &nodes, std::string& materialName)
 {
-	XmlReader read(filename);
+	XmlStreamReader read(filename);
 	if (!read.isOpen())
 	{
 		std::cout << "Failed to open file " << filename << std::endl;
@@ -641,64 +686,58 @@ bool ImportMaterials(const std::string& filename, std::map<std::string, Material
 	bool root = true;
 	try
 	{
-		while (!read.isEnd())
+		read.parse([&](const std::string& name, const XmlStreamReader::Attributes& atts)
 		{
-			const XmlReader::Node& node = read.get();
-			if (!node.is_closing)
+			if (name == "node")
 			{
-				if (node.name == "node")
+				const std::string& node_name = XmlStreamReader::attribute(atts, "name");
+				last_node = &(nodes[node_name]);
+				last_node->name = node_name;
+				last_node->type = XmlStreamReader::attribute(atts, "type");
+				last_node->parsedObject = MObject();
+				last_node->parsed = false;
+				last_node->root = root;
+				if (root)
+					root = !root;
+				// Special handling for input textures: add 2d placement
+				if (last_node->type == "INPUT_TEXTURE")
 				{
-					auto name = read.get().atts.at("name");
-					last_node = &(nodes[name]);
-					last_node->name = name;
-					last_node->type = read.get().atts.at("type");
-					last_node->parsedObject = MObject();
-					last_node->parsed = false;
-					last_node->root = root;
-					if (root)
-						root = !root;
-					// Special handling for input textures: add 2d placement
-					if (last_node->type == "INPUT_TEXTURE")
+					auto placement = &(nodes[Place2dNodeName]);
+
+					if (placement->name.empty())
 					{
-						auto placement = &(nodes[Place2dNodeName]);
-
-						if (placement->name.empty())
-						{
-							placement->name = Place2dNodeName;
-							placement->root = false;
-							placement->type = "PLACE_2D_TEXTURE";
-							placement->parsedObject = MObject();
-							placement->parsed = false;
-						}
+						placement->name = Place2dNodeName;
+						placement->root = false;
+						placement->type = "PLACE_2D_TEXTURE";
+						placement->parsedObject = MObject();
+						placement->parsed = false;
 					}
 				}
-				else if (node.name == "param")
-				{
-					auto param_name = read.get().atts.at("name");
-					auto param_type = read.get().atts.at("type");
-					auto param_value = read.get().atts.at("value");
-					if (last_node != nullptr)
-						last_node->params[param_name] = { param_type, param_value };
-				}
-				else if (node.name == "description")
-				{
-					//TODO: handle description
-					//description = read.get().text;
-				}
-				else if (node.name == "material")
+			}
+			else if (name == "param")
+			{
+				const std::string& param_name = XmlStreamReader::attribute(atts, "name");
+				if (last_node != nullptr)
 				{
-					std::stringstream version_stream;
-					version_stream << std::hex << node.atts.at("version_rpr");
-					int version;
-					version_stream >> version;
-					if (version != kVersion)
-						std::cout << "Warning: Invalid API version. Expected " << hex << kVersion << "." << std::endl;
-
-					materialName = node.atts.at("name");
+					Param& param = last_node->params[param_name];
+					param.type = XmlStreamReader::attribute(atts, "type");
+					param.value = XmlStreamReader::attribute(atts, "value");
+					ParseTypedValue(param);
 				}
 			}
-			read.next();
-		}
+			else if (name == "description")
+			{
+				//TODO: handle description
+			}
+			else if (name == "material")
+			{
+				int version = (int) strtol(XmlStreamReader::attribute(atts, "version_rpr").c_str(), nullptr, 16);
+				if (version != kVersion)
+					std::cout << "Warning: Invalid API version. Expected " << hex << kVersion << "." << std::endl;
+
+				materialName = XmlStreamReader::attribute(atts, "name");
+			}
+		});
 	}
 	catch (const std::exception& e)
 	{
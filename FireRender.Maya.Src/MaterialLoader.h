@@ -23,6 +23,10 @@ struct Param
 {
 	std::string type;
 	std::string value;
+
+	// typed value parsed on import ("float4", "float" and "uint" params)
+	float floatValue[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	unsigned int uintValue = 0;
 };
 
 struct MaterialNode
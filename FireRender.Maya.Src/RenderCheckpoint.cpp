@@ -0,0 +1,229 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#include "RenderCheckpoint.h"
+
+#include "FireRenderAOVs.h"
+#include "Logger.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	const char CHECKPOINT_MAGIC[8] = { 'R', 'P', 'R', 'C', 'K', 'P', 'T', '2' };
+}
+
+RenderCheckpoint::RenderCheckpoint(const std::string& filePath, uint64_t sceneKey) :
+	m_filePath(filePath),
+	m_sceneKey(sceneKey),
+	m_iterations(0),
+	m_frameCount(0),
+	m_secondsSpent(0)
+{
+}
+
+RenderCheckpoint::~RenderCheckpoint()
+{
+	if (m_pendingWrite.valid())
+	{
+		m_pendingWrite.wait();
+	}
+}
+
+bool RenderCheckpoint::Load(FireRenderAOVs& aovs, unsigned int width, unsigned int height)
+{
+	std::ifstream file(std::filesystem::u8path(m_filePath), std::ios::binary);
+	if (!file)
+		return false;
+
+	Header header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		(memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) ||
+		(header.width != width) || (header.height != height) || (header.sceneKey != m_sceneKey))
+	{
+		LogPrint("Render checkpoint %s does not match the current render and is ignored", m_filePath.c_str());
+		return false;
+	}
+
+	AOVData data;
+	size_t floatCount = (size_t) width * height * 4;
+
+	for (unsigned int i = 0; i < header.aovCount; ++i)
+	{
+		unsigned int aovId = 0;
+		std::vector<float> pixels(floatCount);
+
+		if (!file.read(reinterpret_cast<char*>(&aovId), sizeof(aovId)) ||
+			!file.read(reinterpret_cast<char*>(pixels.data()), pixels.size() * sizeof(float)))
+		{
+			LogPrint("Render checkpoint %s is truncated and is ignored", m_filePath.c_str());
+			return false;
+		}
+
+		data[aovId].swap(pixels);
+	}
+
+	// pixels of AOVs missing in the checkpoint can't be merged, so the AOV set has to match exactly
+	std::set<unsigned int> aovIds = GetSavedAOVIds(aovs, floatCount);
+	bool sameAOVs = aovIds.size() == data.size();
+
+	for (auto it = aovIds.begin(); sameAOVs && it != aovIds.end(); ++it)
+	{
+		sameAOVs = data.find(*it) != data.end();
+	}
+
+	if (!sameAOVs)
+	{
+		LogPrint("Render checkpoint %s was saved with different AOVs and is ignored", m_filePath.c_str());
+		return false;
+	}
+
+	m_loadedData.swap(data);
+	m_iterations = header.iterations;
+	m_frameCount = header.frameCount;
+	m_secondsSpent = header.secondsSpent;
+
+	return true;
+}
+
+void RenderCheckpoint::Merge(FireRenderAOVs& aovs, int iterations) const
+{
+	if (m_iterations <= 0 || iterations <= m_iterations || m_loadedData.empty())
+		return;
+
+	float checkpointWeight = (float) m_iterations / iterations;
+	float renderedWeight = 1.0f - checkpointWeight;
+
+	aovs.ForEachActiveAOV([&](FireRenderAOV& aov)
+	{
+		auto it = m_loadedData.find(aov.id);
+		if (it == m_loadedData.end() || !aov.pixels)
+			return;
+
+		size_t floatCount = aov.pixels.size() / sizeof(float);
+		if (it->second.size() != floatCount)
+			return;
+
+		float* pixels = aov.pixels.data();
+		const float* checkpointPixels = it->second.data();
+
+		for (size_t i = 0; i < floatCount; ++i)
+		{
+			pixels[i] = checkpointPixels[i] * checkpointWeight + pixels[i] * renderedWeight;
+		}
+	});
+}
+
+bool RenderCheckpoint::SaveAsync(FireRenderAOVs& aovs, unsigned int width, unsigned int height, int iterations, int frameCount, int secondsSpent)
+{
+	if (m_pendingWrite.valid())
+	{
+		if (m_pendingWrite.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return false;
+
+		m_pendingWrite.get();
+	}
+
+	Header header;
+	memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+	header.width = width;
+	header.height = height;
+	header.iterations = iterations;
+	header.frameCount = frameCount;
+	header.secondsSpent = secondsSpent;
+	header.sceneKey = m_sceneKey;
+
+	// only the copy is done on the render thread, writing happens in the background
+	AOVData data;
+	size_t floatCount = (size_t) width * height * 4;
+
+	for (unsigned int aovId : GetSavedAOVIds(aovs, floatCount))
+	{
+		const float* pixels = aovs.getAOV(aovId)->pixels.data();
+		data[aovId].assign(pixels, pixels + floatCount);
+	}
+
+	header.aovCount = (unsigned int) data.size();
+
+	m_pendingWrite = std::async(std::launch::async, [filePath = m_filePath, header, data = std::move(data)]()
+	{
+		return Write(filePath, header, data);
+	});
+
+	return true;
+}
+
+std::set<unsigned int> RenderCheckpoint::GetSavedAOVIds(FireRenderAOVs& aovs, size_t floatCount)
+{
+	std::set<unsigned int> aovIds;
+
+	aovs.ForEachActiveAOV([&](FireRenderAOV& aov)
+	{
+		// deep color isn't read into pixels
+		if (aov.pixels && (aov.id != RPR_AOV_DEEP_COLOR) && (aov.pixels.size() / sizeof(float) == floatCount))
+		{
+			aovIds.insert(aov.id);
+		}
+	});
+
+	return aovIds;
+}
+
+bool RenderCheckpoint::Write(const std::string& filePath, const Header& header, const AOVData& data)
+{
+	// write into a temporary file first, so a preemption during the write keeps the previous checkpoint intact
+	std::filesystem::path path = std::filesystem::u8path(filePath);
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		for (const auto& it : data)
+		{
+			file.write(reinterpret_cast<const char*>(&it.first), sizeof(it.first));
+			file.write(reinterpret_cast<const char*>(it.second.data()), it.second.size() * sizeof(float));
+		}
+
+		if (!file)
+			return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+
+	if (error)
+	{
+		LogPrint("Unable to write render checkpoint %s: %s", filePath.c_str(), error.message().c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void RenderCheckpoint::Remove()
+{
+	if (m_pendingWrite.valid())
+	{
+		m_pendingWrite.wait();
+		m_pendingWrite = std::future<bool>();
+	}
+
+	std::error_code error;
+	std::filesystem::remove(std::filesystem::u8path(m_filePath), error);
+}
@@ -0,0 +1,83 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class FireRenderAOVs;
+
+/**
+ * Stores AOV pixels accumulated by a batch render together with the iteration
+ * count, so a preempted render can be resumed instead of started from scratch.
+ * Pixels are normalized and saved without the render stamp, so the samples
+ * rendered after resume are combined with the checkpoint weighted by the
+ * iteration counts. The scene key identifies the scene and render settings
+ * the checkpoint was rendered with.
+ */
+class RenderCheckpoint
+{
+public:
+	RenderCheckpoint(const std::string& filePath, uint64_t sceneKey);
+	~RenderCheckpoint();
+
+	/** Load the checkpoint; fails if there is none or it was saved for a different resolution, AOV set or scene key. */
+	bool Load(FireRenderAOVs& aovs, unsigned int width, unsigned int height);
+
+	/** Combine AOV pixels rendered after resume with the loaded checkpoint. */
+	void Merge(FireRenderAOVs& aovs, int iterations) const;
+
+	/** Copy AOV pixels and write them on a background thread. Skipped while the previous write is in progress. */
+	bool SaveAsync(FireRenderAOVs& aovs, unsigned int width, unsigned int height, int iterations, int frameCount, int secondsSpent);
+
+	/** Wait for the pending write and delete the checkpoint file. */
+	void Remove();
+
+	int GetIterations() const { return m_iterations; }
+	int GetFrameCount() const { return m_frameCount; }
+	int GetSecondsSpent() const { return m_secondsSpent; }
+
+private:
+	struct Header
+	{
+		char magic[8];
+		unsigned int width;
+		unsigned int height;
+		int iterations;
+		int frameCount;
+		int secondsSpent;
+		unsigned int aovCount;
+		uint64_t sceneKey;
+	};
+
+	typedef std::map<unsigned int, std::vector<float>> AOVData;
+
+	static bool Write(const std::string& filePath, const Header& header, const AOVData& data);
+
+	/** Ids of active AOVs whose pixels cover the whole frame, these are saved to the checkpoint. */
+	static std::set<unsigned int> GetSavedAOVIds(FireRenderAOVs& aovs, size_t floatCount);
+
+	std::string m_filePath;
+	uint64_t m_sceneKey;
+
+	AOVData m_loadedData;
+	int m_iterations;
+	int m_frameCount;
+	int m_secondsSpent;
+
+	std::future<bool> m_pendingWrite;
+};
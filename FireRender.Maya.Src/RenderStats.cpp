@@ -0,0 +1,362 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifdef WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+std::atomic<bool> RenderStats::s_recording(false);
+std::mutex RenderStats::s_mutex;
+
+std::string RenderStats::s_outputFolder;
+int RenderStats::s_frame = 0;
+std::string RenderStats::s_frameName;
+RenderStats::Clock::time_point RenderStats::s_frameStart;
+
+std::vector<RenderStats::Event> RenderStats::s_events;
+std::map<std::string, long long> RenderStats::s_counts;
+std::map<std::string, long long> RenderStats::s_highWater;
+std::map<std::thread::id, int> RenderStats::s_threadIndices;
+
+namespace
+{
+	std::string EscapeJson(const std::string& str)
+	{
+		std::string result;
+		result.reserve(str.size());
+
+		for (char c : str)
+		{
+			if (c == '"' || c == '\\')
+			{
+				result += '\\';
+				result += c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20)
+			{
+				result += ' ';
+			}
+			else
+			{
+				result += c;
+			}
+		}
+
+		return result;
+	}
+
+	// quoted csv field, quotes inside are doubled
+	std::string QuoteCsv(const std::string& str)
+	{
+		std::string result = "\"";
+		result.reserve(str.size() + 2);
+
+		for (char c : str)
+		{
+			if (c == '"')
+			{
+				result += '"';
+			}
+
+			result += c;
+		}
+
+		result += '"';
+
+		return result;
+	}
+
+	std::filesystem::path MakeOutputPath(const std::string& folder, const std::string& fileName)
+	{
+		return std::filesystem::u8path(folder) / std::filesystem::u8path(fileName);
+	}
+}
+
+void RenderStats::SetOutputFolder(const std::string& folder)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	s_outputFolder = folder;
+
+	if (folder.empty())
+	{
+		s_recording = false;
+	}
+}
+
+bool RenderStats::IsEnabled()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	return !s_outputFolder.empty();
+}
+
+void RenderStats::BeginFrame(int frame, const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	if (s_outputFolder.empty())
+	{
+		return;
+	}
+
+	s_frame = frame;
+	s_frameName = name;
+	s_frameStart = Clock::now();
+
+	s_events.clear();
+	s_counts.clear();
+	s_highWater.clear();
+	s_threadIndices.clear();
+
+	s_recording = true;
+}
+
+void RenderStats::EndFrame()
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	UpdateHighWater("Process peak memory MB", GetPeakProcessMemory() >> 20);
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	s_recording = false;
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::u8path(s_outputFolder), error);
+
+	std::ostringstream baseName;
+	baseName << s_frameName << "." << std::setw(4) << std::setfill('0') << s_frame;
+
+	WriteTrace(baseName.str() + ".trace.json");
+	WriteSummary(baseName.str() + ".stats.txt", "render_stats.csv");
+
+	s_events.clear();
+}
+
+void RenderStats::AddEvent(const char* category, const std::string& name, Clock::time_point start, Clock::time_point end)
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	auto threadIt = s_threadIndices.emplace(std::this_thread::get_id(), int(s_threadIndices.size())).first;
+
+	Event event;
+	event.category = category;
+	event.name = name;
+	event.startUs = std::chrono::duration_cast<std::chrono::microseconds>(start - s_frameStart).count();
+	event.durationUs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	event.threadIndex = threadIt->second;
+
+	s_events.push_back(std::move(event));
+}
+
+void RenderStats::AddCount(const std::string& name, long long value)
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	s_counts[name] += value;
+}
+
+void RenderStats::UpdateHighWater(const std::string& name, long long value)
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	long long& current = s_highWater[name];
+	current = std::max(current, value);
+}
+
+void RenderStats::WriteTrace(const std::string& fileName)
+{
+	std::ofstream file(MakeOutputPath(s_outputFolder, fileName));
+
+	if (!file)
+	{
+		return;
+	}
+
+	file << "{\"traceEvents\":[\n";
+
+	bool first = true;
+	for (const Event& event : s_events)
+	{
+		file << (first ? "" : ",\n")
+			<< "{\"name\":\"" << EscapeJson(event.name) << "\",\"cat\":\"" << event.category
+			<< "\",\"ph\":\"X\",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs
+			<< ",\"pid\":1,\"tid\":" << event.threadIndex << "}";
+
+		first = false;
+	}
+
+	// counters and high-water marks are shown as counter tracks at the end of the frame
+	long long frameEndUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - s_frameStart).count();
+
+	for (const auto* values : { &s_counts, &s_highWater })
+	{
+		for (const auto& value : *values)
+		{
+			file << (first ? "" : ",\n")
+				<< "{\"name\":\"" << EscapeJson(value.first) << "\",\"ph\":\"C\",\"ts\":" << frameEndUs
+				<< ",\"pid\":1,\"args\":{\"value\":" << value.second << "}}";
+
+			first = false;
+		}
+	}
+
+	file << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"frame\":" << s_frame
+		<< ",\"name\":\"" << EscapeJson(s_frameName) << "\"}}\n";
+}
+
+void RenderStats::WriteSummary(const std::string& fileName, const std::string& csvFileName)
+{
+	struct PhaseTotals
+	{
+		int calls = 0;
+		long long totalUs = 0;
+		long long maxUs = 0;
+	};
+
+	std::map<std::pair<std::string, std::string>, PhaseTotals> phases;
+
+	for (const Event& event : s_events)
+	{
+		PhaseTotals& totals = phases[std::make_pair(std::string(event.category), event.name)];
+		totals.calls++;
+		totals.totalUs += event.durationUs;
+		totals.maxUs = std::max(totals.maxUs, event.durationUs);
+	}
+
+	std::ofstream file(MakeOutputPath(s_outputFolder, fileName));
+
+	if (file)
+	{
+		file << "Frame " << s_frame << " (" << s_frameName << ")\n\n";
+		file << std::left << std::setw(12) << "Category" << std::setw(40) << "Phase"
+			<< std::right << std::setw(10) << "Calls" << std::setw(14) << "Total ms" << std::setw(14) << "Max ms" << "\n";
+
+		file << std::fixed << std::setprecision(2);
+
+		for (const auto& phase : phases)
+		{
+			file << std::left << std::setw(12) << phase.first.first << std::setw(40) << phase.first.second
+				<< std::right << std::setw(10) << phase.second.calls
+				<< std::setw(14) << phase.second.totalUs / 1000.0
+				<< std::setw(14) << phase.second.maxUs / 1000.0 << "\n";
+		}
+
+		file << "\n";
+
+		for (const auto& count : s_counts)
+		{
+			file << std::left << std::setw(52) << count.first << std::right << std::setw(10) << count.second << "\n";
+		}
+
+		for (const auto& highWater : s_highWater)
+		{
+			file << std::left << std::setw(52) << highWater.first << std::right << std::setw(10) << highWater.second << "\n";
+		}
+	}
+
+	// one row per phase / value, so stats of all frames can be loaded as a single table
+	std::filesystem::path csvPath = MakeOutputPath(s_outputFolder, csvFileName);
+
+	std::error_code error;
+	bool writeHeader = !std::filesystem::exists(csvPath, error);
+
+	std::ofstream csv(csvPath, std::ios::app);
+
+	if (!csv)
+	{
+		return;
+	}
+
+	if (writeHeader)
+	{
+		csv << "name,frame,category,item,calls,total_ms,max_ms,value\n";
+	}
+
+	csv << std::fixed << std::setprecision(3);
+
+	// frame name comes from the output file name, so it can contain commas and quotes
+	std::string frameName = QuoteCsv(s_frameName);
+
+	for (const auto& phase : phases)
+	{
+		csv << frameName << "," << s_frame << "," << phase.first.first << "," << QuoteCsv(phase.first.second) << ","
+			<< phase.second.calls << "," << phase.second.totalUs / 1000.0 << "," << phase.second.maxUs / 1000.0 << ",\n";
+	}
+
+	for (const auto& count : s_counts)
+	{
+		csv << frameName << "," << s_frame << ",count," << QuoteCsv(count.first) << ",,,," << count.second << "\n";
+	}
+
+	for (const auto& highWater : s_highWater)
+	{
+		csv << frameName << "," << s_frame << ",memory," << QuoteCsv(highWater.first) << ",,,," << highWater.second << "\n";
+	}
+}
+
+long long RenderStats::GetPeakProcessMemory()
+{
+#ifdef WIN32
+	PROCESS_MEMORY_COUNTERS counters = {};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return (long long)counters.PeakWorkingSetSize;
+	}
+
+	return 0;
+#else
+	struct rusage usage = {};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0;
+	}
+
+#ifdef __APPLE__
+	return (long long)usage.ru_maxrss;
+#else
+	// kilobytes on linux
+	return (long long)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
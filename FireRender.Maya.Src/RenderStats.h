@@ -0,0 +1,101 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Collects per-phase timings, counts and memory high-water marks of a render
+ * frame. On frame end they are written as Chrome trace JSON (chrome://tracing,
+ * Perfetto) and as a summary table, and appended to a csv file shared by all frames.
+ * Nothing is recorded outside of BeginFrame / EndFrame or while stats are disabled,
+ * so instrumented code only pays for an atomic flag check.
+ */
+class RenderStats
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	/** Write stats of the following frames into the folder; an empty path disables stats. */
+	static void SetOutputFolder(const std::string& folder);
+	static bool IsEnabled();
+
+	/** True between BeginFrame and EndFrame while stats are enabled. */
+	static bool IsRecording() { return s_recording.load(std::memory_order_relaxed); }
+
+	static void BeginFrame(int frame, const std::string& name);
+	static void EndFrame();
+
+	static void AddEvent(const char* category, const std::string& name, Clock::time_point start, Clock::time_point end);
+	static void AddCount(const std::string& name, long long value = 1);
+	static void UpdateHighWater(const std::string& name, long long value);
+
+	/** Records the time from construction to destruction as an event. */
+	class Scope
+	{
+	public:
+		Scope(const char* category, const char* name) :
+			m_category(category),
+			m_name(name),
+			m_active(IsRecording())
+		{
+			if (m_active)
+				m_start = Clock::now();
+		}
+
+		~Scope()
+		{
+			if (m_active)
+				AddEvent(m_category, m_name, m_start, Clock::now());
+		}
+
+	private:
+		const char* m_category;
+		const char* m_name;
+		bool m_active;
+		Clock::time_point m_start;
+	};
+
+private:
+	struct Event
+	{
+		const char* category;
+		std::string name;
+		long long startUs;
+		long long durationUs;
+		int threadIndex;
+	};
+
+	static void WriteTrace(const std::string& path);
+	static void WriteSummary(const std::string& path, const std::string& csvPath);
+	static long long GetPeakProcessMemory();
+
+	static std::atomic<bool> s_recording;
+	static std::mutex s_mutex;
+
+	static std::string s_outputFolder;
+	static int s_frame;
+	static std::string s_frameName;
+	static Clock::time_point s_frameStart;
+
+	static std::vector<Event> s_events;
+	static std::map<std::string, long long> s_counts;
+	static std::map<std::string, long long> s_highWater;
+	static std::map<std::thread::id, int> s_threadIndices;
+};
@@ -15,26 +15,120 @@ limitations under the License.
 #include "SunPosition/SPA.h"
 #include "FireRenderMath.h"
 #include "frWrap.h" // just for SkyBuilder::updateImage
+#include "FireRenderThread.h"
+#include <maya/MGlobal.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MDGContext.h>
+#include <maya/MDGContextGuard.h>
 #include <vector>
+#include <list>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
 #include <stdio.h>
 #include <cstring>
 
+/** A generated sky image. */
+struct SkyImage
+{
+	unsigned int width;
+	unsigned int height;
+	std::vector<SkyRgbFloat32> pixels;
+	MColor sunLightColor;
+};
+
+namespace
+{
+	// Recently generated sky images, so returning to previous settings does not generate the sky again
+	const size_t SkyImageCacheBudget = 64 * 1024 * 1024;
+
+	// Resolution of the interactive preview relative to the full image
+	const unsigned int PreviewResolutionDivider = 4;
+
+	// Number of precomputed frame images generated ahead of the render
+	const size_t FrameSkiesAhead = 3;
+
+	typedef std::pair<std::vector<float>, std::shared_ptr<const SkyImage>> SkyImageCacheEntry;
+
+	std::mutex skyImageCacheMutex;
+	std::list<SkyImageCacheEntry> skyImageCache; // most recently used first
+
+	std::shared_ptr<const SkyImage> findCachedSkyImage(const std::vector<float>& key)
+	{
+		std::lock_guard<std::mutex> lock(skyImageCacheMutex);
+
+		for (auto it = skyImageCache.begin(); it != skyImageCache.end(); ++it)
+		{
+			if (it->first == key)
+			{
+				skyImageCache.splice(skyImageCache.begin(), skyImageCache, it);
+				return it->second;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void storeCachedSkyImage(const std::vector<float>& key, std::shared_ptr<const SkyImage> image)
+	{
+		std::lock_guard<std::mutex> lock(skyImageCacheMutex);
+
+		skyImageCache.remove_if([&key](const SkyImageCacheEntry& entry) { return entry.first == key; });
+		skyImageCache.emplace_front(key, image);
+
+		size_t size = 0;
+		for (auto it = skyImageCache.begin(); it != skyImageCache.end(); )
+		{
+			size_t imageSize = it->second->pixels.size() * sizeof(SkyRgbFloat32);
+
+			// the most recent image is kept whatever its size
+			if (size + imageSize > SkyImageCacheBudget && it != skyImageCache.begin())
+			{
+				it = skyImageCache.erase(it);
+			}
+			else
+			{
+				size += imageSize;
+				++it;
+			}
+		}
+	}
+
+	std::shared_ptr<const SkyImage> generateSkyImage(SkyGen sg, unsigned int width, unsigned int height)
+	{
+		auto image = std::make_shared<SkyImage>();
+		image->width = width;
+		image->height = height;
+		image->pixels.resize(width * height);
+
+		sg.generate(width, height, image->pixels.data());
+
+		SkyColor c = sg.computeColor(sg.sun_direction);
+		image->sunLightColor = c.asColor();
+
+		return image;
+	}
+}
+
 // Life Cycle
 // -----------------------------------------------------------------------------
 SkyBuilder::SkyBuilder(const MObject& object, unsigned int imageWidth, unsigned int imageHeight) :
 	m_attributes(object),
+	m_node(object),
+	m_progressive(false),
 	m_imageWidth(imageWidth),
 	m_imageHeight(imageHeight),
-	m_imageBuffer()
+	m_image(),
+	m_nextFrameSky(0)
 {
 }
 
 // -----------------------------------------------------------------------------
 SkyBuilder::~SkyBuilder()
 {
-	// Delete the image buffer if required.
-	if (m_imageBuffer)
-		m_imageBuffer.reset();
+	// Wait for the background generation if required.
+	if (m_pendingImage.valid())
+		m_pendingImage.wait();
 }
 
 
@@ -59,15 +153,16 @@ void SkyBuilder::updateImage(frw::Context& context, frw::Image& image)
 
 	// Update the RPR image.
 	rpr_image_desc imgDesc = {};
-	imgDesc.image_width = m_imageWidth;
-	imgDesc.image_height = m_imageHeight;
-	image = frw::Image(context, { 3, RPR_COMPONENT_TYPE_FLOAT32 }, imgDesc, m_imageBuffer.get());
+	imgDesc.image_width = m_image->width;
+	imgDesc.image_height = m_image->height;
+	image = frw::Image(context, { 3, RPR_COMPONENT_TYPE_FLOAT32 }, imgDesc, m_image->pixels.data());
 }
 
 // -----------------------------------------------------------------------------
 void SkyBuilder::updateSampleImage(MImage& image)
 {
-	// Create the image.
+	// Create the image, sample images are always generated at full resolution.
+	m_progressive = false;
 	createSkyImage();
 
 	// Covert the image to 1 byte per channel.
@@ -87,7 +182,7 @@ void SkyBuilder::updateSampleImage(MImage& image)
 			// Flip the image horizontally using "-offset" so the sun moves in the correct direction.
 			// Source pointer: use (x,y) and apply offset to x
 			unsigned int i = s + (x - offset) % m_imageWidth;
-			const SkyRgbFloat32& src = m_imageBuffer.get()[i];
+			const SkyRgbFloat32& src = m_image->pixels[i];
 
 			*dst++ = static_cast<unsigned int>(fminf(src.b * scale, 255));
 			*dst++ = static_cast<unsigned int>(fminf(src.g * scale, 255));
@@ -100,6 +195,58 @@ void SkyBuilder::updateSampleImage(MImage& image)
 	image.setPixels(bytes.data(), m_imageWidth, m_imageHeight);
 }
 
+// -----------------------------------------------------------------------------
+void SkyBuilder::setProgressive(bool progressive)
+{
+	m_progressive = progressive;
+}
+
+// -----------------------------------------------------------------------------
+bool SkyBuilder::isPreview() const
+{
+	return m_image && (m_image->width != m_imageWidth || m_image->height != m_imageHeight);
+}
+
+// -----------------------------------------------------------------------------
+void SkyBuilder::precomputeFrames(const std::vector<MTime>& times)
+{
+	m_frameImages.clear();
+	m_frameSkies.clear();
+	m_nextFrameSky = 0;
+
+	if (!m_node.isValid())
+		return;
+
+	// Read the sky at each frame. This only evaluates the sky node, the images are generated later.
+	for (const MTime& time : times)
+	{
+		MDGContext dgContext(time);
+		MDGContextGuard contextGuard(dgContext);
+
+		SkyBuilder frameBuilder(m_node.object(), m_imageWidth, m_imageHeight);
+		frameBuilder.refresh();
+
+		std::vector<float> key = frameBuilder.getImageKey(m_imageWidth, m_imageHeight);
+
+		// Consecutive frames with the same sky share the image.
+		if (!m_frameSkies.empty() && m_frameSkies.back().first == key)
+			continue;
+
+		auto sg = std::make_shared<SkyGen>();
+		frameBuilder.setupSkyGen(*sg);
+		m_frameSkies.emplace_back(key, sg);
+	}
+
+	// A sky which is not animated is generated once by the first frame.
+	if (m_frameSkies.size() < 2)
+	{
+		m_frameSkies.clear();
+		return;
+	}
+
+	launchFrameSkies();
+}
+
 // -----------------------------------------------------------------------------
 MColor& SkyBuilder::getSunLightColor()
 {
@@ -244,12 +391,52 @@ void SkyBuilder::adjustDaylightSavingTime(int& hours, int& day, int& month, int&
 // -----------------------------------------------------------------------------
 void SkyBuilder::createSkyImage()
 {
-	// Create the image buffer if necessary.
-	if (!m_imageBuffer)
-		m_imageBuffer = std::make_unique<SkyRgbFloat32[]>(m_imageWidth * m_imageHeight);
+	std::vector<float> key = getImageKey(m_imageWidth, m_imageHeight);
+
+	// Use the cached or precomputed image if the sky has been generated with the same settings.
+	m_image = findCachedSkyImage(key);
+
+	// The precomputed image is taken on a cache hit as well, so its slot is freed for the next frames.
+	std::shared_ptr<const SkyImage> frameImage = takeFrameSkyImage(key);
+	if (!m_image)
+		m_image = frameImage;
+
+	if (!m_image)
+	{
+		// Initialize the sky generator.
+		SkyGen sg;
+		setupSkyGen(sg);
+
+		if (m_progressive)
+		{
+			// Show a low resolution sky until the full one is ready.
+			unsigned int width = std::max(1u, m_imageWidth / PreviewResolutionDivider);
+			unsigned int height = std::max(1u, m_imageHeight / PreviewResolutionDivider);
+			std::vector<float> previewKey = getImageKey(width, height);
+
+			m_image = findCachedSkyImage(previewKey);
+			if (!m_image)
+			{
+				m_image = generateSkyImage(sg, width, height);
+				storeCachedSkyImage(previewKey, m_image);
+			}
+
+			startFullImageGeneration(sg, key);
+		}
+		else
+		{
+			// Generate the image.
+			m_image = generateSkyImage(sg, m_imageWidth, m_imageHeight);
+			storeCachedSkyImage(key, m_image);
+		}
+	}
+
+	m_sunLightColor = m_image->sunLightColor;
+}
 
-	// Initialize the sky generator.
-	SkyGen sg;
+// -----------------------------------------------------------------------------
+void SkyBuilder::setupSkyGen(SkyGen& sg) const
+{
 	sg.saturation = m_attributes.saturation;
 #ifdef USE_DIRECTIONAL_SKY_LIGHT
 	sg.mSunIntensity = 0.01f;
@@ -265,12 +452,103 @@ void SkyBuilder::createSkyImage()
 	sg.filter_color = m_attributes.filterColor;
 	sg.sun_direction = m_sunDirection;
 	sg.haze = 1.f + m_attributes.turbidity * (9.0f / 50.0f);
+}
+
+// -----------------------------------------------------------------------------
+std::vector<float> SkyBuilder::getImageKey(unsigned int width, unsigned int height) const
+{
+	// Azimuth is not part of the key, it is applied with the environment light transform.
+	return
+	{
+		static_cast<float>(width),
+		static_cast<float>(height),
+		m_sunDirection.x,
+		m_sunDirection.y,
+		m_sunDirection.z,
+		m_attributes.turbidity,
+		m_attributes.albedo,
+		m_attributes.saturation,
+		m_attributes.sunDiskSize,
+		m_attributes.sunGlow,
+		m_attributes.horizonHeight,
+		m_attributes.horizonBlur,
+		m_attributes.groundColor.r,
+		m_attributes.groundColor.g,
+		m_attributes.groundColor.b,
+		m_attributes.filterColor.r,
+		m_attributes.filterColor.g,
+		m_attributes.filterColor.b
+	};
+}
+
+// -----------------------------------------------------------------------------
+void SkyBuilder::startFullImageGeneration(const SkyGen& sg, const std::vector<float>& key)
+{
+	// Only one image is generated at a time. When it is done the sky is
+	// refreshed and a new one is started for the latest settings if needed.
+	if (m_pendingImage.valid() &&
+		m_pendingImage.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return;
+
+	auto done = std::make_shared<std::atomic<bool>>(false);
+	unsigned int width = m_imageWidth;
+	unsigned int height = m_imageHeight;
+
+	m_pendingImage = std::async(std::launch::async, [sg, key, width, height, done]()
+	{
+		storeCachedSkyImage(key, generateSkyImage(sg, width, height));
+		*done = true;
+	});
+
+	MObjectHandle node = m_node;
+	FireRenderThread::KeepRunningOnMainThread([node, done]() -> bool
+	{
+		if (!*done)
+			return true;
+
+		// The sky is translated again and picks up the full image from the cache.
+		if (node.isValid())
+			MGlobal::executeCommandOnIdle("dgdirty " + MFnDependencyNode(node.object()).name());
+
+		return false;
+	});
+}
+
+// -----------------------------------------------------------------------------
+void SkyBuilder::launchFrameSkies()
+{
+	// Only a few frames are generated ahead so memory use does not grow with the frame range.
+	while (m_nextFrameSky < m_frameSkies.size() && m_frameImages.size() < FrameSkiesAhead)
+	{
+		const auto& frameSky = m_frameSkies[m_nextFrameSky++];
+
+		if (m_frameImages.find(frameSky.first) != m_frameImages.end() || findCachedSkyImage(frameSky.first))
+			continue;
+
+		std::shared_ptr<SkyGen> sg = frameSky.second;
+		unsigned int width = m_imageWidth;
+		unsigned int height = m_imageHeight;
+
+		m_frameImages[frameSky.first] = std::async(std::launch::async, [sg, width, height]()
+		{
+			return generateSkyImage(*sg, width, height);
+		}).share();
+	}
+}
+
+// -----------------------------------------------------------------------------
+std::shared_ptr<const SkyImage> SkyBuilder::takeFrameSkyImage(const std::vector<float>& key)
+{
+	auto it = m_frameImages.find(key);
+	if (it == m_frameImages.end())
+		return nullptr;
+
+	std::shared_ptr<const SkyImage> image = it->second.get();
+	m_frameImages.erase(it);
 
+	storeCachedSkyImage(key, image);
 
-	// Generate the image.
-	memset(m_imageBuffer.get(), 0, sizeof(SkyRgbFloat32) * m_imageWidth * m_imageHeight);
-	sg.generate(m_imageWidth, m_imageHeight, m_imageBuffer.get());
+	launchFrameSkies();
 
-	SkyColor c = sg.computeColor(sg.sun_direction);
-	m_sunLightColor = c.asColor();
+	return image;
 }
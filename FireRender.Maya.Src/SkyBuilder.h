@@ -13,10 +13,15 @@ limitations under the License.
 #pragma once
 
 #include "maya/MObject.h"
+#include "maya/MObjectHandle.h"
 #include "maya/MImage.h"
+#include "maya/MTime.h"
 #include "SkyAttributes.h"
 #include <maya/MFloatVector.h>
 #include <memory>
+#include <future>
+#include <vector>
+#include <map>
 
 // The following define will activate code which uses directional light as primary light
 // source for sky. It is obsolete code and should be considered for removal later.
@@ -30,6 +35,8 @@ namespace frw
 }
 
 struct SkyRgbFloat32;
+struct SkyImage;
+class SkyGen;
 
 /**
  * The sky builder uses the sky dependency node as input
@@ -64,6 +71,15 @@ public:
 	/** Update a Maya sample image with the sky. */
 	void updateSampleImage(MImage& image);
 
+	/** Show a low resolution sky first while the full one is generated in background. */
+	void setProgressive(bool progressive);
+
+	/** Return true if the current image is a low resolution preview. */
+	bool isPreview() const;
+
+	/** Generate the sky images of an animated sky for the given frames ahead of the render. */
+	void precomputeFrames(const std::vector<MTime>& times);
+
 	/** Get the sun light color. */
 	MColor& getSunLightColor();
 
@@ -87,6 +103,12 @@ private:
 	/** Sky attributes. */
 	SkyAttributes m_attributes;
 
+	/** The sky node. */
+	MObjectHandle m_node;
+
+	/** Low resolution first generation. */
+	bool m_progressive;
+
 
 	/** Sun azimuth in radians. */
 	float m_sunAzimuth;
@@ -107,8 +129,20 @@ private:
 	/** Sky image height. */
 	const unsigned int m_imageHeight;
 
-	/** Storage space for the sky image. */
-	std::unique_ptr<SkyRgbFloat32[]> m_imageBuffer;
+	/** The sky image, shared with the sky image cache. */
+	std::shared_ptr<const SkyImage> m_image;
+
+	/** Full resolution image being generated in background. */
+	std::future<void> m_pendingImage;
+
+	/** Sky image keys and generators of the precomputed frames, in frame order. */
+	std::vector<std::pair<std::vector<float>, std::shared_ptr<SkyGen>>> m_frameSkies;
+
+	/** Index of the next precomputed frame to generate. */
+	size_t m_nextFrameSky;
+
+	/** Precomputed frame images being generated or waiting to be used. */
+	std::map<std::vector<float>, std::shared_future<std::shared_ptr<const SkyImage>>> m_frameImages;
 
 	// Private Methods
 	// -----------------------------------------------------------------------------
@@ -124,4 +158,19 @@ private:
 
 	/** Create the sky sphere map. */
 	void createSkyImage();
+
+	/** Set up the sky generator from the attributes. */
+	void setupSkyGen(SkyGen& sg) const;
+
+	/** Get the key of the sky image in the cache. */
+	std::vector<float> getImageKey(unsigned int width, unsigned int height) const;
+
+	/** Generate the full resolution image in background and refresh the sky when it is done. */
+	void startFullImageGeneration(const SkyGen& sg, const std::vector<float>& key);
+
+	/** Start generating the next precomputed frames. */
+	void launchFrameSkies();
+
+	/** Take the precomputed image with the given key, waiting for it if required. */
+	std::shared_ptr<const SkyImage> takeFrameSkyImage(const std::vector<float>& key);
 };
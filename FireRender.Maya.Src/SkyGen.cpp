@@ -57,25 +57,49 @@ void SkyGen::generate(int w, int h, SkyRgbFloat32 *buffer)
     }
     sun_glow_intensity_adjusted = lerp(glowMinValue, 100.0f, (float)sun_glow_intensity / 100.0f);
 
+    // Terms which are constant for the whole image are evaluated once.
+    Point3 sun_dir = sun_direction;
+    sun_dir = sun_dir.Normalize();
+    vectortweak(sun_dir, y_is_up, horizon_height / 10.0);
+    Scalar local_haze = 2.0 + haze;
+    if (local_haze < 2.0)
+    {
+        local_haze = 2.0;
+    }
+    constants = make_constants(sun_dir, local_haze);
+
+    // Fill the cached sun color and irradiance before the parallel loop reads them.
+    computeColor(Point3(0.0f, 0.0f, -1.0f));
+
     float nw = 1.0f / float(w);
     float nh = 1.0f / float(h);
 
     bool canMirrorSky = (fabs(sun_direction.y) < 0.00001f);
     int w2 = canMirrorSky ? (w + 1) / 2 : w; // divide by 2 with rounding up
 
+    // Azimuth terms are shared by all rows.
+    std::vector<float> cosTheta(w2);
+    std::vector<float> sinTheta(w2);
+    for (int j = 0; j < w2; j++)
+    {
+        float theta = float(2.0f * PI * j * nw);
+        cosTheta[j] = cos(theta);
+        sinTheta[j] = sin(theta);
+    }
+
 #pragma omp parallel for
     for (int i = 0; i < h; i++)
     {
         float phi = float(PI * i * nh);
+        float sinphi = sin(phi);
+        float cosphi = cos(phi);
         int ii = h - i - 1;
         for (int j = 0; j < w2; j++)
         {
-            float theta = float(2.0f * PI * j * nw);
-            float sinphi = sin(phi);
             Point3 dir(
-                cos(theta) * sinphi, // *radius,
-                sin(theta) * sinphi, // *radius,
-                -cos(phi) // *radius
+                cosTheta[j] * sinphi, // *radius,
+                sinTheta[j] * sinphi, // *radius,
+                -cosphi // *radius
             );
             SkyColor pix = computeColor(dir);
 
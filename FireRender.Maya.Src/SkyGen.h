@@ -291,45 +291,14 @@ private:
 		xyz2dir(inout_refl_dir, in_normal, x, y, z);
 	}
 
-	Scalar sky_luminance(const Point3& in_dir, const Point3& in_sun_pos, const Scalar& in_turbidity)
-	{
-		Scalar cos_gamma = DotProd(in_sun_pos, in_dir);
-		if (cos_gamma < 0.0)
-		{
-			cos_gamma = 0.0;
-		}
-		if (cos_gamma > 1.0)
-		{
-			cos_gamma = 2.0 - cos_gamma;
-		}
-		Scalar gamma = acos(cos_gamma);
-		Scalar cos_theta = in_dir.z;
-		Scalar cos_theta_sun = in_sun_pos.z;
-		Scalar theta_sun = acos(cos_theta_sun);
-
-		Scalar A = 0.178721 * in_turbidity - 1.463037;
-		Scalar B = -0.355402 * in_turbidity + 0.427494;
-		Scalar C = -0.022669 * in_turbidity + 5.325056;
-		Scalar D = 0.120647 * in_turbidity - 2.577052;
-		Scalar E = -0.066967 * in_turbidity + 0.370275;
-
-		Scalar Y = (((1 + A * exp(B / cos_theta)) * (1 + C * exp(D * gamma) +
-			E * cos_gamma * cos_gamma)) /
-			((1 + A * exp(B / 1.0)) * (1 + C * exp(D * theta_sun) +
-				E * cos_theta_sun * cos_theta_sun)));
-		return Y;
-	}
-
 	SkyColor calc_sun_color(const Point3& sun_dir, const Scalar& turbidity)
 	{
 		// Note: this function depends on sun_dir.z and turbidity, which are constants during image generation
 		// Simple optimization: cache value.
-		static Point3 cached_sun_dir(0, 0, 0);
-		static Scalar cached_turbidity = -1;
-		static SkyColor cached_result(0, 0, 0);
-		if (sun_dir == cached_sun_dir && turbidity == cached_turbidity)
+		// The cache is per instance so several skies can be generated at the same time.
+		if (sun_dir == sun_color_cache.sun_dir && turbidity == sun_color_cache.turbidity)
 		{
-			return cached_result;
+			return sun_color_cache.result;
 		}
 
 		SkyColor sun_color = SkyColor(0.0, 0.0, 0.0);
@@ -365,9 +334,9 @@ private:
 		}
 
 		// cache result
-		cached_sun_dir = sun_dir;
-		cached_turbidity = turbidity;
-		cached_result = sun_color;
+		sun_color_cache.sun_dir = sun_dir;
+		sun_color_cache.turbidity = turbidity;
+		sun_color_cache.result = sun_color;
 
 		return sun_color;
 	}
@@ -387,75 +356,153 @@ private:
 		}
 	}
 
-	Point3 sky_color_xyz(const Point3& in_dir, const Point3& in_sun_pos, const Scalar& in_turbidity, const Scalar& in_luminance)
+	// Perez distribution coefficients with the denominator evaluated for the current sun
+	struct PerezTerms
 	{
-		Point3 xyz;
 		Scalar A, B, C, D, E;
-		Scalar cos_gamma = DotProd(in_sun_pos, in_dir);
-		if (cos_gamma > 1.0)
+		Scalar denominator;
+	};
+
+	// Terms which depend only on sun direction and turbidity, constant during image generation
+	struct SkyConstants
+	{
+		Point3 sun_dir = Point3(0, 0, 0);
+		Scalar turbidity = -1;
+		Scalar zenith_luminance = 0;
+		Scalar zenith_x = 0;
+		Scalar zenith_y = 0;
+		PerezTerms Y, x, y;
+
+		bool matches(const Point3& in_sun_dir, const Scalar& in_turbidity) const
 		{
-			cos_gamma = 2.0 - cos_gamma;
+			return sun_dir == in_sun_dir && turbidity == in_turbidity;
 		}
-		Scalar gamma = acos(cos_gamma);
-		Scalar cos_theta = in_dir.z;
-		Scalar cos_theta_sun = in_sun_pos.z;
+	};
+
+	SkyConstants constants;
+
+	// Last result of a function of sun direction and turbidity
+	struct ColorCache
+	{
+		Point3 sun_dir = Point3(0, 0, 0);
+		Scalar turbidity = -1;
+		SkyColor result = SkyColor(0, 0, 0);
+	};
+
+	ColorCache sun_color_cache;
+	ColorCache irrad_cache;
+
+	PerezTerms make_perez_terms(Scalar A, Scalar B, Scalar C, Scalar D, Scalar E, const Scalar& theta_sun, const Scalar& cos_theta_sun)
+	{
+		PerezTerms terms = { A, B, C, D, E, 0 };
+		terms.denominator = (1 + A * exp(B / 1.0)) * (1 + C * exp(D * theta_sun) + E * cos_theta_sun * cos_theta_sun);
+		return terms;
+	}
+
+	Scalar perez(const PerezTerms& terms, const Scalar& cos_theta, const Scalar& gamma, const Scalar& cos_gamma) const
+	{
+		return ((1 + terms.A * exp(terms.B / cos_theta)) * (1 + terms.C * exp(terms.D * gamma) +
+			terms.E * cos_gamma * cos_gamma)) / terms.denominator;
+	}
+
+	SkyConstants make_constants(const Point3& in_sun_dir, const Scalar& in_turbidity)
+	{
+		SkyConstants k;
+		k.sun_dir = in_sun_dir;
+		k.turbidity = in_turbidity;
+
+		Scalar cos_theta_sun = in_sun_dir.z;
 		Scalar theta_sun = acos(cos_theta_sun);
+
+		// start with absolute value of zenith luminace in K cd/m2
+		Scalar chi = (4.0 / 9.0 - in_turbidity / 120.0) * (PI - 2 * theta_sun);
+		k.zenith_luminance = (1000.0 * (4.0453 * in_turbidity - 4.9710) * tan(chi) -
+			0.2155 * in_turbidity + 2.4192);
+
+		k.Y = make_perez_terms(
+			0.178721 * in_turbidity - 1.463037,
+			-0.355402 * in_turbidity + 0.427494,
+			-0.022669 * in_turbidity + 5.325056,
+			0.120647 * in_turbidity - 2.577052,
+			-0.066967 * in_turbidity + 0.370275,
+			theta_sun, cos_theta_sun);
+
 		Scalar t2 = in_turbidity * in_turbidity;
 		Scalar ts2 = theta_sun * theta_sun;
 		Scalar ts3 = ts2 * theta_sun;
 		// determine x and y at zenith
-		Scalar zenith_x = ((+0.001650*ts3 - 0.003742*ts2 +
+		k.zenith_x = ((+0.001650*ts3 - 0.003742*ts2 +
 			0.002088*theta_sun + 0) * t2 +
 			(-0.029028*ts3 + 0.063773*ts2 -
 				0.032020*theta_sun + 0.003948) * in_turbidity +
 				(+0.116936*ts3 - 0.211960*ts2 +
 					0.060523*theta_sun + 0.258852));
-		Scalar zenith_y = ((+0.002759*ts3 - 0.006105*ts2 +
+		k.zenith_y = ((+0.002759*ts3 - 0.006105*ts2 +
 			0.003162*theta_sun + 0) * t2 +
 			(-0.042149*ts3 + 0.089701*ts2 -
 				0.041536*theta_sun + 0.005158) * in_turbidity +
 				(+0.153467*ts3 - 0.267568*ts2 +
 					0.066698*theta_sun + 0.266881));
-		xyz.y = static_cast<float>(in_luminance);
-		A = -0.019257 * in_turbidity - (0.29 - pow(cos_theta_sun, 0.5) * 0.09);
-
-		B = -0.066513 * in_turbidity + 0.000818;
-		C = -0.000417 * in_turbidity + 0.212479;
-		D = -0.064097 * in_turbidity - 0.898875;
-		E = -0.003251 * in_turbidity + 0.045178;
-		Scalar x = (((1 + A * exp(B / cos_theta)) * (1 + C * exp(D * gamma) +
-			E * cos_gamma * cos_gamma)) /
-			((1 + A * exp(B / 1.0)) * (1 + C * exp(D * theta_sun) +
-				E * cos_theta_sun * cos_theta_sun)));
-		A = -0.016698 * in_turbidity - 0.260787;
-		B = -0.094958 * in_turbidity + 0.009213;
-		C = -0.007928 * in_turbidity + 0.210230;
-		D = -0.044050 * in_turbidity - 1.653694;
-		E = -0.010922 * in_turbidity + 0.052919;
-		Scalar y = (((1 + A * exp(B / cos_theta)) * (1 + C * exp(D * gamma) +
-			E * cos_gamma * cos_gamma)) /
-			((1 + A * exp(B / 1.0)) * (1 + C * exp(D * theta_sun) +
-				E * cos_theta_sun * cos_theta_sun)));
-		Scalar local_saturation = 1.0;
-		x = zenith_x * ((x * local_saturation) + (1.0 - local_saturation));
-		y = zenith_y * ((y * local_saturation) + (1.0 - local_saturation));
-		// convert chromaticities x and y to CIE
-		xyz.x = static_cast<float>((x / y) * xyz.y);
-		xyz.z = static_cast<float>(((1.0 - x - y) / y) * xyz.y);
-		return xyz;
+
+		k.x = make_perez_terms(
+			-0.019257 * in_turbidity - (0.29 - pow(cos_theta_sun, 0.5) * 0.09),
+			-0.066513 * in_turbidity + 0.000818,
+			-0.000417 * in_turbidity + 0.212479,
+			-0.064097 * in_turbidity - 0.898875,
+			-0.003251 * in_turbidity + 0.045178,
+			theta_sun, cos_theta_sun);
+
+		k.y = make_perez_terms(
+			-0.016698 * in_turbidity - 0.260787,
+			-0.094958 * in_turbidity + 0.009213,
+			-0.007928 * in_turbidity + 0.210230,
+			-0.044050 * in_turbidity - 1.653694,
+			-0.010922 * in_turbidity + 0.052919,
+			theta_sun, cos_theta_sun);
+
+		return k;
 	}
 
 	SkyColor calc_env_color(const Point3& in_sun_dir, const Point3& in_dir, const Scalar& in_turbidity)
 	{
+		// per-pixel calls reuse the terms prepared by generate(), other callers evaluate them locally
+		SkyConstants local;
+		const SkyConstants* k = &constants;
+		if (!constants.matches(in_sun_dir, in_turbidity))
+		{
+			local = make_constants(in_sun_dir, in_turbidity);
+			k = &local;
+		}
+
 		SkyColor env_color = SkyColor(0.0, 0.0, 0.0);
-		// start with absolute value of zenith luminace in K cd/m2
-		Scalar theta_sun = acos(in_sun_dir.z);
-		Scalar chi = (4.0 / 9.0 - in_turbidity / 120.0) * (PI - 2 * theta_sun);
-		Scalar luminance = (1000.0 * (4.0453 * in_turbidity - 4.9710) * tan(chi) -
-			0.2155 * in_turbidity + 2.4192);
-		luminance *= sky_luminance(in_dir, in_sun_dir, in_turbidity);
-		// calculate the sky colour - this uses 2 matrices (for 'x' and for 'y')
-		Point3 XYZ = sky_color_xyz(in_dir, in_sun_dir, in_turbidity, luminance);
+		Scalar cos_theta = in_dir.z;
+		Scalar dot = DotProd(in_sun_dir, in_dir);
+
+		// luminance distribution
+		Scalar cos_gamma = dot;
+		if (cos_gamma < 0.0)
+		{
+			cos_gamma = 0.0;
+		}
+		if (cos_gamma > 1.0)
+		{
+			cos_gamma = 2.0 - cos_gamma;
+		}
+		Scalar gamma = acos(cos_gamma);
+		Scalar luminance = k->zenith_luminance * perez(k->Y, cos_theta, gamma, cos_gamma);
+
+		// chromaticity distribution, the angle is not clamped at 90 degrees here
+		Scalar cos_gamma_xy = dot > 1.0 ? 2.0 - dot : dot;
+		Scalar gamma_xy = dot < 0.0 ? acos(cos_gamma_xy) : gamma;
+		Scalar x = k->zenith_x * perez(k->x, cos_theta, gamma_xy, cos_gamma_xy);
+		Scalar y = k->zenith_y * perez(k->y, cos_theta, gamma_xy, cos_gamma_xy);
+
+		// convert chromaticities x and y to CIE
+		Point3 XYZ;
+		XYZ.y = static_cast<float>(luminance);
+		XYZ.x = static_cast<float>((x / y) * XYZ.y);
+		XYZ.z = static_cast<float>(((1.0 - x - y) / y) * XYZ.y);
+
 		// use result
 		env_color.r = 3.241 * XYZ.x - 1.537 * XYZ.y - 0.499 * XYZ.z;
 		env_color.g = -0.969 * XYZ.x + 1.876 * XYZ.y + 0.042 * XYZ.z;
@@ -487,12 +534,9 @@ private:
 	SkyColor calc_irrad(const Point3& in_data_sun_dir, const Scalar& in_data_sun_dir_haze)
 	{
 		// result of this function depends on sun direction and constant - cache this value.
-		static Point3 cached_sun_dir(0, 0, 0);
-		static Scalar cached_sun_dir_haze = -1;
-		static SkyColor cached_result(0, 0, 0);
-		if (in_data_sun_dir == cached_sun_dir && in_data_sun_dir_haze == cached_sun_dir_haze)
+		if (in_data_sun_dir == irrad_cache.sun_dir && in_data_sun_dir_haze == irrad_cache.turbidity)
 		{
-			return cached_result;
+			return irrad_cache.result;
 		}
 
 		SkyColor colaccu = SkyColor(0.0, 0.0, 0.0);
@@ -517,9 +561,9 @@ private:
 		}
 		colaccu /= Scalar(si.mGen.size());
 
-		cached_sun_dir = in_data_sun_dir;
-		cached_sun_dir_haze = in_data_sun_dir_haze;
-		cached_result = colaccu;
+		irrad_cache.sun_dir = in_data_sun_dir;
+		irrad_cache.turbidity = in_data_sun_dir_haze;
+		irrad_cache.result = colaccu;
 
 		return colaccu;
 	}
@@ -11,22 +11,168 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ********************************************************************/
 #include "StartupContextChecker.h"
+#include "FireRenderThread.h"
+#include "OptionVarHelpers.h"
+#include "attributeNames.h"
+#include "common.h"
+
+#include <maya/MIntArray.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
 
 bool StartupContextChecker::m_IsMachineLearningDenoiserSupportedOnCPU = false;
 bool StartupContextChecker::m_IsRprSupported = false;
 bool StartupContextChecker::m_WasCheckedBeforeUsage = false;
+std::future<std::string> StartupContextChecker::m_MLDenoiserCheck;
+std::string StartupContextChecker::m_CacheKey;
+
+namespace
+{
+	// Cheap fingerprint of the installed GPU drivers: directories contribute modification time, files their contents
+	std::string GetDriverFingerprint()
+	{
+		std::vector<std::string> paths;
+
+#ifdef WIN32
+		const char* systemRoot = std::getenv("SystemRoot");
+		paths.push_back(std::string(systemRoot ? systemRoot : "C:\\Windows") + "\\System32\\DriverStore\\FileRepository");
+#elif defined(OSMac_)
+		paths.push_back("/System/Library/CoreServices/SystemVersion.plist");
+#else
+		paths.push_back("/sys/module/nvidia/version");
+		paths.push_back("/sys/module/amdgpu/srcversion");
+#endif
+
+		std::stringstream fingerprint;
+
+		for (const std::string& path : paths)
+		{
+			std::error_code error;
+			if (std::filesystem::is_directory(path, error))
+			{
+				auto writeTime = std::filesystem::last_write_time(path, error);
+				if (!error)
+				{
+					fingerprint << path << ":" << writeTime.time_since_epoch().count() << ";";
+				}
+			}
+			else
+			{
+				std::ifstream file(path);
+				if (file)
+				{
+					std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+					fingerprint << path << ":" << std::hash<std::string>()(content) << ";";
+				}
+			}
+		}
+
+		return fingerprint.str();
+	}
+}
+
+std::string StartupContextChecker::GetVersionKey()
+{
+	std::stringstream key;
+
+	key << PLUGIN_VERSION << ";";
+
+#ifdef RPR_VERSION_MAJOR_MINOR_REVISION
+	key << std::hex << RPR_VERSION_MAJOR_MINOR_REVISION << std::dec << ";";
+#else
+	key << std::hex << RPR_API_VERSION << std::dec << ";";
+#endif
+
+	key << GetDriverFingerprint();
+
+	return key.str();
+}
+
+std::string StartupContextChecker::GetCacheKey()
+{
+	std::stringstream key;
+
+	key << GetVersionKey() << ";";
+
+	MIntArray devicesUsing;
+	MGlobal::executeCommand(getOptionVarMelCommand("-q", FINAL_RENDER_DEVICES_USING_PARAM_NAME, ""), devicesUsing);
+	for (unsigned int i = 0; i < devicesUsing.length(); ++i)
+	{
+		key << devicesUsing[i];
+	}
+
+	key << ";" << (std::getenv("RPR_MAYA_DISABLE_GPU") ? 1 : 0);
+
+	return key.str();
+}
+
+std::string StartupContextChecker::GetCacheFilePath()
+{
+	MString userAppDir;
+	MGlobal::executeCommand("internalVar -userAppDir", userAppDir);
+
+	if (userAppDir.length() == 0)
+		return std::string();
+
+	return std::string(userAppDir.asUTF8()) + "rprStartupCheck.cache";
+}
+
+bool StartupContextChecker::LoadCachedResult()
+{
+	std::string cacheFilePath = GetCacheFilePath();
+	if (cacheFilePath.empty())
+		return false;
+
+	std::ifstream file(cacheFilePath);
+	if (!file)
+		return false;
+
+	std::string key;
+	int rprSupported = 0;
+	int mlDenoiserSupported = 0;
+
+	if (!std::getline(file, key) || (key != m_CacheKey) || !(file >> rprSupported >> mlDenoiserSupported))
+		return false;
+
+	m_IsRprSupported = rprSupported != 0;
+	m_IsMachineLearningDenoiserSupportedOnCPU = mlDenoiserSupported != 0;
+
+	return true;
+}
+
+void StartupContextChecker::SaveCachedResult()
+{
+	std::string cacheFilePath = GetCacheFilePath();
+	if (cacheFilePath.empty())
+		return;
+
+	std::ofstream file(cacheFilePath);
+	if (!file)
+		return;
+
+	file << m_CacheKey << std::endl;
+	file << (m_IsRprSupported ? 1 : 0) << " " << (m_IsMachineLearningDenoiserSupportedOnCPU ? 1 : 0) << std::endl;
+}
 
 void StartupContextChecker::CheckContexts()
 {
 	m_WasCheckedBeforeUsage = true;
 
+	// Skip probing if nothing has changed since the last successful check
+	m_CacheKey = GetCacheKey();
+	if (LoadCachedResult())
+		return;
+
 	//Check rpr context
 	rpr_int res;
-	TahoeContext rprContext;
+	auto rprContext = std::make_shared<TahoeContext>();
 	try
 	{
 		auto createFlags = FireMaya::Options::GetContextDeviceFlags();
-		rprContext.createContextEtc(createFlags, true, false, &res);
+		rprContext->createContextEtc(createFlags, true, false, &res);
 	}
 	catch (const FireRenderException & e)
 	{
@@ -48,23 +194,66 @@ void StartupContextChecker::CheckContexts()
 
 	//Check rif context
 #ifdef WIN32
-	try
+	StartMLDenoiserCheck(rprContext);
+#else
+	m_IsMachineLearningDenoiserSupportedOnCPU = true;
+	SaveCachedResult();
+#endif
+}
+
+void StartupContextChecker::StartMLDenoiserCheck(std::shared_ptr<TahoeContext> rprContext)
+{
+	MString path;
+	MStatus status = MGlobal::executeCommand("getModulePath -moduleName RadeonProRender", path);
+	std::string mlModelsFolder = (path + "/data/models").asChar();
+
+	// Loading ML models takes a while, so it doesn't block plugin loading
+	m_MLDenoiserCheck = std::async(std::launch::async, [rprContext, mlModelsFolder]() -> std::string
 	{
-		auto rifContext = std::make_unique<RifContextCPU>(rprContext.context());
-		std::unique_ptr<RifFilterWrapper> mRifFilter;
-		MString path;
-		MStatus status = MGlobal::executeCommand("getModulePath -moduleName RadeonProRender", path);
-		MString mlModelsFolder = path + "/data/models";
-		auto filter = std::make_unique<RifFilterMlColorOnly>(rifContext.get(), 512, 512, mlModelsFolder.asChar(), true);
-	}
-	catch (const std::runtime_error & e)
+		try
+		{
+			auto rifContext = std::make_unique<RifContextCPU>(rprContext->context());
+			auto filter = std::make_unique<RifFilterMlColorOnly>(rifContext.get(), 512, 512, mlModelsFolder.c_str(), true);
+		}
+		catch (const std::runtime_error & e)
+		{
+			return e.what();
+		}
+
+		return std::string();
+	});
+
+	FireRenderThread::KeepRunningOnMainThread([]() -> bool
 	{
-		MGlobal::displayWarning(e.what());
-		return;
+		// the check might be finished already by IsMLDenoiserSupportedCPU
+		if (!m_MLDenoiserCheck.valid())
+			return false;
+
+		if (m_MLDenoiserCheck.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return true;
+
+		FinishMLDenoiserCheck();
+
+		return false;
+	});
+}
+
+void StartupContextChecker::FinishMLDenoiserCheck()
+{
+	std::string error = m_MLDenoiserCheck.get();
+
+	m_IsMachineLearningDenoiserSupportedOnCPU = error.empty();
+
+	if (!m_IsMachineLearningDenoiserSupportedOnCPU)
+	{
+		MGlobal::displayWarning(error.c_str());
+		MGlobal::displayWarning("Machine learning denoiser is not supported by current CPU");
 	}
-#endif
 
-	m_IsMachineLearningDenoiserSupportedOnCPU = true;
+	SaveCachedResult();
+
+	// update UI which was set up assuming the denoiser is supported, done here so that it happens whichever path finishes the check
+	MGlobal::executeCommandOnIdle(MString("setMlDenoiserSupportedCPU(") + (m_IsMachineLearningDenoiserSupportedOnCPU ? "1" : "0") + ")");
 }
 
 bool StartupContextChecker::IsRprSupported()
@@ -76,5 +265,24 @@ bool StartupContextChecker::IsRprSupported()
 bool StartupContextChecker::IsMLDenoiserSupportedCPU()
 {
 	assert(m_WasCheckedBeforeUsage);
+
+	if (m_MLDenoiserCheck.valid())
+	{
+		FinishMLDenoiserCheck();
+	}
+
 	return m_IsMachineLearningDenoiserSupportedOnCPU;
 }
+
+bool StartupContextChecker::IsMLDenoiserCheckPending()
+{
+	return m_MLDenoiserCheck.valid();
+}
+
+void StartupContextChecker::WaitForPendingChecks()
+{
+	if (m_MLDenoiserCheck.valid())
+	{
+		m_MLDenoiserCheck.wait();
+	}
+}
@@ -14,18 +14,41 @@ limitations under the License.
 #include "Context/TahoeContext.h"
 #include <ImageFilter/ImageFilter.h>
 
+#include <future>
+#include <memory>
+#include <string>
+
 /** 
 	Used to check compatibility with RPR functions.
 	CheckContexts() should be called before accesing other methods.
 	Assuming that if any GPU has support for RPR context -> it has support for ML denoiser.
+	Results are cached in the user app directory and reused until plugin, core, driver or device settings change.
+	When probing is needed, the ML denoiser check runs on a background thread.
 */
 class StartupContextChecker
 {
 	static bool m_IsRprSupported;
 	static bool m_IsMachineLearningDenoiserSupportedOnCPU;
 	static bool m_WasCheckedBeforeUsage;
+
+	// error message of the ML denoiser check, empty on success
+	static std::future<std::string> m_MLDenoiserCheck;
+	static std::string m_CacheKey;
+
+	static std::string GetCacheKey();
+	static std::string GetCacheFilePath();
+	static bool LoadCachedResult();
+	static void SaveCachedResult();
+	static void StartMLDenoiserCheck(std::shared_ptr<TahoeContext> rprContext);
+	static void FinishMLDenoiserCheck();
+
 public:
+	// Plug-in and core versions with the GPU driver fingerprint; compiled kernels and check results are valid only while it stays the same
+	static std::string GetVersionKey();
+
 	static void CheckContexts();
 	static bool IsRprSupported();
 	static bool IsMLDenoiserSupportedCPU();
+	static bool IsMLDenoiserCheckPending();
+	static void WaitForPendingChecks();
 };
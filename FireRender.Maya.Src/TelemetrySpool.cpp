@@ -0,0 +1,617 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#include "TelemetrySpool.h"
+#include "FireRenderUtils.h"
+#include "FireRenderThread.h"
+#include "Athena/athenaWrap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+std::mutex TelemetrySpool::m_Mutex;
+std::condition_variable TelemetrySpool::m_Condition;
+std::thread TelemetrySpool::m_Thread;
+bool TelemetrySpool::m_StopRequested = false;
+std::deque<TelemetryRecord> TelemetrySpool::m_Queue;
+std::set<std::string> TelemetrySpool::m_PostedFiles;
+
+std::string TelemetrySpool::m_SpoolFolder;
+std::string TelemetrySpool::m_EndpointFolder;
+bool TelemetrySpool::m_Offline = false;
+unsigned int TelemetrySpool::m_SequenceNumber = 0;
+std::atomic<bool> TelemetrySpool::m_Enabled(true);
+
+namespace
+{
+	// oldest records are dropped when a node stays offline for long
+	const size_t MaxSpooledRecords = 256;
+
+	const char* SpoolFileExtension = ".telemetry";
+
+	std::string Escape(const std::string& str)
+	{
+		std::string result;
+		result.reserve(str.size());
+
+		for (char c : str)
+		{
+			switch (c)
+			{
+			case '\\': result += "\\\\"; break;
+			case '\t': result += "\\t"; break;
+			case '\n': result += "\\n"; break;
+			case '\r': result += "\\r"; break;
+			default: result += c;
+			}
+		}
+
+		return result;
+	}
+
+	std::string Unescape(const std::string& str)
+	{
+		std::string result;
+		result.reserve(str.size());
+
+		for (size_t i = 0; i < str.size(); ++i)
+		{
+			if (str[i] != '\\' || i + 1 == str.size())
+			{
+				result += str[i];
+				continue;
+			}
+
+			switch (str[++i])
+			{
+			case 't': result += '\t'; break;
+			case 'n': result += '\n'; break;
+			case 'r': result += '\r'; break;
+			default: result += str[i];
+			}
+		}
+
+		return result;
+	}
+
+	std::string EscapeJson(const std::string& str)
+	{
+		std::string result;
+		result.reserve(str.size());
+
+		for (char c : str)
+		{
+			if (c == '"' || c == '\\')
+			{
+				result += '\\';
+				result += c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20)
+			{
+				result += ' ';
+			}
+			else
+			{
+				result += c;
+			}
+		}
+
+		return result;
+	}
+
+	template <class T>
+	std::string ToString(const T& value)
+	{
+		std::ostringstream ss;
+		ss << value;
+		return ss.str();
+	}
+
+	template <class T>
+	T FromString(const std::string& str)
+	{
+		std::istringstream ss(str);
+		T value = T();
+		ss >> value;
+		return value;
+	}
+
+	std::vector<std::filesystem::path> ListSpoolFiles(const std::string& folder)
+	{
+		std::vector<std::filesystem::path> files;
+
+		std::error_code error;
+		for (std::filesystem::directory_iterator it(std::filesystem::u8path(folder), error), end; !error && it != end; it.increment(error))
+		{
+			if (it->path().extension() == SpoolFileExtension)
+			{
+				files.push_back(it->path());
+			}
+		}
+
+		// names start with the creation time
+		std::sort(files.begin(), files.end());
+
+		return files;
+	}
+}
+
+// -----------------------------------------------------------------------------
+void TelemetryRecord::Add(const std::string& name, const std::string& value)
+{
+	m_fields.push_back({ String, name, { value } });
+}
+
+void TelemetryRecord::Add(const std::string& name, const char* value)
+{
+	m_fields.push_back({ String, name, { value ? value : "" } });
+}
+
+void TelemetryRecord::Add(const std::string& name, bool value)
+{
+	m_fields.push_back({ Bool, name, { value ? "1" : "0" } });
+}
+
+void TelemetryRecord::Add(const std::string& name, int value)
+{
+	m_fields.push_back({ Int, name, { ToString(value) } });
+}
+
+void TelemetryRecord::Add(const std::string& name, size_t value)
+{
+	m_fields.push_back({ Size, name, { ToString(value) } });
+}
+
+void TelemetryRecord::Add(const std::string& name, long long value)
+{
+	m_fields.push_back({ LongLong, name, { ToString(value) } });
+}
+
+void TelemetryRecord::Add(const std::string& name, double value)
+{
+	std::ostringstream ss;
+	ss.precision(17);
+	ss << value;
+
+	m_fields.push_back({ Double, name, { ss.str() } });
+}
+
+void TelemetryRecord::Add(const std::string& name, const std::vector<std::string>& values)
+{
+	m_fields.push_back({ StringArray, name, values });
+}
+
+void TelemetryRecord::Add(const std::string& name, const std::vector<bool>& values)
+{
+	Field field = { BoolArray, name, {} };
+	for (bool value : values)
+		field.values.push_back(value ? "1" : "0");
+
+	m_fields.push_back(std::move(field));
+}
+
+void TelemetryRecord::Add(const std::string& name, const std::vector<unsigned int>& values)
+{
+	Field field = { UIntArray, name, {} };
+	for (unsigned int value : values)
+		field.values.push_back(ToString(value));
+
+	m_fields.push_back(std::move(field));
+}
+
+std::string TelemetryRecord::Serialize() const
+{
+	std::string result;
+
+	for (const Field& field : m_fields)
+	{
+		result += static_cast<char>(field.type);
+		result += '\t';
+		result += Escape(field.name);
+
+		for (const std::string& value : field.values)
+		{
+			result += '\t';
+			result += Escape(value);
+		}
+
+		result += '\n';
+	}
+
+	return result;
+}
+
+bool TelemetryRecord::Deserialize(const std::string& data)
+{
+	m_fields.clear();
+
+	std::istringstream stream(data);
+	std::string line;
+
+	while (std::getline(stream, line))
+	{
+		if (line.size() < 2 || line[1] != '\t')
+			return false;
+
+		std::vector<std::string> tokens;
+		size_t start = 2;
+
+		while (true)
+		{
+			size_t end = line.find('\t', start);
+			tokens.push_back(Unescape(line.substr(start, end == std::string::npos ? std::string::npos : end - start)));
+
+			if (end == std::string::npos)
+				break;
+
+			start = end + 1;
+		}
+
+		Field field;
+		field.type = static_cast<FieldType>(line[0]);
+		field.name = tokens.front();
+		field.values.assign(tokens.begin() + 1, tokens.end());
+
+		m_fields.push_back(std::move(field));
+	}
+
+	return true;
+}
+
+std::string TelemetryRecord::ToJson() const
+{
+	std::ostringstream json;
+	json << "{";
+
+	bool firstField = true;
+	for (const Field& field : m_fields)
+	{
+		json << (firstField ? "\n" : ",\n") << "\t\"" << EscapeJson(field.name) << "\": ";
+		firstField = false;
+
+		bool isArray = field.type == StringArray || field.type == BoolArray || field.type == UIntArray;
+		bool isString = field.type == String || field.type == StringArray;
+		bool isBool = field.type == Bool || field.type == BoolArray;
+
+		if (isArray)
+			json << "[";
+
+		for (size_t i = 0; i < field.values.size(); ++i)
+		{
+			if (i > 0)
+				json << ", ";
+
+			const std::string& value = field.values[i];
+
+			if (isString)
+				json << "\"" << EscapeJson(value) << "\"";
+			else if (isBool)
+				json << (value == "1" ? "true" : "false");
+			else
+				json << value;
+		}
+
+		if (isArray)
+			json << "]";
+	}
+
+	json << "\n}\n";
+
+	return json.str();
+}
+
+bool TelemetryRecord::SendToAthena() const
+{
+	AthenaWrapper* athena = AthenaWrapper::GetAthenaWrapper();
+	athena->StartNewFile();
+
+	for (const Field& field : m_fields)
+	{
+		if (field.values.empty() && field.type != StringArray && field.type != BoolArray && field.type != UIntArray)
+			continue;
+
+		switch (field.type)
+		{
+		case String:
+			athena->WriteField(field.name, field.values[0]);
+			break;
+
+		case Bool:
+			athena->WriteField(field.name, field.values[0] == "1");
+			break;
+
+		case Int:
+			athena->WriteField(field.name, FromString<int>(field.values[0]));
+			break;
+
+		case Size:
+			athena->WriteField(field.name, FromString<size_t>(field.values[0]));
+			break;
+
+		case LongLong:
+			athena->WriteField(field.name, FromString<long long>(field.values[0]));
+			break;
+
+		case Double:
+			athena->WriteField(field.name, FromString<double>(field.values[0]));
+			break;
+
+		case StringArray:
+			athena->WriteField(field.name, field.values);
+			break;
+
+		case BoolArray:
+		{
+			std::vector<bool> values;
+			for (const std::string& value : field.values)
+				values.push_back(value == "1");
+
+			athena->WriteField(field.name, values);
+			break;
+		}
+
+		case UIntArray:
+		{
+			std::vector<unsigned int> values;
+			for (const std::string& value : field.values)
+				values.push_back(FromString<unsigned int>(value));
+
+			athena->WriteField(field.name, values);
+			break;
+		}
+		}
+	}
+
+	return athena->AthenaSendFile(pythonCallWrap);
+}
+
+// -----------------------------------------------------------------------------
+void TelemetrySpool::Start(const std::string& spoolFolder)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (m_Thread.joinable())
+		return;
+
+	m_SpoolFolder = spoolFolder;
+
+	const char* endpoint = std::getenv("RPR_MAYA_TELEMETRY_ENDPOINT");
+	m_EndpointFolder = endpoint ? endpoint : "";
+
+	const char* offline = std::getenv("RPR_MAYA_TELEMETRY_OFFLINE");
+	m_Offline = offline != nullptr && offline[0] != '\0' && std::string(offline) != "0";
+
+	if (!m_SpoolFolder.empty())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::u8path(m_SpoolFolder), error);
+	}
+
+	m_StopRequested = false;
+	m_Thread = std::thread(&TelemetrySpool::ThreadProc);
+}
+
+void TelemetrySpool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_StopRequested = true;
+	}
+
+	m_Condition.notify_all();
+
+	if (m_Thread.joinable())
+		m_Thread.join();
+}
+
+void TelemetrySpool::Enqueue(TelemetryRecord record)
+{
+	if (!m_Enabled)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (!m_Thread.joinable())
+			return;
+
+		m_Queue.push_back(std::move(record));
+	}
+
+	m_Condition.notify_all();
+}
+
+void TelemetrySpool::SetEnabled(bool enabled)
+{
+	m_Enabled = enabled;
+
+	if (enabled)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Queue.clear();
+	}
+
+	if (m_SpoolFolder.empty())
+		return;
+
+	std::error_code error;
+	for (const std::filesystem::path& path : ListSpoolFiles(m_SpoolFolder))
+	{
+		std::filesystem::remove(path, error);
+	}
+}
+
+bool TelemetrySpool::IsEnabled()
+{
+	return m_Enabled;
+}
+
+void TelemetrySpool::ThreadProc()
+{
+	// records of previous sessions
+	ProcessSpool();
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	while (true)
+	{
+		m_Condition.wait(lock, [] { return m_StopRequested || !m_Queue.empty(); });
+
+		std::deque<TelemetryRecord> records;
+		records.swap(m_Queue);
+		bool stopRequested = m_StopRequested;
+
+		lock.unlock();
+
+		for (const TelemetryRecord& record : records)
+		{
+			if (!m_Enabled)
+				break;
+
+			if (!m_SpoolFolder.empty())
+				WriteToSpool(record);
+			else if (!stopRequested && !m_Offline)
+				Deliver(record, std::string());
+		}
+
+		// sending is left for the next session when the plug-in is unloaded
+		if (stopRequested)
+			return;
+
+		ProcessSpool();
+
+		lock.lock();
+	}
+}
+
+void TelemetrySpool::WriteToSpool(const TelemetryRecord& record)
+{
+	long long timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+
+	std::ostringstream fileName;
+	fileName << timestamp << "_" << m_SequenceNumber++ << SpoolFileExtension;
+
+	std::filesystem::path path = std::filesystem::u8path(m_SpoolFolder) / fileName.str();
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+
+	{
+		std::ofstream file(tempPath, std::ios::binary);
+		if (!file)
+			return;
+
+		file << record.Serialize();
+
+		if (!file)
+			return;
+	}
+
+	// incomplete records are never picked up by ProcessSpool
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+
+	std::vector<std::filesystem::path> files = ListSpoolFiles(m_SpoolFolder);
+	for (size_t i = 0; i + MaxSpooledRecords < files.size(); ++i)
+	{
+		std::filesystem::remove(files[i], error);
+	}
+}
+
+void TelemetrySpool::ProcessSpool()
+{
+	if (m_SpoolFolder.empty() || m_Offline)
+		return;
+
+	for (const std::filesystem::path& path : ListSpoolFiles(m_SpoolFolder))
+	{
+		std::string spoolFile = path.u8string();
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_StopRequested || !m_Enabled)
+				return;
+
+			// the main thread has not sent it yet
+			if (m_PostedFiles.count(spoolFile) > 0)
+				continue;
+		}
+
+		std::ifstream file(path, std::ios::binary);
+		std::stringstream data;
+		data << file.rdbuf();
+		file.close();
+
+		TelemetryRecord record;
+		bool delivered = !record.Deserialize(data.str()) || Deliver(record, spoolFile); // broken records are dropped
+
+		if (delivered)
+		{
+			std::error_code error;
+			std::filesystem::remove(path, error);
+		}
+	}
+}
+
+bool TelemetrySpool::Deliver(const TelemetryRecord& record, const std::string& spoolFile)
+{
+	if (m_EndpointFolder.empty())
+	{
+		if (!spoolFile.empty())
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_PostedFiles.insert(spoolFile);
+		}
+
+		// Athena file is written by a singleton and sent with a python call, both belong to the main thread.
+		// The record stays spooled until the send succeeds, a failed send is retried by the next ProcessSpool.
+		FireRenderThread::KeepRunningOnMainThread([record, spoolFile]() -> bool
+		{
+			if (TelemetrySpool::IsEnabled() && record.SendToAthena() && !spoolFile.empty())
+			{
+				std::error_code error;
+				std::filesystem::remove(std::filesystem::u8path(spoolFile), error);
+			}
+
+			if (!spoolFile.empty())
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_PostedFiles.erase(spoolFile);
+			}
+
+			return false;
+		});
+
+		return false;
+	}
+
+	long long timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+
+	std::error_code error;
+	std::filesystem::path endpointPath = std::filesystem::u8path(m_EndpointFolder);
+	std::filesystem::create_directories(endpointPath, error);
+
+	std::ostringstream fileName;
+	fileName << "telemetry_" << timestamp << "_" << m_SequenceNumber++ << ".json";
+
+	std::ofstream file(endpointPath / fileName.str());
+	file << record.ToJson();
+
+	return bool(file);
+}
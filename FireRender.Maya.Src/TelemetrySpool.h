@@ -0,0 +1,123 @@
+/**********************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+********************************************************************/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Telemetry fields of a single render. Field types are kept, so a record
+ * read back from the spool is sent to Athena exactly as it was written.
+ */
+class TelemetryRecord
+{
+public:
+	void Add(const std::string& name, const std::string& value);
+	void Add(const std::string& name, const char* value);
+	void Add(const std::string& name, bool value);
+	void Add(const std::string& name, int value);
+	void Add(const std::string& name, size_t value);
+	void Add(const std::string& name, long long value);
+	void Add(const std::string& name, double value);
+	void Add(const std::string& name, const std::vector<std::string>& values);
+	void Add(const std::string& name, const std::vector<bool>& values);
+	void Add(const std::string& name, const std::vector<unsigned int>& values);
+
+	/** One field per line: type, name and values separated by tabs. */
+	std::string Serialize() const;
+	bool Deserialize(const std::string& data);
+
+	std::string ToJson() const;
+
+	/** Write all fields into a new Athena file and send it. Returns false if the file was not sent. */
+	bool SendToAthena() const;
+
+private:
+	enum FieldType : char
+	{
+		String = 's',
+		Bool = 'b',
+		Int = 'i',
+		Size = 'z',
+		LongLong = 'l',
+		Double = 'd',
+		StringArray = 'S',
+		BoolArray = 'B',
+		UIntArray = 'U'
+	};
+
+	struct Field
+	{
+		FieldType type;
+		std::string name;
+		std::vector<std::string> values;
+	};
+
+	std::vector<Field> m_fields;
+};
+
+/**
+ * Keeps telemetry records in a local file queue which is processed by a background
+ * thread, so finishing a render never waits for telemetry. The Athena send itself is
+ * handed to the main thread since it ends with a Python call, and the spool file is
+ * removed there once the send succeeds. Records which can't be sent (plug-in unloaded,
+ * offline farm node) stay in the spool for the next session.
+ * Nothing is spooled or sent while telemetry is disabled with athenaEnable -ae 0.
+ *
+ * RPR_MAYA_TELEMETRY_OFFLINE=1 only spools records, and RPR_MAYA_TELEMETRY_ENDPOINT=<folder>
+ * delivers them as json files into the folder instead of Athena (local stand-in for testing).
+ */
+class TelemetrySpool
+{
+public:
+	/** Start the background thread. Records left from previous sessions are sent first. */
+	static void Start(const std::string& spoolFolder);
+
+	/** Stop the background thread. Queued records are written to the spool before it exits. */
+	static void Stop();
+
+	static void Enqueue(TelemetryRecord record);
+
+	/** Disabling drops queued records and clears the spool. */
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled();
+
+private:
+	static void ThreadProc();
+
+	static void WriteToSpool(const TelemetryRecord& record);
+	static void ProcessSpool();
+	/** Returns true if the record is delivered right away. Athena sends finish on the main thread, which removes spoolFile on success. */
+	static bool Deliver(const TelemetryRecord& record, const std::string& spoolFile);
+
+	static std::mutex m_Mutex;
+	static std::condition_variable m_Condition;
+	static std::thread m_Thread;
+	static bool m_StopRequested;
+	static std::deque<TelemetryRecord> m_Queue;
+
+	/** Spool files waiting for the main thread send, they are not posted again meanwhile. */
+	static std::set<std::string> m_PostedFiles;
+
+	static std::string m_SpoolFolder;
+	static std::string m_EndpointFolder;
+	static bool m_Offline;
+	static unsigned int m_SequenceNumber;
+	static std::atomic<bool> m_Enabled;
+};
@@ -26,8 +26,12 @@ limitations under the License.
 #include <maya/MItMeshPolygon.h>
 #include <maya/MSelectionList.h>
 #include <maya/MAnimControl.h>
+#include <maya/MColorArray.h>
+#include <maya/MDGContext.h>
+#include <maya/MDGContextGuard.h>
 
 #include <unordered_map>
+#include <cstring>
 
 #include "SingleShaderMeshTranslator.h"
 #include "MultipleShaderMeshTranslator.h"
@@ -255,6 +259,90 @@ bool FireMaya::MeshTranslator::MeshPolygonData::ReadDeformationFrame(MFnMesh& fn
 	return true;
 }
 
+bool FireMaya::MeshTranslator::MeshPolygonData::ReadDeformationSamples(const MObject& meshObject)
+{
+	if (!haveDeformation || (motionSamplesCount < 2))
+	{
+		return true;
+	}
+
+	size_t floatsVertexOneFrame = 3 * countVertices;
+	size_t floatsNormalOneFrame = 3 * countNormals;
+
+	MStatus status;
+	MFnDependencyNode meshNode(meshObject);
+	// mesh which can't be evaluated at sample time is rendered without deformation
+	auto useFirstSample = [&](unsigned int fromSampleIdx)
+	{
+		for (unsigned int sampleIdx = fromSampleIdx; sampleIdx < motionSamplesCount; ++sampleIdx)
+		{
+			std::copy(arrVertices.begin(), arrVertices.begin() + floatsVertexOneFrame, arrVertices.begin() + floatsVertexOneFrame * sampleIdx);
+			std::copy(arrNormals.begin(), arrNormals.begin() + floatsNormalOneFrame, arrNormals.begin() + floatsNormalOneFrame * sampleIdx);
+		}
+	};
+
+	MPlug outMeshPlug = meshNode.findPlug("outMesh", false, &status);
+	if (MStatus::kSuccess != status)
+	{
+		useFirstSample(1);
+		return true;
+	}
+
+	MTime initialTime = MAnimControl::currentTime();
+
+	for (unsigned int sampleIdx = 1; sampleIdx < motionSamplesCount; ++sampleIdx)
+	{
+		// samples are evenly distributed over one frame starting from current time
+		MTime sampleTime = initialTime + MTime((double)sampleIdx / (motionSamplesCount - 1), MTime::uiUnit());
+
+		float* pVertexDest = arrVertices.data() + floatsVertexOneFrame * sampleIdx;
+		float* pNormalDest = arrNormals.data() + floatsNormalOneFrame * sampleIdx;
+
+		// only deformation chain of this mesh is evaluated at sample time
+		MObject meshData;
+		{
+			MDGContext dgContext(sampleTime);
+			MDGContextGuard contextGuard(dgContext);
+			meshData = outMeshPlug.asMObject(&status);
+		}
+
+		MFnMesh sampleMesh(meshData, &status);
+		if (MStatus::kSuccess != status)
+		{
+			useFirstSample(sampleIdx);
+			return true;
+		}
+
+		MFloatPointArray points;
+		MFloatVectorArray normals;
+		sampleMesh.getPoints(points, MSpace::kObject);
+		sampleMesh.getNormals(normals, MSpace::kObject);
+
+		// topology should stay the same within a frame
+		if ((points.length() != countVertices) || (normals.length() != countNormals))
+		{
+			useFirstSample(sampleIdx);
+			return true;
+		}
+
+		for (unsigned int idx = 0; idx < points.length(); ++idx)
+		{
+			pVertexDest[idx * 3] = points[idx].x;
+			pVertexDest[idx * 3 + 1] = points[idx].y;
+			pVertexDest[idx * 3 + 2] = points[idx].z;
+		}
+
+		for (unsigned int idx = 0; idx < normals.length(); ++idx)
+		{
+			pNormalDest[idx * 3] = normals[idx].x;
+			pNormalDest[idx * 3 + 1] = normals[idx].y;
+			pNormalDest[idx * 3 + 2] = normals[idx].z;
+		}
+	}
+
+	return true;
+}
+
 bool FireMaya::MeshTranslator::PreProcessMesh(
 	MeshPolygonData& outMeshPolygonData,
 	const frw::Context& context,
@@ -329,6 +417,11 @@ bool FireMaya::MeshTranslator::PreProcessMesh(
 			object != originalObject ? 0 : deformationFrameCount,
 			fullDagPath
 		);
+
+		if (successfullyProcessed && outMeshPolygonData.haveDeformation)
+		{
+			successfullyProcessed = outMeshPolygonData.ReadDeformationSamples(originalObject);
+		}
 	}
 	else
 	{
@@ -364,10 +457,17 @@ std::vector<frw::Shape> FireMaya::MeshTranslator::TranslateMesh(
 	const frw::Context& context,
 	const MObject& originalObject,
 	std::vector<int>& outFaceMaterialIndices,
-	unsigned int deformationFrameCount, MString fullDagPath)
+	unsigned int deformationFrameCount, MString fullDagPath,
+	GeometryCache* geometryCache,
+	uint64_t* outGeometryHash)
 {
 	std::vector<frw::Shape> resultShapes;
 
+	if (outGeometryHash != nullptr)
+	{
+		*outGeometryHash = 0;
+	}
+
 	DebugPrint("TranslateMesh: %s", meshPolygonData.fullName.asUTF8());
 
 	outFaceMaterialIndices.clear();
@@ -406,8 +506,21 @@ std::vector<frw::Shape> FireMaya::MeshTranslator::TranslateMesh(
 		mayaStatus.perror("MFnMesh constructor");
 	}
 
+	// meshes with the same geometry as already translated one are instanced instead of uploading the same data again
+	// deforming meshes are not deduplicated because their geometry differs between motion samples
+	bool deduplicate = (geometryCache != nullptr) && !meshPolygonData.haveDeformation;
+	std::vector<unsigned char> geometryKey;
+	uint64_t geometryHash = deduplicate ? GetGeometryKey(fnMesh, meshPolygonData, geometryKey) : 0;
+
+	bool usesCachedGeometry = false;
+
+	if (deduplicate && geometryCache->Find(geometryHash, geometryKey, context, resultShapes, outFaceMaterialIndices))
+	{
+		DebugPrint("TranslateMesh: %s is instanced from identical mesh", meshPolygonData.fullName.asUTF8());
+		usesCachedGeometry = true;
+	}
 	// translate mesh
-	if (isRPR20)
+	else if (isRPR20)
 	{
 		resultShapes.resize(1);
 		SingleShaderMeshTranslator::TranslateMesh(
@@ -420,6 +533,16 @@ std::vector<frw::Shape> FireMaya::MeshTranslator::TranslateMesh(
 		MultipleShaderMeshTranslator::TranslateMesh(context, fnMesh, resultShapes, meshPolygonData, meshPolygonData.faceMaterialIndices);
 	}
 
+	if (deduplicate && !usesCachedGeometry)
+	{
+		usesCachedGeometry = geometryCache->Add(geometryHash, std::move(geometryKey), resultShapes, outFaceMaterialIndices, GetGeometryMemorySize(meshPolygonData));
+	}
+
+	if (usesCachedGeometry && (outGeometryHash != nullptr))
+	{
+		*outGeometryHash = geometryHash;
+	}
+
 	// Now remove any temporary mesh we created.
 	MFnDagNode node(originalObject);
 	if (!tessellated.isNull())
@@ -931,6 +1054,228 @@ void FireMaya::MeshTranslator::RemoveSmoothedTemporaryMesh(const MFnDagNode& nod
 		});
 }
 
+namespace
+{
+	const uint64_t GeometryHashSeed = 14695981039346656037ull;
+
+	// MurmurHash64A over whole buffer, 8 bytes per step; hash of previous buffers is used as seed
+	void HashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		const uint64_t mul = 0xc6a4a7935bd1e995ull;
+		const int shift = 47;
+
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		uint64_t h = hash ^ (size * mul);
+
+		const size_t blockCount = size / sizeof(uint64_t);
+		for (size_t blockIdx = 0; blockIdx < blockCount; ++blockIdx)
+		{
+			uint64_t k;
+			std::memcpy(&k, bytes + blockIdx * sizeof(uint64_t), sizeof(k));
+
+			k *= mul;
+			k ^= k >> shift;
+			k *= mul;
+
+			h ^= k;
+			h *= mul;
+		}
+
+		const unsigned char* tail = bytes + blockCount * sizeof(uint64_t);
+		const size_t tailSize = size % sizeof(uint64_t);
+		if (tailSize > 0)
+		{
+			uint64_t k = 0;
+			std::memcpy(&k, tail, tailSize);
+
+			h ^= k;
+			h *= mul;
+		}
+
+		h ^= h >> shift;
+		h *= mul;
+		h ^= h >> shift;
+
+		hash = h;
+	}
+
+	void AppendBytes(std::vector<unsigned char>& key, const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		key.insert(key.end(), bytes, bytes + size);
+	}
+
+	void AppendIntArray(std::vector<unsigned char>& key, const MIntArray& values)
+	{
+		unsigned int length = values.length();
+		AppendBytes(key, &length, sizeof(length));
+
+		size_t offset = key.size();
+		key.resize(offset + length * sizeof(int));
+		if (length > 0)
+		{
+			values.get(reinterpret_cast<int*>(key.data() + offset));
+		}
+	}
+}
+
+uint64_t FireMaya::MeshTranslator::GetGeometryKey(const MFnMesh& fnMesh, const MeshPolygonData& meshPolygonData, std::vector<unsigned char>& outKey)
+{
+	outKey.clear();
+	outKey.reserve(GetGeometryMemorySize(meshPolygonData));
+
+	// geometry data in object space
+	AppendBytes(outKey, &meshPolygonData.countVertices, sizeof(meshPolygonData.countVertices));
+	AppendBytes(outKey, meshPolygonData.GetVertices(), meshPolygonData.countVertices * 3 * sizeof(float));
+
+	AppendBytes(outKey, &meshPolygonData.countNormals, sizeof(meshPolygonData.countNormals));
+	AppendBytes(outKey, meshPolygonData.GetNormals(), meshPolygonData.countNormals * 3 * sizeof(float));
+
+	for (const std::vector<Float2>& uvCoords : meshPolygonData.uvCoords)
+	{
+		size_t uvCount = uvCoords.size();
+		AppendBytes(outKey, &uvCount, sizeof(uvCount));
+		AppendBytes(outKey, uvCoords.data(), uvCount * sizeof(Float2));
+	}
+
+	// topology
+	MIntArray counts;
+	MIntArray indices;
+
+	fnMesh.getVertices(counts, indices);
+	AppendIntArray(outKey, counts);
+	AppendIntArray(outKey, indices);
+
+	fnMesh.getNormalIds(counts, indices);
+	AppendIntArray(outKey, counts);
+	AppendIntArray(outKey, indices);
+
+	for (unsigned int uvSetIdx = 0; uvSetIdx < meshPolygonData.uvSetNames.length(); ++uvSetIdx)
+	{
+		MString uvSetName = meshPolygonData.uvSetNames[uvSetIdx];
+		fnMesh.getAssignedUVs(counts, indices, &uvSetName);
+		AppendIntArray(outKey, counts);
+		AppendIntArray(outKey, indices);
+	}
+
+	AppendIntArray(outKey, meshPolygonData.faceMaterialIndices);
+
+	// vertex colors
+	MColorArray vertexColors;
+	const_cast<MFnMesh&>(fnMesh).getVertexColors(vertexColors);
+
+	unsigned int colorCount = vertexColors.length();
+	AppendBytes(outKey, &colorCount, sizeof(colorCount));
+
+	std::vector<float> colors(colorCount * 4);
+	if (!colors.empty())
+	{
+		vertexColors.get(reinterpret_cast<float(*)[4]>(colors.data()));
+	}
+
+	AppendBytes(outKey, colors.data(), colors.size() * sizeof(float));
+
+	uint64_t hash = GeometryHashSeed;
+	HashBytes(hash, outKey.data(), outKey.size());
+
+	return hash;
+}
+
+size_t FireMaya::MeshTranslator::GetGeometryMemorySize(const MeshPolygonData& meshPolygonData)
+{
+	size_t uvSetCount = meshPolygonData.uvCoords.size();
+	size_t uvCount = uvSetCount > 0 ? meshPolygonData.uvCoords[0].size() : 0;
+
+	size_t size = 0;
+	size += meshPolygonData.countVertices * 3 * sizeof(float);
+	size += meshPolygonData.countNormals * 3 * sizeof(float);
+	size += uvSetCount * uvCount * sizeof(Float2);
+
+	// vertex, normal and uv indices per triangle vertex
+	size += meshPolygonData.triangleVertexIndicesCount * (2 + uvSetCount) * sizeof(int);
+
+	return size;
+}
+
+FireMaya::MeshTranslator::GeometryCache::GeometryCache()
+	: m_deduplicatedCount(0)
+	, m_savedBytes(0)
+{
+}
+
+bool FireMaya::MeshTranslator::GeometryCache::Find(uint64_t hash, const std::vector<unsigned char>& key, const frw::Context& context, std::vector<frw::Shape>& outShapes, std::vector<int>& outFaceMaterialIndices)
+{
+	auto it = m_entries.find(hash);
+	if (it == m_entries.end())
+		return false;
+
+	const Entry& entry = it->second;
+
+	// hash collision, the mesh is translated on its own
+	if (entry.key != key)
+		return false;
+
+	outShapes.clear();
+	outShapes.reserve(entry.shapes.size());
+	for (const frw::Shape& shape : entry.shapes)
+	{
+		outShapes.push_back(shape ? shape.CreateInstance(context) : frw::Shape());
+	}
+
+	outFaceMaterialIndices = entry.faceMaterialIndices;
+
+	it->second.userCount++;
+	m_deduplicatedCount++;
+	m_savedBytes += entry.memorySize;
+
+	return true;
+}
+
+bool FireMaya::MeshTranslator::GeometryCache::Add(uint64_t hash, std::vector<unsigned char>&& key, const std::vector<frw::Shape>& shapes, const std::vector<int>& faceMaterialIndices, size_t memorySize)
+{
+	// keep first translated shape as a source of instances
+	if (m_entries.count(hash) != 0)
+		return false;
+
+	Entry& entry = m_entries[hash];
+	entry.key = std::move(key);
+	entry.shapes = shapes;
+	entry.faceMaterialIndices = faceMaterialIndices;
+	entry.memorySize = memorySize;
+	entry.userCount = 1;
+
+	return true;
+}
+
+void FireMaya::MeshTranslator::GeometryCache::Release(uint64_t hash)
+{
+	auto it = m_entries.find(hash);
+	if (it == m_entries.end())
+		return;
+
+	// shapes stay alive while meshes using them hold references, the entry only stops new meshes from sharing them
+	if (--it->second.userCount == 0)
+	{
+		m_entries.erase(it);
+	}
+}
+
+void FireMaya::MeshTranslator::GeometryCache::Clear()
+{
+	m_entries.clear();
+	m_deduplicatedCount = 0;
+	m_savedBytes = 0;
+}
+
+void FireMaya::MeshTranslator::GeometryCache::PopStatistics(size_t& outDeduplicatedCount, size_t& outSavedBytes)
+{
+	outDeduplicatedCount = m_deduplicatedCount;
+	outSavedBytes = m_savedBytes;
+
+	m_deduplicatedCount = 0;
+	m_savedBytes = 0;
+}
+
 void FireMaya::MeshTranslator::GetUVCoords(
 	const MFnMesh& fnMesh,
 	MStringArray& uvSetNames,
@@ -19,6 +19,8 @@ limitations under the License.
 #include <maya/MObject.h>
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <string>
 
 namespace FireMaya
 {
@@ -56,6 +58,9 @@ namespace FireMaya
 			// Initializes mesh and returns error status
 			bool Initialize(MFnMesh& fnMesh, unsigned int deformationFrameCount, MString fullDagPath);
 			bool ReadDeformationFrame(MFnMesh& fnMesh, unsigned int currentDeformationFrame);
+
+			// Reads all motion samples after the first one by evaluating the mesh at sample times, current scene time is not changed
+			bool ReadDeformationSamples(const MObject& meshObject);
 			bool ProcessDeformationFrameCount(MFnMesh& fnMesh, MString fullDagPath);
 
 			size_t GetTotalVertexCount() const { return std::max(arrVertices.size() / 3, countVertices); }
@@ -116,8 +121,42 @@ namespace FireMaya
 			std::map<int, MColor> vertexColors;
 		};
 
+		// Shapes of already translated meshes keyed by hash of their geometry
+		// Used to turn identical (duplicated, not instanced) meshes into instances of one shape
+		// Each successful Find or Add is a use of the entry, released with Release when the mesh detaches
+		class GeometryCache
+		{
+		public:
+			GeometryCache();
+
+			// hash only selects the entry, geometry is shared only if the key (all translated data) is equal as well
+			bool Find(uint64_t hash, const std::vector<unsigned char>& key, const frw::Context& context, std::vector<frw::Shape>& outShapes, std::vector<int>& outFaceMaterialIndices);
+			bool Add(uint64_t hash, std::vector<unsigned char>&& key, const std::vector<frw::Shape>& shapes, const std::vector<int>& faceMaterialIndices, size_t memorySize);
+			void Release(uint64_t hash);
+			void Clear(void);
+
+			// Returns count of deduplicated meshes and memory saved since last call
+			void PopStatistics(size_t& outDeduplicatedCount, size_t& outSavedBytes);
+
+		private:
+			struct Entry
+			{
+				std::vector<unsigned char> key;
+				std::vector<frw::Shape> shapes;
+				std::vector<int> faceMaterialIndices;
+				size_t memorySize;
+				size_t userCount;
+			};
+
+			std::unordered_map<uint64_t, Entry> m_entries;
+
+			size_t m_deduplicatedCount;
+			size_t m_savedBytes;
+		};
+
 		static bool PreProcessMesh(MeshPolygonData& outMeshPolygonData, const frw::Context& context, const MObject& originalObject, unsigned int deformationFrameCount = 0, unsigned int currentDeformationFrame = 0, MString fullDagPath = "");
-		static std::vector<frw::Shape> TranslateMesh(MeshPolygonData& meshPolygonData, const frw::Context& context, const MObject& originalObject, std::vector<int>& outFaceMaterialIndices, unsigned int deformationFrameCount = 0, MString fullDagPath = "");
+		// outGeometryHash is set to the geometry cache entry used by the mesh (0 if none), it should be released when the mesh is detached
+		static std::vector<frw::Shape> TranslateMesh(MeshPolygonData& meshPolygonData, const frw::Context& context, const MObject& originalObject, std::vector<int>& outFaceMaterialIndices, unsigned int deformationFrameCount = 0, MString fullDagPath = "", GeometryCache* geometryCache = nullptr, uint64_t* outGeometryHash = nullptr);
 
 		static std::vector<frw::Shape> TranslateMesh(const frw::Context& context, const MObject& originalObject, std::vector<int>& outFaceMaterialIndices, unsigned int deformationFrameCount = 0, MString fullDagPath="");
 
@@ -142,6 +181,12 @@ namespace FireMaya
 
 		static MObject Smoothed2ndUV(const MObject& object, MStatus& status);
 
+		/** Key of translated geometry: positions, normals, uvs, topology, vertex colors and per face materials with their counts. Returns hash of the key. */
+		static uint64_t GetGeometryKey(const MFnMesh& fnMesh, const MeshPolygonData& meshPolygonData, std::vector<unsigned char>& outKey);
+
+		/** Estimate of memory used by translated geometry. */
+		static size_t GetGeometryMemorySize(const MeshPolygonData& meshPolygonData);
+
 		static void RemoveTesselatedTemporaryMesh(const MFnDagNode& node, MObject tessellated);
 		static void RemoveSmoothedTemporaryMesh(const MFnDagNode& node, MObject smoothed);
 
@@ -303,13 +303,6 @@ namespace FireMaya
 									double& outRotationAngle, 
 									unsigned int dagPathIndex)
 	{
-		// convert Maya mesh in cm to m
-		MMatrix scaleM;
-		scaleM.setToIdentity();
-		scaleM[0][0] = scaleM[1][1] = scaleM[2][2] = GetSceneUnitsConversionCoefficient();
-		MMatrix matrix = inMatrix;
-		matrix *= scaleM;
-
 		MTime nextTime = MAnimControl::currentTime();
 		MTime maxTime = MAnimControl::maxTime();
 
@@ -322,31 +315,47 @@ namespace FireMaya
 			matrixPlug = matrixPlug.elementByLogicalIndex(dagPathIndex);
 			matrixPlug.getValue(val, dgcontext);
 			MMatrix nextFrameMatrix = MFnMatrixData(val).matrix();
-			if (nextFrameMatrix != matrix)
-			{
-				MMatrix nextMatrix = nextFrameMatrix;
-				nextMatrix *= scaleM;
 
-				// get linear motion
-				outLinearMotion = MVector(nextMatrix[3][0] - matrix[3][0], nextMatrix[3][1] - matrix[3][1], nextMatrix[3][2] - matrix[3][2]);
+			CalculateMotionBlurParams(inMatrix, nextFrameMatrix, outLinearMotion, outAngularMotion, outRotationAngle);
+		}
+	}
 
-				MTransformationMatrix transformationMatrix(matrix);
-				MQuaternion currentRotation = transformationMatrix.rotation();
+	void CalculateMotionBlurParams(const MMatrix& inMatrix,
+									const MMatrix& inNextFrameMatrix,
+									MVector& outLinearMotion,
+									MVector& outAngularMotion,
+									double& outRotationAngle)
+	{
+		if (inNextFrameMatrix == inMatrix)
+			return;
 
-				MTransformationMatrix transformationMatrixNext(nextMatrix);
-				MQuaternion nextRotation = transformationMatrixNext.rotation();
+		// convert Maya mesh in cm to m
+		MMatrix scaleM;
+		scaleM.setToIdentity();
+		scaleM[0][0] = scaleM[1][1] = scaleM[2][2] = GetSceneUnitsConversionCoefficient();
+		MMatrix matrix = inMatrix;
+		matrix *= scaleM;
 
-				MQuaternion dispRotation = currentRotation.inverse() * nextRotation;
+		MMatrix nextMatrix = inNextFrameMatrix;
+		nextMatrix *= scaleM;
 
-				dispRotation.getAxisAngle(outAngularMotion, outRotationAngle);
+		// get linear motion
+		outLinearMotion = MVector(nextMatrix[3][0] - matrix[3][0], nextMatrix[3][1] - matrix[3][1], nextMatrix[3][2] - matrix[3][2]);
 
-				if (outRotationAngle > PI)
-				{
-					outRotationAngle -= 2 * PI;
-				}
-			}
-		}
+		MTransformationMatrix transformationMatrix(matrix);
+		MQuaternion currentRotation = transformationMatrix.rotation();
+
+		MTransformationMatrix transformationMatrixNext(nextMatrix);
+		MQuaternion nextRotation = transformationMatrixNext.rotation();
+
+		MQuaternion dispRotation = currentRotation.inverse() * nextRotation;
 
+		dispRotation.getAxisAngle(outAngularMotion, outRotationAngle);
+
+		if (outRotationAngle > PI)
+		{
+			outRotationAngle -= 2 * PI;
+		}
 	}
 
 	bool translateLight(FrLight& frlight, Scope& scope, frw::Context frcontext, const MObject& object, const MMatrix& matrix, bool update)
@@ -1080,8 +1089,8 @@ namespace FireMaya
 			envLight = frcontext.CreateEnvironmentLight();
 		}
 
-		// Update the sky image.
-		if (skyBuilder.refresh())
+		// Update the sky image, a low resolution preview is replaced once the full image is ready.
+		if (skyBuilder.refresh() || skyBuilder.isPreview())
 		{
 			skyBuilder.updateImage(frcontext, frImage);
 
@@ -139,6 +139,13 @@ namespace FireMaya
 									double& outRotationAngle,
 									unsigned int dagPathIndex = 0);
 
+	// Motion blur params from object matrices at current and next frame (in scene units)
+	void CalculateMotionBlurParams(const MMatrix& inMatrix,
+									const MMatrix& inNextFrameMatrix,
+									MVector& outLinearMotion,
+									MVector& outAngularMotion,
+									double& outRotationAngle);
+
 	template<typename T,
 		// Enable this function for floating point types only
 		class = std::enable_if_t<std::is_floating_point<T>::value>>
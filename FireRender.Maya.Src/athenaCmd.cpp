@@ -12,6 +12,7 @@ limitations under the License.
 ********************************************************************/
 #include "athenaCmd.h"
 #include "Athena/athenaWrap.h"
+#include "TelemetrySpool.h"
 
 AthenaEnableCmd::AthenaEnableCmd()
 {}
@@ -48,6 +49,9 @@ MStatus AthenaEnableCmd::doIt(const MArgList & args)
 
 	AthenaWrapper::GetAthenaWrapper()->SetEnabled(enableAthena);
 
+	// records are kept locally before sending, so opting out must stop spooling as well
+	TelemetrySpool::SetEnabled(enableAthena);
+
 	return MS::kSuccess;
 }
 
@@ -917,6 +917,7 @@ namespace frw
 			std::vector<Object> shaders;
 			Object volumeShader;
 			Object displacementShader;
+			Object instanceSource; // mesh this shape is an instance of
 			virtual ~Data();
 
 			bool isAreaLight = false;
@@ -3974,11 +3975,15 @@ namespace frw
 	inline Shape Shape::CreateInstance(Context context) const
 	{
 		FRW_PRINT_DEBUG("CreateInstance()");
+		// instances can't be instanced, so instances of an instance share its source mesh
+		Object source = data().instanceSource ? data().instanceSource : static_cast<const Object&>(*this);
+
 		rpr_shape h = nullptr;
-		auto res = rprContextCreateInstance(context.Handle(), Handle(), &h);
+		auto res = rprContextCreateInstance(context.Handle(), source.Handle(), &h);
 		checkStatus(res);
 		Shape shape(h, context);
-		shape.AddReference(*this);
+		shape.AddReference(source);
+		shape.data().instanceSource = source;
 		return shape;
 	}
 
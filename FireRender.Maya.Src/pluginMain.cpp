@@ -36,6 +36,7 @@ limitations under the License.
 #include "FireRenderGlobals.h"
 #include "FireRenderCmd.h"
 #include "FireRenderLocationCmd.h"
+#include "FireRenderShaderCacheCmd.h"
 #include "EnableSaveIntermediateCmd.h"
 #include "FireRenderIBL.h"
 #include "FireRenderSkyLocator.h"
@@ -94,6 +95,10 @@ limitations under the License.
 
 #include "GLTFTranslator.h"
 #include "StartupContextChecker.h"
+#include "BakedTextureCache.h"
+#include "Context/ContextPool.h"
+#include "RenderStats.h"
+#include "TelemetrySpool.h"
 
 #ifdef _WIN32
 #pragma warning( disable : 4091 )
@@ -199,6 +204,7 @@ void mayaExiting(void* data)
 	DebugPrint("mayaExiting");
 	gExitingMaya = true;
 
+	TelemetrySpool::Stop();
 	AthenaWrapper::GetAthenaWrapper()->Finalize();
 
     // Clear ViewportManager. It should be cleared before maya destroys OpenGL context
@@ -521,6 +527,19 @@ void AddExtensionAttributesCommon()
 		lightClass.addExtensionAttribute(lightGroupAttr);
 	}
 
+	/// Add light culling override to light nodes
+	MString cullableLightClassNames[] = { "RPRPhysicalLight", "RPRIES", "pointLight", "spotLight", "areaLight", "volumeLight" };
+
+	for (MString className : cullableLightClassNames)
+	{
+		MNodeClass lightClass(className);
+
+		MObject alwaysKeepAttr = nAttr.create("RPRAlwaysKeepLight", "rakl", MFnNumericData::kBoolean, false);
+		nAttr.setNiceNameOverride("RPR Always Keep Light");
+
+		lightClass.addExtensionAttribute(alwaysKeepAttr);
+	}
+
 	/// Add emitter attribute to locator node
 	MNodeClass locatorClass("locator");
 
@@ -626,13 +645,35 @@ MStatus initializePlugin(MObject obj)
 
 	glewInit();
 
+	// number of idle rpr contexts kept alive per render type/device combination, pooling is off by default
+	if (const char* poolSize = std::getenv("RPR_MAYA_CONTEXT_POOL_SIZE"))
+	{
+		ContextPool::SetCapacity((size_t)std::max(0, atoi(poolSize)));
+	}
+
+	// size limit of the baked procedural texture cache in megabytes, 0 disables the limit
+	if (const char* bakedTextureCacheSize = std::getenv("RPR_BAKED_TEXTURE_CACHE_SIZE_MB"))
+	{
+		BakedTextureCache::SetMaxSize((uint64_t)std::max(0, atoi(bakedTextureCacheSize)) * 1024 * 1024);
+	}
+
+	// per frame timings and counters for farm analytics, also set with fireRender -renderStats
+	if (const char* statsPath = std::getenv("RPR_MAYA_RENDER_STATS_PATH"))
+	{
+		RenderStats::SetOutputFolder(statsPath);
+	}
+
 	StartupContextChecker::CheckContexts();
 	if (!StartupContextChecker::IsRprSupported())
 	{
 		return MStatus::kFailure;
 	}
 
-	if (!StartupContextChecker::IsMLDenoiserSupportedCPU())
+	// render telemetry is written to a local spool first and sent from a background thread
+	TelemetrySpool::Start(getTelemetrySpoolPath().asUTF8());
+
+	// if the check is still running it reports the result when done
+	if (!StartupContextChecker::IsMLDenoiserCheckPending() && !StartupContextChecker::IsMLDenoiserSupportedCPU())
 	{
 		MGlobal::displayWarning("Machine learning denoiser is not supported by current CPU");
 	}
@@ -674,6 +715,7 @@ MStatus initializePlugin(MObject obj)
 	CHECK_MSTATUS(plugin.registerCommand("fireRenderImport", FireRenderImportCmd::creator, FireRenderImportCmd::newSyntax));
 	CHECK_MSTATUS(plugin.registerCommand("fireRenderLocation", FireRenderLocationCmd::creator, FireRenderLocationCmd::newSyntax));
 	CHECK_MSTATUS(plugin.registerCommand("fireRenderConvertVRay", FireRenderConvertVRayCmd::creator, FireRenderConvertVRayCmd::newSyntax));
+	CHECK_MSTATUS(plugin.registerCommand("fireRenderShaderCache", FireRenderShaderCacheCmd::creator, FireRenderShaderCacheCmd::newSyntax));
 	CHECK_MSTATUS(plugin.registerCommand("athenaEnable", AthenaEnableCmd::creator, AthenaEnableCmd::newSyntax));
 
 	CHECK_MSTATUS(plugin.registerCommand("enableSaveIntermediate", EnableSaveIntermediateCmd::creator, EnableSaveIntermediateCmd::newSyntax));
@@ -757,7 +799,8 @@ MStatus initializePlugin(MObject obj)
 	openSceneCallback = MSceneMessage::addCallback(MSceneMessage::kAfterOpen, checkFireRenderGlobals, NULL, &status);
 	CHECK_MSTATUS(status);
 
-	auto mlDenoiserSupportedCPU = static_cast<int>(StartupContextChecker::IsMLDenoiserSupportedCPU());
+	// assume the ML denoiser is supported until the background check completes
+	auto mlDenoiserSupportedCPU = StartupContextChecker::IsMLDenoiserCheckPending() ? 1 : static_cast<int>(StartupContextChecker::IsMLDenoiserSupportedCPU());
 	MString mlSupportCPU = MString(std::to_string(mlDenoiserSupportedCPU).c_str());
 
 	MString registerCmd = MString("registerFireRender(" + mlSupportCPU + ")");
@@ -992,14 +1035,18 @@ MStatus uninitializePlugin(MObject obj)
 	MFnPlugin plugin(obj);
 
 	FireRenderViewportManager::instance().clear();
+	StartupContextChecker::WaitForPendingChecks();
+	FireRenderThread::RunOnceProcAndWait([]() { ContextPool::Clear(); });
 	FireRenderThread::RunTheThread(false);
 	std::this_thread::yield();
+	TelemetrySpool::Stop();
 
 	CHECK_MSTATUS(plugin.deregisterCommand("fireRender"));
 	CHECK_MSTATUS(plugin.deregisterCommand("fireRenderViewport"));
 	CHECK_MSTATUS(plugin.deregisterCommand("fireRenderExport"));
 	CHECK_MSTATUS(plugin.deregisterCommand("fireRenderImport"));
 	CHECK_MSTATUS(plugin.deregisterCommand("fireRenderConvertVRay"));
+	CHECK_MSTATUS(plugin.deregisterCommand("fireRenderShaderCache"));
 
 	CHECK_MSTATUS(plugin.deregisterCommand("enableSaveIntermediate"));
 